@@ -0,0 +1,135 @@
+/*!
+  ******************************************************************************
+  * @file    batch.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Benchmark for batch autocompletion on thread pools of increasing size.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+// We use sysconf.
+// This function is a POSIX extension, not in C.
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/pool.h"
+#include "t9/timer.h"
+#include "t9/tree.h"
+
+#include "common.h"
+
+int main(int argc, char **argv) {
+    const char *corpus_file;
+    t9_model_t *model;
+    t9_symbol_t **sequences;
+    t9_symbol_t **suggestions;
+    t9_pool_t *pool;
+    size_t count;
+    size_t keys;
+    size_t i;
+    long max_threads;
+    long threads;
+    double start;
+    double duration;
+    double baseline;
+
+    corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    count = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 1000;
+    max_threads = argc > 3 ? strtol(argv[3], NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    model = bench_model_create(corpus_file, 0);
+    if (model == NULL) {
+        fprintf(stderr, "Error: Could not build a model on corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    sequences = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    suggestions = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    if (sequences == NULL || suggestions == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    count = bench_make_sequences(&model->corpus, 0, count, sequences);
+
+    keys = 0;
+    for (i = 0; i < count; i++) {
+        keys += strlen((const char *) sequences[i]);
+    }
+
+    printf("threads,sequences,keys,duration_ms,sequences_per_second,speedup\n");
+    baseline = 0.0;
+    threads = 1;
+    while (true) {
+        pool = t9_pool_create((uint16_t) threads);
+        if (pool == NULL) {
+            fprintf(stderr, "Error: Could not create a pool of %ld threads.\n", threads);
+            return EXIT_FAILURE;
+        }
+
+        start = t9_timer_now_ms();
+        if (t9_model_autocomplete_batch(model, (const t9_symbol_t *const *) sequences, count,
+                                        suggestions, pool) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Batch completion failed.\n");
+            return EXIT_FAILURE;
+        }
+        duration = t9_timer_now_ms() - start;
+        t9_pool_destroy(pool);
+
+        for (i = 0; i < count; i++) {
+            free(suggestions[i]);
+        }
+
+        if (threads == 1) {
+            baseline = duration;
+        }
+        printf("%ld,%zu,%zu,%.2f,%.1f,%.2f\n", threads, count, keys, duration,
+               (double) count / (duration / 1000.0), baseline / duration);
+
+        if (threads == max_threads) {
+            break;
+        }
+        // Double the number of threads, but always finish with the maximum.
+        threads = threads * 2 > max_threads ? max_threads : threads * 2;
+    }
+
+    for (i = 0; i < count; i++) {
+        free(sequences[i]);
+    }
+    free(sequences);
+    free(suggestions);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
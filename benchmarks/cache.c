@@ -0,0 +1,207 @@
+/*!
+  ******************************************************************************
+  * @file    cache.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Benchmark for the hit rate of the cache of decoder states.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "t9/cache.h"
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/session.h"
+#include "t9/timer.h"
+
+#include "common.h"
+
+// Capacities of the cache benchmarked in bytes, 0 decodes every request from scratch.
+static const size_t bench_capacities[] = {0, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+
+/*!
+ * Decode the requests of stateless clients, which resubmit the whole word typed so far with every keystroke, one
+ * after the other with a single session. Without a cache, every request is decoded from scratch.
+ * @return Duration in milliseconds, a negative value if decoding failed.
+ */
+static double
+bench_decode(const t9_model_t *const model,
+             t9_session_t *const session,
+             t9_cache_t *const cache,
+             t9_symbol_t **requests,
+             size_t count,
+             t9_symbol_t **suggestions) {
+    size_t number;
+    size_t stride;
+    size_t i;
+    float score;
+    double start;
+    t9_error_t error;
+
+    start = t9_timer_now_ms();
+    for (i = 0; i < count; i++) {
+        stride = strlen((const char *) requests[i]) + 1;
+        if (cache != NULL) {
+            error = t9_cache_type(cache, session, requests[i], 0);
+            if (error == T9_SUCCESS) {
+                error = t9_session_nbest(session, suggestions[i], stride, &score, 1, &number);
+            }
+        } else {
+            error = t9_model_autocomplete_nbest(model, session, requests[i], suggestions[i], stride, &score, 1,
+                                                &number);
+        }
+        if (error != T9_SUCCESS) {
+            return -1.0;
+        }
+    }
+    return t9_timer_now_ms() - start;
+}
+
+int main(int argc, char **argv) {
+    const char *corpus_file;
+    t9_model_t *model;
+    t9_session_t *session;
+    t9_cache_t *cache;
+    t9_cache_stats_t stats;
+    t9_symbol_t **words;
+    t9_symbol_t **requests;
+    t9_symbol_t **expected;
+    t9_symbol_t **suggestions;
+    size_t number_words;
+    size_t count;
+    size_t keys;
+    size_t mismatches;
+    size_t capacity;
+    size_t i;
+    size_t j;
+    double baseline;
+    double duration;
+
+    corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    number_words = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 2000;
+
+    model = bench_model_create(corpus_file, 0);
+    if (model == NULL) {
+        fprintf(stderr, "Error: Could not build a model on corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+    // Decode like a server would, with recombination and a beam threshold.
+    model->paths_per_context = 1;
+    model->beam_threshold = 10.0f;
+
+    // Every word of the test corpus is typed key by key, each keystroke is a request of its own.
+    words = (t9_symbol_t **) calloc(number_words, sizeof(t9_symbol_t *));
+    if (words == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    number_words = bench_make_sequences(&model->corpus, 0, number_words, words);
+    keys = 0;
+    for (i = 0; i < number_words; i++) {
+        keys += strlen((const char *) words[i]);
+    }
+
+    requests = (t9_symbol_t **) calloc(keys, sizeof(t9_symbol_t *));
+    expected = (t9_symbol_t **) calloc(keys, sizeof(t9_symbol_t *));
+    suggestions = (t9_symbol_t **) calloc(keys, sizeof(t9_symbol_t *));
+    session = t9_session_create(model);
+    if (requests == NULL || expected == NULL || suggestions == NULL || session == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    count = 0;
+    for (i = 0; i < number_words; i++) {
+        for (j = 1; j <= strlen((const char *) words[i]); j++) {
+            requests[count] = (t9_symbol_t *) calloc(j + 1, sizeof(t9_symbol_t));
+            expected[count] = (t9_symbol_t *) calloc(j + 1, sizeof(t9_symbol_t));
+            suggestions[count] = (t9_symbol_t *) calloc(j + 1, sizeof(t9_symbol_t));
+            if (requests[count] == NULL || expected[count] == NULL || suggestions[count] == NULL) {
+                fprintf(stderr, "Error: Out of memory.\n");
+                return EXIT_FAILURE;
+            }
+            memcpy(requests[count], words[i], j);
+            count++;
+        }
+        free(words[i]);
+    }
+    free(words);
+
+    baseline = bench_decode(model, session, NULL, requests, count, expected);
+    if (baseline < 0.0) {
+        fprintf(stderr, "Error: Decoding failed.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("capacity,requests,hits,misses,hit_rate,evictions,entries,memory,duration_ms,speedup,mismatches\n");
+    printf("0,%zu,0,%zu,0.000,0,0,0,%.2f,1.00,0\n", count, count, baseline);
+    for (i = 1; i < sizeof(bench_capacities) / sizeof(bench_capacities[0]); i++) {
+        capacity = bench_capacities[i];
+        cache = t9_cache_create(capacity);
+        if (cache == NULL) {
+            fprintf(stderr, "Error: Could not create a cache of %zu bytes.\n", capacity);
+            return EXIT_FAILURE;
+        }
+
+        duration = bench_decode(model, session, cache, requests, count, suggestions);
+        if (duration < 0.0) {
+            fprintf(stderr, "Error: Decoding with a cache of %zu bytes failed.\n", capacity);
+            return EXIT_FAILURE;
+        }
+
+        // Resuming from a cached prefix has to give the suggestions of decoding from scratch.
+        mismatches = 0;
+        for (j = 0; j < count; j++) {
+            if (strcmp((const char *) expected[j], (const char *) suggestions[j]) != 0) {
+                mismatches++;
+            }
+        }
+
+        t9_cache_stats(cache, &stats);
+        printf("%zu,%zu,%lu,%lu,%.3f,%lu,%zu,%zu,%.2f,%.2f,%zu\n", capacity, count, (unsigned long) stats.hits,
+               (unsigned long) stats.misses, (double) stats.hits / (double) (stats.hits + stats.misses),
+               (unsigned long) stats.evictions, stats.number_entries, stats.memory, duration, baseline / duration,
+               mismatches);
+        t9_cache_destroy(cache);
+    }
+
+    for (i = 0; i < count; i++) {
+        free(requests[i]);
+        free(expected[i]);
+        free(suggestions[i]);
+    }
+    free(requests);
+    free(expected);
+    free(suggestions);
+    t9_session_destroy(session);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
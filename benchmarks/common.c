@@ -0,0 +1,105 @@
+/*!
+  ******************************************************************************
+  * @file    common.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Model and key sequences shared by the benchmarks.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "common.h"
+
+t9_model_t *
+bench_model_create(const char *const corpus_file,
+                   size_t test_limit) {
+    t9_model_t *model;
+
+    model = t9_model_create();
+    if (model == NULL) {
+        return NULL;
+    }
+
+    if (t9_corpus_load(corpus_file, 0, corpus_file, test_limit, &model->corpus) != T9_SUCCESS) {
+        t9_model_destroy(model);
+        return NULL;
+    }
+    model->ngram_length = BENCH_NGRAM_LENGTH;
+    model->number_paths = BENCH_NUMBER_PATHS;
+
+    // Build a corpus tree.
+    model->corpus_tree = t9_corpus_tree_create();
+    if (model->corpus_tree == NULL
+        || t9_corpus_tree_insert_ngrams(model->corpus_tree, &model->corpus, model->ngram_length) != T9_SUCCESS) {
+        t9_model_destroy(model);
+        return NULL;
+    }
+    t9_corpus_tree_finalize(model->corpus_tree);
+
+    return model;
+}
+
+size_t
+bench_make_sequences(const corpus_t *const corpus,
+                     size_t length,
+                     size_t count,
+                     t9_symbol_t **sequences) {
+    size_t offset;
+    size_t size;
+    size_t made;
+
+    made = 0;
+    offset = 0;
+    while (made < count && offset < corpus->test_buffer_size) {
+        if (length == 0) {
+            // Take the word at the offset.
+            size = 0;
+            while (offset + size < corpus->test_buffer_size && corpus->test_buffer[offset + size] != ' ') {
+                size++;
+            }
+        } else if (offset + length <= corpus->test_buffer_size) {
+            size = length;
+        } else {
+            break;
+        }
+
+        if (size > 0) {
+            if (t9_corpus_lexicon_from_corpus(&corpus->test_buffer[offset], size, &sequences[made]) != T9_SUCCESS) {
+                break;
+            }
+            made++;
+        }
+
+        // Continue with the next word.
+        offset += size;
+        while (offset < corpus->test_buffer_size && corpus->test_buffer[offset] != ' ') {
+            offset++;
+        }
+        offset++;
+    }
+    return made;
+}
@@ -0,0 +1,77 @@
+/*!
+  ******************************************************************************
+  * @file    common.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for common.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_BENCH_COMMON_H
+#define C_T9_BENCH_COMMON_H
+
+#include <stddef.h>
+
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/tree.h"
+
+// Decoding parameters of the benchmarked model.
+#define BENCH_NGRAM_LENGTH 3
+#define BENCH_NUMBER_PATHS 15
+
+/*!
+ * Create the model all benchmarks decode with. The corpus is used as train and test data, the corpus tree is built
+ * with BENCH_NGRAM_LENGTH and the model decodes BENCH_NUMBER_PATHS paths.
+ * @note The user is responsible for destroying the model using t9_model_destroy once it is no longer required.
+ * @param corpus_file Path of the corpus.
+ * @param test_limit Maximal number of symbols of the test data, 0 for all.
+ * @return Pointer to the new model, NULL if an error occurred.
+ */
+t9_model_t *
+bench_model_create(const char *const corpus_file,
+                   size_t test_limit);
+
+/*!
+ * Convert the test corpus into key sequences, each starting at the beginning of a word.
+ * With a length of 0 every word is a sequence of its own, as typed by users entering single words. Otherwise the
+ * sequences are cut to a fixed number of symbols, continuing with the next word.
+ * @note The user is responsible for freeing the sequences once they are no longer required.
+ * @param corpus Pointer to a loaded corpus.
+ * @param length Number of symbols of a sequence, 0 for single words.
+ * @param count Maximal number of sequences.
+ * @param sequences Array of at least count pointers, the new sequences are placed in.
+ * @return Number of sequences made.
+ */
+size_t
+bench_make_sequences(const corpus_t *const corpus,
+                     size_t length,
+                     size_t count,
+                     t9_symbol_t **sequences);
+
+#endif //C_T9_BENCH_COMMON_H
@@ -0,0 +1,181 @@
+/*!
+  ******************************************************************************
+  * @file    concurrency.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Stress benchmark for many sessions decoding concurrently on one shared model.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+// We use sysconf.
+// This function is a POSIX extension, not in C.
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/session.h"
+#include "t9/timer.h"
+#include "t9/tree.h"
+
+#include "common.h"
+
+/*!
+ * Work description of a single benchmark thread.
+ */
+struct struct_bench_worker_t {
+    pthread_t thread;
+    const t9_model_t *model;
+    t9_symbol_t **sequences;
+    size_t first;
+    size_t stride;
+    size_t count;
+    size_t keys;
+    t9_error_t error;
+};
+
+typedef struct struct_bench_worker_t bench_worker_t;
+
+static void *
+bench_worker_run(void *arg) {
+    bench_worker_t *worker;
+    t9_session_t *session;
+    t9_symbol_t *suggestion;
+    size_t i;
+
+    worker = (bench_worker_t *) arg;
+    worker->error = T9_SUCCESS;
+    worker->keys = 0;
+
+    // Every thread decodes with its own session against the shared model.
+    session = t9_session_create(worker->model);
+    if (session == NULL) {
+        worker->error = T9_FAILURE;
+        return NULL;
+    }
+
+    for (i = worker->first; i < worker->count; i += worker->stride) {
+        if (t9_session_reset(session) != T9_SUCCESS
+            || t9_session_type(session, worker->sequences[i]) != T9_SUCCESS
+            || t9_session_suggestion(session, &suggestion) != T9_SUCCESS) {
+            worker->error = T9_FAILURE;
+            break;
+        }
+        worker->keys += strlen((const char *) worker->sequences[i]);
+        free(suggestion);
+    }
+
+    t9_session_destroy(session);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *corpus_file;
+    t9_model_t *model;
+    t9_symbol_t **sequences;
+    bench_worker_t *workers;
+    size_t count;
+    size_t keys;
+    size_t i;
+    long max_threads;
+    long threads;
+    double start;
+    double duration;
+    double baseline;
+
+    corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    count = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 100;
+    max_threads = argc > 3 ? strtol(argv[3], NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    model = bench_model_create(corpus_file, 0);
+    if (model == NULL) {
+        fprintf(stderr, "Error: Could not build a model on corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    sequences = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    workers = (bench_worker_t *) calloc((size_t) max_threads, sizeof(bench_worker_t));
+    if (sequences == NULL || workers == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    count = bench_make_sequences(&model->corpus, 12, count, sequences);
+
+    printf("threads,sequences,keys,duration_ms,keys_per_second,speedup\n");
+    baseline = 0.0;
+    threads = 1;
+    while (true) {
+        start = t9_timer_now_ms();
+        for (i = 0; i < (size_t) threads; i++) {
+            workers[i].model = model;
+            workers[i].sequences = sequences;
+            workers[i].first = i;
+            workers[i].stride = (size_t) threads;
+            workers[i].count = count;
+            pthread_create(&workers[i].thread, NULL, bench_worker_run, &workers[i]);
+        }
+
+        keys = 0;
+        for (i = 0; i < (size_t) threads; i++) {
+            pthread_join(workers[i].thread, NULL);
+            if (workers[i].error != T9_SUCCESS) {
+                fprintf(stderr, "Error: Decoding failed in thread %zu.\n", i);
+                return EXIT_FAILURE;
+            }
+            keys += workers[i].keys;
+        }
+        duration = t9_timer_now_ms() - start;
+
+        if (threads == 1) {
+            baseline = duration;
+        }
+        printf("%ld,%zu,%zu,%.2f,%.1f,%.2f\n", threads, count, keys, duration,
+               (double) keys / (duration / 1000.0), baseline / duration);
+
+        if (threads == max_threads) {
+            break;
+        }
+        // Double the number of threads, but always finish with the maximum.
+        threads = threads * 2 > max_threads ? max_threads : threads * 2;
+    }
+
+    for (i = 0; i < count; i++) {
+        free(sequences[i]);
+    }
+    free(sequences);
+    free(workers);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,538 @@
+/*!
+  ******************************************************************************
+  * @file    generate.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Generator of synthetic corpora and keystroke workloads for scaling benchmarks.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+// We use getopt_long and qsort_r.
+// These functions are GNU extensions, not in C.
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "t9/corpus.h"
+#include "t9/io.h"
+
+// Maximal length of a generated word.
+#define GENERATE_MAX_WORD_LENGTH 32
+
+// Mean number of words per sentence.
+#define GENERATE_SENTENCE_WORDS 12
+
+// Probability of a comma after a word that does not end a sentence.
+#define GENERATE_COMMA_PROBABILITY 0.05
+
+/*!
+ * Options of the generator.
+ */
+struct struct_generate_options_t {
+    const char *out;
+    const char *keys;
+    const char *truth;
+    const char *alphabet;
+    uint64_t size;
+    size_t vocabulary;
+    double zipf;
+    double capitals;
+    double word_length;
+    uint64_t seed;
+    size_t sequences;
+    size_t length;
+    int prefixes;
+};
+
+typedef struct struct_generate_options_t generate_options_t;
+
+/*!
+ * State of the generator: random numbers, the alphabet distribution and the vocabulary ranked by frequency.
+ */
+struct struct_generate_t {
+    uint64_t random;
+    t9_symbol_t symbols[NUM_CORPUS_SYMBOLS];
+    double symbol_cdf[NUM_CORPUS_SYMBOLS];
+    size_t number_symbols;
+    char *words;
+    size_t *offsets;
+    double *rank_cdf;
+    size_t number_words;
+};
+
+typedef struct struct_generate_t generate_t;
+
+// Relative frequencies of the letters a to z in English text.
+static const double generate_english[26] = {
+        8.17, 1.49, 2.78, 4.25, 12.70, 2.23, 2.02, 6.09, 6.97, 0.15, 0.77, 4.03, 2.41,
+        6.75, 7.51, 1.93, 0.10, 5.99, 6.33, 9.06, 2.76, 0.98, 2.36, 0.15, 1.97, 0.07
+};
+
+/*!
+ * Draw 64 random bits (xorshift64*). The generator is seeded, so every output can be reproduced.
+ */
+static uint64_t
+generate_next(generate_t *const generate) {
+    generate->random ^= generate->random >> 12;
+    generate->random ^= generate->random << 25;
+    generate->random ^= generate->random >> 27;
+    return generate->random * UINT64_C(2685821657736338717);
+}
+
+/*!
+ * Draw a uniform random number in [0, 1).
+ */
+static double
+generate_uniform(generate_t *const generate) {
+    uint64_t bits;
+
+    bits = generate_next(generate) >> 11;
+    return (double) bits / 9007199254740992.0;
+}
+
+/*!
+ * Draw the index of a cumulative distribution.
+ */
+static size_t
+generate_sample(generate_t *const generate, const double *const cdf, size_t count) {
+    double target;
+    size_t low;
+    size_t high;
+    size_t middle;
+
+    target = generate_uniform(generate) * cdf[count - 1];
+    low = 0;
+    high = count - 1;
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (cdf[middle] <= target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*!
+ * Set up the distribution of the symbols words are made of: "uniform" over all of them, "english" letter
+ * frequencies, or the frequencies counted in a text file.
+ */
+static int
+generate_alphabet(generate_t *const generate, const char *const alphabet) {
+    const char *const corpus_symbols = CORPUS_SYMBOLS;
+    double frequencies[256];
+    t9_symbol_t *buffer;
+    size_t size;
+    size_t i;
+    double total;
+
+    memset(frequencies, 0, sizeof(frequencies));
+    if (strcmp(alphabet, "uniform") == 0) {
+        for (i = 0; corpus_symbols[i] != '\0'; i++) {
+            frequencies[(unsigned char) corpus_symbols[i]] = 1.0;
+        }
+    } else if (strcmp(alphabet, "english") == 0) {
+        for (i = 0; i < 26; i++) {
+            frequencies['a' + i] = generate_english[i];
+        }
+    } else {
+        if (t9_read_file(alphabet, &size, &buffer, 0) != T9_SUCCESS) {
+            return 0;
+        }
+        for (i = 0; i < size; i++) {
+            frequencies[buffer[i]] += 1.0;
+        }
+        free(buffer);
+    }
+
+    // Spaces and punctuation separate words, they are not part of them.
+    total = 0.0;
+    generate->number_symbols = 0;
+    for (i = 0; corpus_symbols[i] != '\0'; i++) {
+        if (strchr(" .,", corpus_symbols[i]) != NULL || frequencies[(unsigned char) corpus_symbols[i]] <= 0.0) {
+            continue;
+        }
+        total += frequencies[(unsigned char) corpus_symbols[i]];
+        generate->symbols[generate->number_symbols] = (t9_symbol_t) corpus_symbols[i];
+        generate->symbol_cdf[generate->number_symbols] = total;
+        generate->number_symbols++;
+    }
+    return generate->number_symbols > 0;
+}
+
+static int
+generate_compare_length(const void *a, const void *b, void *arg) {
+    const char *const words = (const char *) arg;
+    const size_t x = strlen(&words[*(const size_t *) a]);
+    const size_t y = strlen(&words[*(const size_t *) b]);
+
+    return (x > y) - (x < y);
+}
+
+/*!
+ * Generate the vocabulary and the Zipfian distribution of its ranks. Shorter words are ranked first, as frequent
+ * words tend to be short. Words may repeat, which merges their frequencies.
+ */
+static int
+generate_vocabulary(generate_t *const generate, const generate_options_t *const options) {
+    size_t length;
+    size_t trials;
+    size_t i;
+    size_t j;
+    double total;
+
+    generate->number_words = options->vocabulary;
+    generate->words = (char *) calloc(options->vocabulary, GENERATE_MAX_WORD_LENGTH + 1);
+    generate->offsets = (size_t *) calloc(options->vocabulary, sizeof(size_t));
+    generate->rank_cdf = (double *) calloc(options->vocabulary, sizeof(double));
+    if (generate->words == NULL || generate->offsets == NULL || generate->rank_cdf == NULL) {
+        return 0;
+    }
+
+    // The word length is binomial with the requested mean, but at least one symbol.
+    trials = (size_t) ((options->word_length - 1.0) * 2.0 + 0.5);
+    for (i = 0; i < options->vocabulary; i++) {
+        generate->offsets[i] = i * (GENERATE_MAX_WORD_LENGTH + 1);
+        length = 1;
+        for (j = 0; j < trials; j++) {
+            length += generate_uniform(generate) < 0.5 ? 1 : 0;
+        }
+        if (length > GENERATE_MAX_WORD_LENGTH) {
+            length = GENERATE_MAX_WORD_LENGTH;
+        }
+        for (j = 0; j < length; j++) {
+            generate->words[generate->offsets[i] + j] = (char) generate->symbols[
+                    generate_sample(generate, generate->symbol_cdf, generate->number_symbols)];
+        }
+    }
+    qsort_r(generate->offsets, options->vocabulary, sizeof(size_t), generate_compare_length, generate->words);
+
+    total = 0.0;
+    for (i = 0; i < options->vocabulary; i++) {
+        total += 1.0 / pow((double) (i + 1), options->zipf);
+        generate->rank_cdf[i] = total;
+    }
+    return 1;
+}
+
+/*!
+ * Generate a sentence into a buffer. The sentence ends early if the buffer is full.
+ * @return Length of the sentence, including the separating space.
+ */
+static size_t
+generate_sentence(generate_t *const generate, const generate_options_t *const options, char *buffer, size_t capacity) {
+    const char *word;
+    size_t length;
+    size_t rank;
+    size_t words;
+    size_t i;
+
+    // The number of words is geometric, sentences end after every word with the same probability.
+    length = 0;
+    words = 0;
+    do {
+        rank = generate_sample(generate, generate->rank_cdf, generate->number_words);
+        word = &generate->words[generate->offsets[rank]];
+        if (length + strlen(word) + 3 > capacity) {
+            break;
+        }
+        if (words > 0) {
+            if (generate_uniform(generate) < GENERATE_COMMA_PROBABILITY) {
+                buffer[length++] = ',';
+            }
+            buffer[length++] = ' ';
+        }
+        for (i = 0; word[i] != '\0'; i++) {
+            buffer[length++] = word[i];
+        }
+        if (words == 0 || generate_uniform(generate) < options->capitals) {
+            buffer[length - i] = (char) toupper((unsigned char) buffer[length - i]);
+        }
+        words++;
+    } while (generate_uniform(generate) >= 1.0 / GENERATE_SENTENCE_WORDS);
+
+    buffer[length++] = '.';
+    buffer[length++] = ' ';
+    return length;
+}
+
+static uint64_t
+generate_parse_size(const char *text) {
+    char *end;
+    double value;
+
+    value = strtod(text, &end);
+    switch (toupper((unsigned char) *end)) {
+        case 'K':
+            value *= 1024.0;
+            break;
+        case 'M':
+            value *= 1024.0 * 1024.0;
+            break;
+        case 'G':
+            value *= 1024.0 * 1024.0 * 1024.0;
+            break;
+        default:
+            break;
+    }
+    return value > 0.0 ? (uint64_t) value : 0;
+}
+
+static void
+generate_usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -o, --out PATH          Corpus to be written, - for stdout.\n"
+            "  -s, --size BYTES        Size of the corpus, with K, M or G suffix (default: 10M).\n"
+            "  -v, --vocabulary N      Number of words of the vocabulary (default: 10000).\n"
+            "  -z, --zipf S            Exponent of the Zipfian word distribution (default: 1.0).\n"
+            "  -a, --alphabet NAME     uniform, english or a text file to count symbols in (default: english).\n"
+            "  -c, --capitals P        Probability of a capitalized word within a sentence (default: 0.05).\n"
+            "  -w, --word-length MEAN  Mean length of the words of the vocabulary (default: 5).\n"
+            "  -r, --seed N            Seed of the random numbers (default: 1).\n"
+            "  -k, --keys PATH         Key sequences to be written, one per line.\n"
+            "  -t, --truth PATH        Text of the key sequences to be written, one per line.\n"
+            "  -n, --sequences N       Number of key sequences (default: 1000).\n"
+            "  -l, --length N          Keys per sequence (default: 20).\n"
+            "  -p, --prefixes          Write every prefix of a sequence, as resubmitted with every keystroke.\n",
+            name);
+}
+
+static int
+generate_parse(int argc, char **argv, generate_options_t *const options) {
+    const struct option long_options[] = {
+            {"out",         required_argument, NULL, 'o'},
+            {"size",        required_argument, NULL, 's'},
+            {"vocabulary",  required_argument, NULL, 'v'},
+            {"zipf",        required_argument, NULL, 'z'},
+            {"alphabet",    required_argument, NULL, 'a'},
+            {"capitals",    required_argument, NULL, 'c'},
+            {"word-length", required_argument, NULL, 'w'},
+            {"seed",        required_argument, NULL, 'r'},
+            {"keys",        required_argument, NULL, 'k'},
+            {"truth",       required_argument, NULL, 't'},
+            {"sequences",   required_argument, NULL, 'n'},
+            {"length",      required_argument, NULL, 'l'},
+            {"prefixes",    no_argument,       NULL, 'p'},
+            {NULL, 0,                          NULL, 0}
+    };
+    int option;
+
+    memset(options, 0, sizeof(generate_options_t));
+    options->alphabet = "english";
+    options->size = 10 * 1024 * 1024;
+    options->vocabulary = 10000;
+    options->zipf = 1.0;
+    options->capitals = 0.05;
+    options->word_length = 5.0;
+    options->seed = 1;
+    options->sequences = 1000;
+    options->length = 20;
+
+    while ((option = getopt_long(argc, argv, "o:s:v:z:a:c:w:r:k:t:n:l:p", long_options, NULL)) != -1) {
+        switch (option) {
+            case 'o':
+                options->out = optarg;
+                break;
+            case 's':
+                options->size = generate_parse_size(optarg);
+                break;
+            case 'v':
+                options->vocabulary = (size_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'z':
+                options->zipf = strtod(optarg, NULL);
+                break;
+            case 'a':
+                options->alphabet = optarg;
+                break;
+            case 'c':
+                options->capitals = strtod(optarg, NULL);
+                break;
+            case 'w':
+                options->word_length = strtod(optarg, NULL);
+                break;
+            case 'r':
+                options->seed = (uint64_t) strtoull(optarg, NULL, 10);
+                break;
+            case 'k':
+                options->keys = optarg;
+                break;
+            case 't':
+                options->truth = optarg;
+                break;
+            case 'n':
+                options->sequences = (size_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                options->length = (size_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'p':
+                options->prefixes = 1;
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    return optind == argc && (options->out != NULL || options->keys != NULL) && options->vocabulary > 0
+           && options->word_length >= 1.0 && options->length > 0;
+}
+
+/*!
+ * Write the corpus, sentence by sentence, cut to the requested size.
+ */
+static int
+generate_corpus(generate_t *const generate, const generate_options_t *const options) {
+    char sentence[GENERATE_SENTENCE_WORDS * 8 * (GENERATE_MAX_WORD_LENGTH + 2)];
+    uint64_t written;
+    size_t length;
+    FILE *fp;
+
+    fp = strcmp(options->out, "-") == 0 ? stdout : fopen(options->out, "wb");
+    if (fp == NULL) {
+        return 0;
+    }
+
+    written = 0;
+    while (written < options->size) {
+        length = generate_sentence(generate, options, sentence, sizeof(sentence));
+        if (length > options->size - written) {
+            length = (size_t) (options->size - written);
+        }
+        if (fwrite(sentence, 1, length, fp) != length) {
+            break;
+        }
+        written += length;
+    }
+
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    return written == options->size;
+}
+
+/*!
+ * Write key sequences of new sentences drawn from the same distribution as the corpus, and optionally their text.
+ * Every sequence starts at a word of the text.
+ */
+static int
+generate_keys(generate_t *const generate, const generate_options_t *const options) {
+    char sentence[GENERATE_SENTENCE_WORDS * 8 * (GENERATE_MAX_WORD_LENGTH + 2)];
+    t9_symbol_t *keys;
+    char *text;
+    size_t filled;
+    size_t length;
+    size_t written;
+    size_t end;
+    size_t i;
+    FILE *keys_fp;
+    FILE *truth_fp;
+
+    keys_fp = fopen(options->keys, "wb");
+    truth_fp = options->truth != NULL ? fopen(options->truth, "wb") : NULL;
+    text = (char *) malloc(options->length + 1);
+    keys = (t9_symbol_t *) malloc(options->length + 1);
+    if (keys_fp == NULL || (options->truth != NULL && truth_fp == NULL) || text == NULL || keys == NULL) {
+        return 0;
+    }
+
+    for (written = 0; written < options->sequences; written++) {
+        // Fill the sequence with sentences, the last one is cut.
+        filled = 0;
+        while (filled < options->length) {
+            length = generate_sentence(generate, options, sentence, sizeof(sentence));
+            if (length > options->length - filled) {
+                length = options->length - filled;
+            }
+            memcpy(&text[filled], sentence, length);
+            filled += length;
+        }
+        for (i = 0; i < filled; i++) {
+            t9_corpus_ctol((t9_symbol_t) text[i], &keys[i]);
+        }
+
+        for (end = options->prefixes ? 1 : filled; end <= filled; end++) {
+            fprintf(keys_fp, "%.*s\n", (int) end, (const char *) keys);
+            if (truth_fp != NULL) {
+                fprintf(truth_fp, "%.*s\n", (int) end, text);
+            }
+        }
+    }
+
+    free(keys);
+    free(text);
+    if (truth_fp != NULL) {
+        fclose(truth_fp);
+    }
+    return fclose(keys_fp) == 0;
+}
+
+int main(int argc, char **argv) {
+    generate_options_t options;
+    generate_t generate;
+    int result;
+
+    if (generate_parse(argc, argv, &options) == 0) {
+        generate_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    memset(&generate, 0, sizeof(generate_t));
+    generate.random = options.seed != 0 ? options.seed : 1;
+    if (generate_alphabet(&generate, options.alphabet) == 0) {
+        fprintf(stderr, "Error: Could not set up the alphabet \"%s\".\n", options.alphabet);
+        return EXIT_FAILURE;
+    }
+    if (generate_vocabulary(&generate, &options) == 0) {
+        fprintf(stderr, "Error: Could not generate the vocabulary.\n");
+        return EXIT_FAILURE;
+    }
+
+    result = EXIT_SUCCESS;
+    if (options.out != NULL && generate_corpus(&generate, &options) == 0) {
+        fprintf(stderr, "Error: Could not write the corpus \"%s\".\n", options.out);
+        result = EXIT_FAILURE;
+    }
+    if (options.keys != NULL && generate_keys(&generate, &options) == 0) {
+        fprintf(stderr, "Error: Could not write the key sequences \"%s\".\n", options.keys);
+        result = EXIT_FAILURE;
+    }
+
+    free(generate.rank_cdf);
+    free(generate.offsets);
+    free(generate.words);
+    return result;
+}
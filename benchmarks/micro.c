@@ -0,0 +1,351 @@
+/*!
+  ******************************************************************************
+  * @file    micro.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Microbenchmarks of the hot paths of corpus loading, model building and decoding.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "t9/config.h"
+#include "t9/corpus.h"
+#include "t9/io.h"
+#include "t9/metrics.h"
+#include "t9/model.h"
+#include "t9/session.h"
+#include "t9/timer.h"
+#include "t9/tree.h"
+
+#include "common.h"
+
+// Number of keys typed into a session before it is reset.
+#define MICRO_SEQUENCE_LENGTH 20
+
+// Number of symbols of the test corpus typed and evaluated.
+#define MICRO_TEST_SYMBOLS 1000
+
+// Maximal number of ngrams looked up in the corpus tree.
+#define MICRO_LOOKUPS 100000
+
+/*!
+ * State shared by all benchmarks. The model is built once, cases that build trees use a tree of their own.
+ */
+struct struct_micro_state_t {
+    const char *corpus_file;
+    t9_model_t *model;
+    t9_corpus_tree_t *tree;
+    t9_session_t *session;
+    t9_metrics_t *metrics;
+    t9_symbol_t *keys;
+    size_t number_keys;
+    t9_symbol_t *ngrams;
+    size_t number_ngrams;
+    size_t operations;
+    double measured_ms;
+    double sink;
+};
+
+typedef struct struct_micro_state_t micro_state_t;
+
+/*!
+ * A benchmark. Only run is measured, setup and teardown are executed before and after every repetition. A run may
+ * measure itself by setting measured_ms, otherwise its whole duration is taken.
+ */
+struct struct_micro_case_t {
+    const char *name;
+    const char *unit;
+    void (*setup)(micro_state_t *const state);
+    void (*run)(micro_state_t *const state);
+    void (*teardown)(micro_state_t *const state);
+};
+
+typedef struct struct_micro_case_t micro_case_t;
+
+static void
+micro_nothing(micro_state_t *const state) {
+    (void) state;
+}
+
+static void
+micro_read_file(micro_state_t *const state) {
+    t9_symbol_t *buffer;
+    size_t size;
+
+    size = 0;
+    if (t9_read_file(state->corpus_file, &size, &buffer, 0) == T9_SUCCESS) {
+        state->sink += buffer[size / 2];
+        free(buffer);
+    }
+    state->operations = size;
+}
+
+static void
+micro_tree_create(micro_state_t *const state) {
+    state->tree = t9_corpus_tree_create();
+}
+
+static void
+micro_tree_fill(micro_state_t *const state) {
+    state->tree = t9_corpus_tree_create();
+    t9_corpus_tree_insert_ngrams(state->tree, &state->model->corpus, BENCH_NGRAM_LENGTH);
+    state->operations = __t9_model_count_nodes(state->tree->root);
+}
+
+static void
+micro_tree_destroy(micro_state_t *const state) {
+    t9_corpus_tree_destroy(state->tree);
+    state->tree = NULL;
+}
+
+static void
+micro_insert_ngrams(micro_state_t *const state) {
+    t9_corpus_tree_insert_ngrams(state->tree, &state->model->corpus, BENCH_NGRAM_LENGTH);
+    state->operations = state->model->corpus.train_buffer_size;
+}
+
+static void
+micro_finalize(micro_state_t *const state) {
+    t9_corpus_tree_finalize(state->tree);
+}
+
+static void
+micro_conditional_probability(micro_state_t *const state) {
+    size_t i;
+
+    for (i = 0; i < state->number_ngrams; i++) {
+        state->sink += t9_corpus_tree_conditional_probability(state->model->corpus_tree,
+                                                              &state->ngrams[i * (BENCH_NGRAM_LENGTH + 1)]);
+    }
+    state->operations = state->number_ngrams;
+}
+
+static void
+micro_type_keys(micro_state_t *const state) {
+    size_t i;
+
+    // Keys enter the search tree through the session, which adds the level the key is typed into.
+    for (i = 0; i < state->number_keys; i++) {
+        if (i % MICRO_SEQUENCE_LENGTH == 0) {
+            t9_session_reset(state->session);
+        }
+        t9_session_insert(state->session, state->keys[i], 0.0, NULL);
+    }
+    state->operations = state->number_keys;
+}
+
+static void
+micro_prune(micro_state_t *const state) {
+    uint64_t before;
+    uint64_t after;
+
+    // Pruning is part of every key, its share is taken from the metrics of the session.
+    before = atomic_load(&state->metrics->histograms[T9_METRICS_PRUNE].sum);
+    t9_session_set_metrics(state->session, state->metrics);
+    micro_type_keys(state);
+    t9_session_set_metrics(state->session, NULL);
+    after = atomic_load(&state->metrics->histograms[T9_METRICS_PRUNE].sum);
+
+    state->measured_ms = (double) (after - before) / 1000000.0;
+}
+
+static void
+micro_evaluate(micro_state_t *const state) {
+    double error;
+
+    if (t9_model_evaluate(state->model, &error) == T9_SUCCESS) {
+        state->sink += error;
+    }
+    state->operations = state->model->corpus.test_buffer_size;
+}
+
+static int
+micro_compare(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+/*!
+ * Print a string as JSON string, escaping quotes, backslashes and control characters.
+ */
+static void
+micro_json_string(const char *text) {
+    putchar('"');
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            printf("\\%c", *text);
+        } else if ((unsigned char) *text < 0x20) {
+            printf("\\u%04x", (unsigned int) (unsigned char) *text);
+        } else {
+            putchar(*text);
+        }
+    }
+    putchar('"');
+}
+
+/*!
+ * Prepare the shared state: the model, the keys of the test corpus and the ngrams to be looked up.
+ */
+static t9_error_t
+micro_prepare(micro_state_t *const state) {
+    size_t i;
+
+    state->model = bench_model_create(state->corpus_file, MICRO_TEST_SYMBOLS);
+    if (state->model == NULL) {
+        return T9_FAILURE;
+    }
+    state->model->paths_per_context = 1;
+    state->model->beam_threshold = 10.0f;
+
+    state->session = t9_session_create(state->model);
+    state->metrics = t9_metrics_create();
+    state->keys = (t9_symbol_t *) malloc(state->model->corpus.test_buffer_size + 1);
+    state->ngrams = (t9_symbol_t *) calloc(MICRO_LOOKUPS, BENCH_NGRAM_LENGTH + 1);
+    if (state->session == NULL || state->metrics == NULL || state->keys == NULL || state->ngrams == NULL) {
+        return T9_FAILURE;
+    }
+
+    for (i = 0; i < state->model->corpus.test_buffer_size; i++) {
+        if (t9_corpus_ctol(state->model->corpus.test_buffer[i], &state->keys[state->number_keys]) == T9_SUCCESS) {
+            state->number_keys++;
+        }
+    }
+
+    // Look up the ngrams the train corpus starts with, as the decoder does while scoring paths.
+    for (i = 0; i + BENCH_NGRAM_LENGTH <= state->model->corpus.train_buffer_size && i < MICRO_LOOKUPS; i++) {
+        memcpy(&state->ngrams[i * (BENCH_NGRAM_LENGTH + 1)], &state->model->corpus.train_buffer[i],
+               BENCH_NGRAM_LENGTH);
+        state->number_ngrams++;
+    }
+
+    return T9_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    const micro_case_t cases[] = {
+            {"read_file",               "byte",   micro_nothing,     micro_read_file,               micro_nothing},
+            {"insert_ngrams",           "symbol", micro_tree_create, micro_insert_ngrams,           micro_tree_destroy},
+            {"finalize",                "node",   micro_tree_fill,   micro_finalize,                micro_tree_destroy},
+            {"conditional_probability", "lookup", micro_nothing,     micro_conditional_probability, micro_nothing},
+            {"search_tree_insert",      "key",    micro_nothing,     micro_type_keys,               micro_nothing},
+            {"prune",                   "key",    micro_nothing,     micro_prune,                   micro_nothing},
+            {"evaluate",                "symbol", micro_nothing,     micro_evaluate,                micro_nothing},
+    };
+    const char *filter;
+    micro_state_t state;
+    double *samples;
+    double start;
+    double mean;
+    double deviation;
+    double median;
+    size_t repetitions;
+    size_t warmup;
+    size_t printed;
+    size_t c;
+    size_t i;
+
+    memset(&state, 0, sizeof(micro_state_t));
+    state.corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    repetitions = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 5;
+    warmup = argc > 3 ? (size_t) strtoul(argv[3], NULL, 10) : 1;
+    filter = argc > 4 ? argv[4] : "";
+    if (repetitions == 0) {
+        repetitions = 1;
+    }
+
+    samples = (double *) calloc(repetitions, sizeof(double));
+    if (samples == NULL || micro_prepare(&state) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Could not prepare the benchmarks on \"%s\".\n", state.corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    printf("{\n  \"version\": ");
+    micro_json_string(CT9_VERSION);
+    printf(",\n  \"corpus\": ");
+    micro_json_string(state.corpus_file);
+    printf(",\n  \"ngram_length\": %u,\n  \"warmup\": %zu,\n  \"repetitions\": %zu,\n  \"benchmarks\": [",
+           BENCH_NGRAM_LENGTH, warmup, repetitions);
+
+    printed = 0;
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        if (strstr(cases[c].name, filter) == NULL) {
+            continue;
+        }
+        fprintf(stderr, "[Micro]: %s ...\n", cases[c].name);
+
+        // Warm up caches, the allocator and the branch predictors, then measure every repetition on its own.
+        for (i = 0; i < warmup + repetitions; i++) {
+            cases[c].setup(&state);
+            state.measured_ms = -1.0;
+            start = t9_timer_now_ms();
+            cases[c].run(&state);
+            if (state.measured_ms < 0.0) {
+                state.measured_ms = t9_timer_now_ms() - start;
+            }
+            cases[c].teardown(&state);
+            if (i >= warmup) {
+                samples[i - warmup] = state.measured_ms;
+            }
+        }
+
+        mean = 0.0;
+        for (i = 0; i < repetitions; i++) {
+            mean += samples[i] / (double) repetitions;
+        }
+        deviation = 0.0;
+        for (i = 0; i < repetitions; i++) {
+            deviation += (samples[i] - mean) * (samples[i] - mean) / (double) repetitions;
+        }
+        qsort(samples, repetitions, sizeof(double), micro_compare);
+        median = repetitions % 2 == 1 ? samples[repetitions / 2]
+                                      : (samples[repetitions / 2 - 1] + samples[repetitions / 2]) / 2.0;
+
+        printf("%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"operations\": %zu, \"min_ms\": %.6f, "
+               "\"median_ms\": %.6f, \"mean_ms\": %.6f, \"max_ms\": %.6f, \"stddev_ms\": %.6f, "
+               "\"ns_per_operation\": %.3f}",
+               printed > 0 ? "," : "", cases[c].name, cases[c].unit, state.operations, samples[0], median, mean,
+               samples[repetitions - 1], sqrt(deviation),
+               state.operations > 0 ? median * 1000000.0 / (double) state.operations : 0.0);
+        printed++;
+    }
+    printf("\n  ],\n  \"sink\": %.1f\n}\n", state.sink);
+
+    free(samples);
+    free(state.ngrams);
+    free(state.keys);
+    t9_metrics_destroy(state.metrics);
+    t9_session_destroy(state.session);
+    t9_model_destroy(state.model);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+/*!
+  ******************************************************************************
+  * @file    prefix.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Benchmark for batch autocompletion of sequences sharing prefixes.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/timer.h"
+#include "t9/tree.h"
+
+#include "common.h"
+
+/*!
+ * Convert the test corpus into the key sequences a server receives from users, who resubmit the whole sequence typed
+ * so far with every keystroke. Every message of up to length keys contributes all of its prefixes.
+ */
+static size_t
+bench_make_prefixes(const corpus_t *const corpus,
+                    size_t count,
+                    size_t length,
+                    t9_symbol_t **sequences) {
+    t9_symbol_t *message;
+    size_t offset;
+    size_t made;
+    size_t i;
+
+    made = 0;
+    offset = 0;
+    while (made < count && offset + length <= corpus->test_buffer_size) {
+        if (t9_corpus_lexicon_from_corpus(&corpus->test_buffer[offset], length, &message) != T9_SUCCESS) {
+            break;
+        }
+        for (i = 1; i <= strlen((const char *) message) && made < count; i++) {
+            sequences[made] = (t9_symbol_t *) calloc(i + 1, sizeof(t9_symbol_t));
+            memcpy(sequences[made], message, i);
+            made++;
+        }
+        free(message);
+        offset += length;
+    }
+    return made;
+}
+
+int main(int argc, char **argv) {
+    const char *corpus_file;
+    t9_model_t *model;
+    t9_symbol_t **sequences;
+    t9_symbol_t **expected;
+    t9_symbol_t **suggestions;
+    size_t count;
+    size_t length;
+    size_t keys;
+    size_t mismatches;
+    size_t i;
+    double start;
+    double batch;
+    double shared;
+
+    corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    count = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 2000;
+    length = argc > 3 ? (size_t) strtoul(argv[3], NULL, 10) : 40;
+
+    model = bench_model_create(corpus_file, 0);
+    if (model == NULL) {
+        fprintf(stderr, "Error: Could not build a model on corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    sequences = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    expected = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    suggestions = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+    if (sequences == NULL || expected == NULL || suggestions == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    count = bench_make_prefixes(&model->corpus, count, length, sequences);
+
+    keys = 0;
+    for (i = 0; i < count; i++) {
+        keys += strlen((const char *) sequences[i]);
+    }
+
+    // Decode every sequence on its own.
+    start = t9_timer_now_ms();
+    if (t9_model_autocomplete_batch(model, (const t9_symbol_t *const *) sequences, count,
+                                    expected, NULL) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Batch completion failed.\n");
+        return EXIT_FAILURE;
+    }
+    batch = t9_timer_now_ms() - start;
+
+    // Decode shared prefixes once.
+    start = t9_timer_now_ms();
+    if (t9_model_autocomplete_shared(model, (const t9_symbol_t *const *) sequences, count,
+                                     suggestions, NULL) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Batch completion with shared prefixes failed.\n");
+        return EXIT_FAILURE;
+    }
+    shared = t9_timer_now_ms() - start;
+
+    mismatches = 0;
+    for (i = 0; i < count; i++) {
+        if (strcmp((const char *) expected[i], (const char *) suggestions[i]) != 0) {
+            mismatches++;
+        }
+        free(expected[i]);
+        free(suggestions[i]);
+        free(sequences[i]);
+    }
+
+    printf("sequences,keys,batch_ms,shared_ms,speedup,mismatches\n");
+    printf("%zu,%zu,%.2f,%.2f,%.2f,%zu\n", count, keys, batch, shared, batch / shared, mismatches);
+
+    free(sequences);
+    free(expected);
+    free(suggestions);
+    t9_model_destroy(model);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
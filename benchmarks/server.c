@@ -0,0 +1,280 @@
+/*!
+  ******************************************************************************
+  * @file    server.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Load generating client for the completion server.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+// We use epoll, setrlimit and Unix domain sockets.
+// These functions are POSIX extensions, not in C.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "t9/corpus.h"
+#include "t9/server.h"
+#include "t9/timer.h"
+
+// Maximal number of keys typed per connection.
+#define BENCH_MAX_KEYS 512
+
+// Size of the response buffer of a connection, large enough for responses to BENCH_MAX_KEYS keys.
+#define BENCH_BUFFER_SIZE 4096
+
+/*!
+ * Client connection typing a message key by key, with one request in flight.
+ */
+struct bench_connection {
+    int socket;
+    t9_symbol_t *keys;
+    size_t length;
+    size_t position;
+    double sent;
+    uint8_t buffer[BENCH_BUFFER_SIZE];
+    size_t received;
+};
+
+/*!
+ * Connect to the server.
+ */
+static int
+bench_connect(const char *const path) {
+    struct sockaddr_un address;
+    int client;
+
+    client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client < 0) {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(struct sockaddr_un));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if (connect(client, (const struct sockaddr *) &address, sizeof(struct sockaddr_un)) != 0) {
+        close(client);
+        return -1;
+    }
+
+    return client;
+}
+
+/*!
+ * Send the next key of a connection.
+ */
+static int
+bench_send_key(struct bench_connection *const connection) {
+    uint8_t request[sizeof(uint32_t) + 2];
+    uint32_t size;
+
+    size = 2;
+    memcpy(request, &size, sizeof(uint32_t));
+    request[sizeof(uint32_t)] = T9_SERVER_TYPE;
+    request[sizeof(uint32_t) + 1] = connection->keys[connection->position];
+
+    connection->sent = t9_timer_now_ms();
+    connection->received = 0;
+    return send(connection->socket, request, sizeof(request), MSG_NOSIGNAL) == (ssize_t) sizeof(request) ? 0 : -1;
+}
+
+/*!
+ * Sort latencies with qsort.
+ */
+static int
+bench_compare_latencies(const void *a,
+                        const void *b) {
+    double latency_a;
+    double latency_b;
+
+    latency_a = *(const double *) a;
+    latency_b = *(const double *) b;
+    return (latency_a > latency_b) - (latency_a < latency_b);
+}
+
+int main(int argc, char **argv) {
+    const char *socket_path;
+    const char *corpus_file;
+    corpus_t corpus;
+    struct bench_connection *connections;
+    struct bench_connection *connection;
+    struct epoll_event event;
+    struct epoll_event events[256];
+    struct rlimit limit;
+    double *latencies;
+    size_t number_latencies;
+    size_t number_connections;
+    size_t number_keys;
+    size_t number_errors;
+    size_t done;
+    size_t offset;
+    size_t i;
+    uint32_t size;
+    ssize_t received;
+    int number_events;
+    int loop;
+    int j;
+    double start;
+    double duration;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <socket> [corpus] [connections] [keys per connection]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    socket_path = argv[1];
+    corpus_file = argc > 2 ? argv[2] : "../data/trump/twitter.txt";
+    number_connections = argc > 3 ? (size_t) strtoul(argv[3], NULL, 10) : 1000;
+    number_keys = argc > 4 ? (size_t) strtoul(argv[4], NULL, 10) : 40;
+    if (number_connections == 0 || number_keys == 0 || number_keys > BENCH_MAX_KEYS) {
+        fprintf(stderr, "Error: Invalid number of connections or keys.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every connection takes one descriptor.
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    if (t9_corpus_load(corpus_file, 0, corpus_file, 0, &corpus) != T9_SUCCESS
+        || corpus.test_buffer_size <= number_keys) {
+        fprintf(stderr, "Error: Could not load corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    connections = (struct bench_connection *) calloc(number_connections, sizeof(struct bench_connection));
+    latencies = (double *) calloc(number_connections * number_keys, sizeof(double));
+    loop = epoll_create1(EPOLL_CLOEXEC);
+    if (connections == NULL || latencies == NULL || loop < 0) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every connection types its own part of the corpus.
+    for (i = 0; i < number_connections; i++) {
+        connection = &connections[i];
+        offset = (i * number_keys) % (corpus.test_buffer_size - number_keys);
+        if (t9_corpus_lexicon_from_corpus(&corpus.test_buffer[offset], number_keys, &connection->keys) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not convert the corpus into keys.\n");
+            return EXIT_FAILURE;
+        }
+        connection->length = strlen((const char *) connection->keys);
+
+        connection->socket = bench_connect(socket_path);
+        if (connection->socket < 0) {
+            fprintf(stderr, "Error: Could not connect to \"%s\": %s.\n", socket_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        memset(&event, 0, sizeof(struct epoll_event));
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(loop, EPOLL_CTL_ADD, connection->socket, &event);
+    }
+
+    // Type all keys, every response triggers the next key of its connection.
+    start = t9_timer_now_ms();
+    for (i = 0; i < number_connections; i++) {
+        if (bench_send_key(&connections[i]) != 0) {
+            fprintf(stderr, "Error: Could not send a request.\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    done = 0;
+    number_errors = 0;
+    number_latencies = 0;
+    while (done < number_connections) {
+        number_events = epoll_wait(loop, events, 256, -1);
+        if (number_events < 0 && errno != EINTR) {
+            fprintf(stderr, "Error: Waiting for responses failed.\n");
+            return EXIT_FAILURE;
+        }
+
+        for (j = 0; j < number_events; j++) {
+            connection = (struct bench_connection *) events[j].data.ptr;
+            received = read(connection->socket, &connection->buffer[connection->received],
+                            BENCH_BUFFER_SIZE - connection->received);
+            if (received <= 0) {
+                fprintf(stderr, "Error: The server closed a connection.\n");
+                return EXIT_FAILURE;
+            }
+            connection->received += (size_t) received;
+
+            // Wait for the complete response.
+            if (connection->received < sizeof(uint32_t)) {
+                continue;
+            }
+            memcpy(&size, connection->buffer, sizeof(uint32_t));
+            if (connection->received < sizeof(uint32_t) + size) {
+                continue;
+            }
+
+            latencies[number_latencies++] = t9_timer_now_ms() - connection->sent;
+            if (connection->buffer[sizeof(uint32_t)] != T9_SERVER_OK) {
+                number_errors++;
+            }
+
+            connection->position++;
+            if (connection->position < connection->length) {
+                if (bench_send_key(connection) != 0) {
+                    fprintf(stderr, "Error: Could not send a request.\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                close(connection->socket);
+                done++;
+            }
+        }
+    }
+    duration = t9_timer_now_ms() - start;
+
+    qsort(latencies, number_latencies, sizeof(double), bench_compare_latencies);
+    printf("connections,requests,errors,duration_ms,requests_per_s,p50_ms,p99_ms,p999_ms\n");
+    printf("%zu,%zu,%zu,%.2f,%.1f,%.3f,%.3f,%.3f\n", number_connections, number_latencies, number_errors,
+           duration, (double) number_latencies / (duration / 1000.0),
+           latencies[number_latencies / 2],
+           latencies[(size_t) ((double) number_latencies * 0.99)],
+           latencies[(size_t) ((double) number_latencies * 0.999)]);
+
+    for (i = 0; i < number_connections; i++) {
+        free(connections[i].keys);
+    }
+    free(connections);
+    free(latencies);
+    t9_corpus_unload(&corpus);
+    close(loop);
+    return number_errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
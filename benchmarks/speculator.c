@@ -0,0 +1,209 @@
+/*!
+  ******************************************************************************
+  * @file    speculator.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Benchmark for the keystroke latency with and without speculation.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+// We use nanosleep.
+// This function is a POSIX extension, not in C.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/session.h"
+#include "t9/speculator.h"
+#include "t9/timer.h"
+
+#include "common.h"
+
+// Number of suggestions taken after every key, as a server answers.
+#define BENCH_NUMBER_SUGGESTIONS 3
+
+/*!
+ * Compare two latencies for sorting them in ascending order.
+ */
+static int
+bench_compare(const void *a,
+              const void *b) {
+    double x;
+    double y;
+
+    x = *(const double *) a;
+    y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/*!
+ * Type keys one after the other like a user, pausing for the think time before every key, and measure the time from
+ * typing a key until its suggestions are taken. Without a speculator, every key is decoded when it is typed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+static t9_error_t
+bench_type(t9_session_t *const session,
+           t9_speculator_t *const speculator,
+           const t9_symbol_t *const keys,
+           size_t number_keys,
+           double think_ms,
+           double *const latencies) {
+    t9_symbol_t *suggestions;
+    float scores[BENCH_NUMBER_SUGGESTIONS];
+    struct timespec pause;
+    size_t count;
+    size_t i;
+    double start;
+    t9_error_t error;
+
+    suggestions = (t9_symbol_t *) calloc(BENCH_NUMBER_SUGGESTIONS, number_keys + 1);
+    if (suggestions == NULL) {
+        return T9_FAILURE;
+    }
+
+    pause.tv_sec = (time_t) (think_ms / 1000.0);
+    pause.tv_nsec = (long) ((think_ms - (double) pause.tv_sec * 1000.0) * 1e6);
+    for (i = 0; i < number_keys; i++) {
+        nanosleep(&pause, NULL);
+
+        start = t9_timer_now_ms();
+        if (speculator != NULL) {
+            error = t9_speculator_insert(speculator, keys[i], 0.0, NULL);
+            if (error == T9_SUCCESS) {
+                error = t9_speculator_nbest(speculator, suggestions, number_keys + 1, scores,
+                                            BENCH_NUMBER_SUGGESTIONS, &count);
+            }
+        } else {
+            error = t9_session_insert(session, keys[i], 0.0, NULL);
+            if (error == T9_SUCCESS) {
+                error = t9_session_nbest(session, suggestions, number_keys + 1, scores, BENCH_NUMBER_SUGGESTIONS,
+                                         &count);
+            }
+        }
+        latencies[i] = (t9_timer_now_ms() - start) * 1000.0;
+
+        if (error != T9_SUCCESS) {
+            free(suggestions);
+            return T9_FAILURE;
+        }
+    }
+
+    free(suggestions);
+    return T9_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    const char *corpus_file;
+    const char *mode;
+    t9_model_t *model;
+    t9_session_t *session;
+    t9_speculator_t *speculator;
+    t9_symbol_t *keys;
+    double *latencies;
+    double sum;
+    size_t number_keys;
+    size_t i;
+    size_t run;
+    double think_ms;
+    uint8_t number_speculated;
+
+    corpus_file = argc > 1 ? argv[1] : "../data/trump/twitter.txt";
+    number_keys = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 200;
+    think_ms = argc > 3 ? strtod(argv[3], NULL) : 30.0;
+    number_speculated = (uint8_t) (argc > 4 ? strtoul(argv[4], NULL, 10) : 3);
+    if (number_speculated == 0 || number_speculated > NUM_LEXICON_SYMBOLS) {
+        fprintf(stderr, "Error: The number of keys to speculate on must be within 1 and %u.\n", NUM_LEXICON_SYMBOLS);
+        return EXIT_FAILURE;
+    }
+
+    model = bench_model_create(corpus_file, 0);
+    if (model == NULL) {
+        fprintf(stderr, "Error: Could not build a model on corpus \"%s\".\n", corpus_file);
+        return EXIT_FAILURE;
+    }
+
+    // Decode like a server would, with recombination and a beam threshold.
+    model->paths_per_context = 1;
+    model->beam_threshold = 10.0f;
+
+    // The keys of the test corpus are typed as one message.
+    keys = (t9_symbol_t *) calloc(number_keys + 1, sizeof(t9_symbol_t));
+    latencies = (double *) calloc(number_keys, sizeof(double));
+    if (keys == NULL || latencies == NULL) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < model->corpus.test_buffer_size && strlen((const char *) keys) < number_keys; i++) {
+        t9_corpus_ctol(model->corpus.test_buffer[i], &keys[strlen((const char *) keys)]);
+    }
+    number_keys = strlen((const char *) keys);
+
+    printf("mode,keys,think_ms,speculated,hit_rate,mean_us,p50_us,p99_us,max_us\n");
+    for (run = 0; run < 2; run++) {
+        session = t9_session_create(model);
+        speculator = NULL;
+        if (session != NULL && run == 1) {
+            speculator = t9_speculator_create(session, number_speculated);
+        }
+        if (session == NULL || (run == 1 && speculator == NULL)) {
+            fprintf(stderr, "Error: Could not create a session.\n");
+            return EXIT_FAILURE;
+        }
+
+        if (bench_type(session, speculator, keys, number_keys, think_ms, latencies) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Decoding failed.\n");
+            return EXIT_FAILURE;
+        }
+
+        sum = 0.0;
+        for (i = 0; i < number_keys; i++) {
+            sum += latencies[i];
+        }
+        qsort(latencies, number_keys, sizeof(double), bench_compare);
+
+        mode = run == 0 ? "plain" : "speculated";
+        printf("%s,%zu,%.1f,%u,%.3f,%.1f,%.1f,%.1f,%.1f\n", mode, number_keys, think_ms,
+               run == 0 ? 0 : (unsigned int) number_speculated,
+               speculator != NULL ? (double) speculator->hits / (double) (speculator->hits + speculator->misses) : 0.0,
+               sum / (double) number_keys, latencies[number_keys / 2], latencies[number_keys * 99 / 100],
+               latencies[number_keys - 1]);
+
+        t9_speculator_destroy(speculator);
+        t9_session_destroy(session);
+    }
+
+    free(keys);
+    free(latencies);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
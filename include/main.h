@@ -35,33 +35,276 @@
 #ifndef C_T9_MAIN_H
 #define C_T9_MAIN_H
 
+// We use getopt_long, getline, poll and sigaction.
+// These functions are GNU and POSIX extensions, not in C.
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "t9/config.h"
+#include "t9/cache.h"
 #include "t9/corpus.h"
+#include "t9/model.h"
 #include "t9/tree.h"
 #include "t9/timer.h"
+#include "t9/pool.h"
+#include "t9/profile.h"
+#include "t9/stats.h"
 
+// Default corpus, used if neither a corpus nor a model is given.
+#define MAIN_DEFAULT_CORPUS "../data/trump/twitter.txt"
 
+// Decoding parameters of a new model, used if they are not given.
+#define MAIN_DEFAULT_NGRAM_LENGTH 3
+#define MAIN_DEFAULT_NUMBER_PATHS 15
+#define MAIN_DEFAULT_PATHS_PER_CONTEXT 1
+#define MAIN_DEFAULT_BEAM_THRESHOLD 10.0f
+
+// Number of words kept per key sequence by the dictionary of a new model, used if it is not given.
+#define MAIN_DEFAULT_DICTIONARY_WORDS 8
+
+// Size of the buffer stdin is read into by the complete command.
+#define MAIN_READ_BUFFER_SIZE 65536
+
+/*!
+ * Options of the command line. Decoding parameters that are not given are 0 (decoder: UINT8_MAX, paths per context and
+ * threshold: -1) and fall back to the ones stored in the model or to the defaults if the model is trained.
+ */
+struct struct_options_t {
+    const char *command;
+    const char *corpus;
+    const char *model;
+    const char *out;
+    const char *socket;
+    const char *metrics;
+    size_t train_limit;
+    size_t test_limit;
+    uint8_t ngram_length;
+    uint16_t number_paths;
+    int32_t paths_per_context;
+    float beam_threshold;
+    t9_decoder_t decoder;
+    uint8_t rescore_length;
+    uint16_t rescore_paths;
+    uint16_t threads;
+    size_t batch;
+    uint8_t nbest;
+    size_t sequences;
+    size_t length;
+    uint8_t table_length;
+    uint8_t words;
+    size_t cache;
+    uint8_t speculate;
+};
+
+typedef struct struct_options_t options_t;
+
+/*!
+ * Buffered reader of lines from a file descriptor, which tells whether a line is available without blocking.
+ */
+struct struct_reader_t {
+    int fd;
+    char buffer[MAIN_READ_BUFFER_SIZE + 1];
+    size_t start;
+    size_t end;
+    bool eof;
+};
+
+typedef struct struct_reader_t reader_t;
+
+/*!
+ * Print the usage of the command line.
+ * @param name Name of the program.
+ */
 void
+options_usage(const char *name);
+
+/*!
+ * Parse the command line.
+ * @param argc Number of arguments.
+ * @param argv Array of arguments.
+ * @param options Pointer to the options to be filled.
+ * @return true if the command line is valid, false otherwise.
+ */
+bool
+options_parse(int argc, char **argv, options_t *const options);
+
+/*!
+ * Load or train the model the options describe. A model file is loaded if one is given, otherwise the model is
+ * trained on the corpus. The corpus is loaded in both cases if one is given, it provides the test data.
+ * Decoding parameters given on the command line override the ones of a loaded model.
+ * @note The user is responsible for destroying the model using t9_model_destroy once it is no longer required.
+ * @param options Pointer to the options.
+ * @return Pointer to the model, NULL if it could not be loaded.
+ */
+t9_model_t *
+model_prepare(const options_t *const options);
+
+/*!
+ * Build the dictionary of a model from its corpus.
+ * @param model Pointer to a model with a loaded corpus.
+ * @param number_words Number of words kept per key sequence.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+build_dictionary(t9_model_t *const model, uint16_t number_words);
+
+/*!
+ * Build the corpus tree of a model from its corpus. The tree holds the ngrams up to the larger one of the ngram length
+ * and the rescore length of the model.
+ * @param model Pointer to a model with a loaded corpus and its decoding parameters set.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
 build_corpus_tree(t9_model_t *const model);
 
+/*!
+ * Command: Train a model on the corpus and write it to a file. With a table length, the table of precomputed results
+ * of the model is built and written into the model file as well.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_train(const options_t *const options);
+
+/*!
+ * Command: Evaluate a model on the test corpus.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_eval(const options_t *const options);
+
+/*!
+ * Command: Evaluate a model for several ngram lengths and numbers of paths.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_sweep(const options_t *const options);
+
+/*!
+ * Command: Decode the test corpus as a single stream of keys.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_stream(const options_t *const options);
+
+/*!
+ * Command: Complete the key sequences read from stdin, one per line. Lines are collected into batches, which are
+ * decoded as soon as they are full or no further line is available without waiting. With --words, every line ends
+ * with the dictionary completions of its last word. With --cache, lines resume from the decoder state of their
+ * longest prefix completed before.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_complete(const options_t *const options);
+
+/*!
+ * Command: Measure the throughput of batch completion over windows of the test corpus. Prints CSV.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_bench(const options_t *const options);
+
+/*!
+ * Command: Report the memory of the model by structure and the shape of its corpus tree, then type the first keys of
+ * the test corpus and report the memory of the session after every key.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_stats(const options_t *const options);
+
+/*!
+ * Command: Serve completions on a Unix domain socket until SIGINT or SIGTERM.
+ * @param options Pointer to the options.
+ * @return Exit status.
+ */
+int
+command_serve(const options_t *const options);
+
+/*!
+ * Read the next line of a reader.
+ * @param reader Pointer to the reader.
+ * @param block Whether to wait for input if no line is available.
+ * @param line Pointer to a variable where the pointer to the line is placed. The line is terminated in place and valid
+ * until the next read.
+ * @return 1 if a line was read, 0 if no line is available without waiting, -1 at the end of the input.
+ */
+int
+reader_next(reader_t *const reader, bool block, char **line);
+
+/*!
+ * Decode and print a batch of lines read by the complete command. The lines are freed.
+ * @param model Pointer to the model to be used for completion.
+ * @param lines Array of lines.
+ * @param count Number of lines.
+ * @param nbest Number of suggestions per line, 0 prints the best suggestion only.
+ * @param words Number of completions of the last word per line, 0 prints none.
+ * @param cache Pointer to the cache the lines resume from, NULL decodes every line from scratch.
+ * @param pool Pointer to the pool used for decoding. Lines decoded with the cache are decoded one after the other.
+ */
+void
+complete_batch(const t9_model_t *const model, char **lines, size_t count, uint8_t nbest, uint8_t words,
+               t9_cache_t *const cache, t9_pool_t *const pool);
+
+/*!
+ * Print the dictionary completions of the last word of a line as a field of its own, the words separated by spaces.
+ * @param model Pointer to a model with a dictionary.
+ * @param line Key sequence of the line.
+ * @param words Maximal number of completions.
+ */
+void
+complete_words(const t9_model_t *const model, const char *const line, uint8_t words);
+
+/*!
+ * Print the hit rate and the memory of a cache.
+ * @param cache Pointer to a cache, NULL prints nothing.
+ */
+void
+cache_report(t9_cache_t *const cache);
+
 /*!
  * Example:
  * Evaluate the given statistical model by generating completing a known symbol sequence and comparing the deviation
  * between the generated sequence and the ground truth sequence.
  * @param model Pointer to the model to be evaluated.
+ * @param number_threads Number of threads to decode with, 0 uses all processors.
+ */
+void
+example_evaluation(t9_model_t *const model, uint16_t number_threads);
+
+/*!
+ * Example:
+ * Evaluate the given statistical model for all ngram lengths up to the one it was built with and several numbers of
+ * best paths. The corpus tree is only built once.
+ * @param model Pointer to the model to be evaluated.
+ * @param number_threads Number of threads to decode with, 0 uses all processors.
  */
 void
-example_evaluation(t9_model_t *const model);
+example_sweep(t9_model_t *const model, uint16_t number_threads);
 
 /*!
  * Example:
- * Autocomplete a given input sequence based on the statistical model.
+ * Type the whole test corpus key by key as one stream and print the text as soon as it is decoded.
  * @param model Pointer to the model to be used for completion.
  */
 void
-example_autocomplete(t9_model_t *const model, const char * text);
+example_stream(t9_model_t *const model);
+
+/*!
+ * Output of the stream example, prints committed symbols.
+ * @param symbols Pointer to the committed symbols.
+ * @param length Number of committed symbols.
+ * @param arg Unused.
+ */
+void
+example_stream_output(const t9_symbol_t *symbols, size_t length, void *arg);
 
 #endif //C_T9_MAIN_H
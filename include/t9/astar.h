@@ -0,0 +1,245 @@
+/*!
+  ******************************************************************************
+  * @file    astar.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for astar.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_ASTAR_H
+#define C_T9_ASTAR_H
+
+// Forward declarations of the A* decoder to break cyclic redundancy.
+struct struct_t9_astar_t;
+typedef struct struct_t9_astar_t t9_astar_t;
+
+#define kvec_akey_t(type) struct struct_kvec_akey {size_t n, m; type *a; }
+#define kvec_anode_t(type) struct struct_kvec_anode {size_t n, m; type *a; }
+#define kvec_aheap_t(type) struct struct_kvec_aheap {size_t n, m; type *a; }
+#define kvec_abound_t(type) struct struct_kvec_abound {size_t n, m; type *a; }
+#define kvec_afinal_t(type) struct struct_kvec_afinal {size_t n, m; type *a; }
+
+#include <float.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "libraries/kvec/kvec.h"
+
+#include "t9/corpus.h"
+#include "t9/viterbi.h"
+
+/*!
+ * Hypothesis of the A* decoder: a context state reached after a number of keys.
+ */
+struct struct_t9_astar_node_t {
+    uint32_t state;
+    uint32_t previous;
+    uint32_t position;
+    float probability;
+    t9_symbol_t symbol;
+};
+
+typedef struct struct_t9_astar_node_t t9_astar_node_t;
+
+/*!
+ * Entry of the priority queue. The priority is the score of a hypothesis minus the lower bound of the keys it consumed,
+ * which orders the queue like the score plus the lower bound of the remaining keys, but does not change once further
+ * keys are typed.
+ */
+struct struct_t9_astar_item_t {
+    double priority;
+    uint32_t node;
+};
+
+typedef struct struct_t9_astar_item_t t9_astar_item_t;
+
+/*!
+ * Best known score of a context state after a number of keys.
+ * The key of an unused slot is 0.
+ */
+struct struct_t9_astar_slot_t {
+    uint64_t key;
+    float probability;
+    bool closed;
+};
+
+typedef struct struct_t9_astar_slot_t t9_astar_slot_t;
+
+typedef kvec_akey_t(t9_symbol_t) t9_astar_key_vector_t;
+typedef kvec_anode_t(t9_astar_node_t) t9_astar_node_vector_t;
+typedef kvec_aheap_t(t9_astar_item_t) t9_astar_heap_t;
+typedef kvec_abound_t(double) t9_astar_bound_vector_t;
+typedef kvec_afinal_t(uint32_t) t9_astar_final_vector_t;
+
+/*!
+ * A* decoder of a whole key sequence.
+ * Hypotheses are expanded in the order of their score plus a lower bound of the cost of the keys that remain. The
+ * lower bound of a key is the cheapest symbol it can produce in any context state, which never overestimates, so the
+ * first complete hypothesis taken from the queue is the best one. Unlike the Viterbi decoder, states that can not
+ * compete with it are never expanded.
+ * The queue, the nodes and the slots are kept after a search. A new key continues the search from the complete
+ * hypotheses found before, and further complete hypotheses are found by continuing it as well.
+ *
+ * - prefix: Relaxed lower bound of the cost of the first i keys at index i.
+ * - finals: Complete hypotheses found so far, the best one first.
+ */
+struct struct_t9_astar_t {
+    const t9_viterbi_t *viterbi;
+    double bounds[NUM_LEXICON_SYMBOLS];
+    t9_astar_key_vector_t keys;
+    t9_astar_bound_vector_t prefix;
+    t9_astar_node_vector_t nodes;
+    t9_astar_heap_t heap;
+    t9_astar_final_vector_t finals;
+    t9_astar_slot_t *slots;
+    size_t number_slots;
+    size_t used_slots;
+    size_t expanded;
+    uint32_t best;
+};
+
+typedef struct struct_t9_astar_t t9_astar_t;
+
+
+/*!
+ * Create an A* decoder searching the context states of a compiled corpus tree.
+ * @note The user is responsible for destroying the decoder using t9_astar_destroy once it is no longer required.
+ * @param viterbi Pointer to the compiled context states to be used for decoding.
+ * @return Pointer to a new decoder. NULL if an error occurred.
+ */
+t9_astar_t *
+t9_astar_create(const t9_viterbi_t *const viterbi);
+
+/*!
+ * Destroy an A* decoder. The context states it refers to are not destroyed.
+ * @param astar Pointer to a decoder that is to be destroyed.
+ */
+void
+t9_astar_destroy(t9_astar_t *const astar);
+
+/*!
+ * Create a copy of an A* decoder holding the same keys and search.
+ * @note The user is responsible for destroying the copy using t9_astar_destroy once it is no longer required.
+ * @param astar Pointer to an A* decoder to be copied.
+ * @return Pointer to a new A* decoder. NULL if an error occurred.
+ */
+t9_astar_t *
+t9_astar_clone(const t9_astar_t *const astar);
+
+/*!
+ * Reset a decoder, so that the next key typed starts a new sequence.
+ * @param astar Pointer to a decoder that is to be reset.
+ */
+void
+t9_astar_reset(t9_astar_t *const astar);
+
+/*!
+ * Append lexicon symbols to the sequence of a decoder and search the best hypothesis of the whole sequence.
+ * The search continues from the complete hypotheses of the previous keys, so a key only expands the states that can
+ * compete with the best hypothesis of the new sequence.
+ * @param astar Pointer to a decoder.
+ * @param sequence Pointer to a string of lexicon symbols to be appended.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_astar_type(t9_astar_t *const astar,
+              const t9_symbol_t *const sequence);
+
+/*!
+ * Get the best text suggestion for the sequence typed into a decoder.
+ * @note The user is responsible for destroying the suggestion using free once it is no longer required.
+ * @param astar Pointer to a decoder to query.
+ * @param suggestion Pointer to a variable where the pointer to the resulting string is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_astar_suggestion(const t9_astar_t *const astar,
+                    t9_symbol_t **suggestion);
+
+/*!
+ * Write the best suggestions for the sequence typed into a decoder.
+ * The search continues until capacity complete hypotheses are found, these are the best hypotheses of the context
+ * states the sequence can end in, like the ones of the Viterbi decoder. Continuing the search may grow the buffers
+ * of the decoder.
+ * @param astar Pointer to a decoder to query.
+ * @param suggestions Pointer to a buffer of capacity rows of stride symbols each. Suggestion i is written zero
+ * terminated to row i.
+ * @param stride Number of symbols per row. Must be at least the number of keys typed plus one.
+ * @param scores Pointer to an array of capacity scores. Score i is the negative log probability of suggestion i.
+ * @param capacity Maximal number of suggestions to be written.
+ * @param count Pointer to a variable where the number of suggestions written is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_astar_nbest(t9_astar_t *const astar,
+               t9_symbol_t *const suggestions,
+               size_t stride,
+               float *const scores,
+               size_t capacity,
+               size_t *const count);
+
+/*!
+ * Helper function used to search the best hypotheses of the sequence typed into a decoder.
+ * The search continues from the queue of the previous search, a new search is started if there is none.
+ * @param astar Pointer to a decoder.
+ * @param number_finals Number of complete hypotheses to be found.
+ * @return T9_SUCCESS if at least one complete hypothesis was found, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_astar_search(t9_astar_t *const astar,
+                  size_t number_finals);
+
+/*!
+ * Helper function used to find the slot of a context state after a number of keys, growing the table if necessary.
+ * @param astar Pointer to a decoder.
+ * @param key Key of the state, derived from the position and the state. Must not be 0.
+ * @return Pointer to the slot of the state. NULL if an error occurred.
+ */
+t9_astar_slot_t *
+__t9_astar_slot(t9_astar_t *const astar,
+                uint64_t key);
+
+/*!
+ * Helper function used to add a hypothesis to the priority queue.
+ * @param astar Pointer to a decoder.
+ * @param item Item to be added.
+ */
+void
+__t9_astar_heap_push(t9_astar_t *const astar,
+                     t9_astar_item_t item);
+
+/*!
+ * Helper function used to take the item with the lowest priority from the priority queue.
+ * @param astar Pointer to a decoder with a non-empty queue.
+ * @param item Pointer to a variable where the item with the lowest priority is placed.
+ */
+void
+__t9_astar_heap_pop(t9_astar_t *const astar,
+                    t9_astar_item_t *const item);
+
+#endif //C_T9_ASTAR_H
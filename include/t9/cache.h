@@ -0,0 +1,239 @@
+/*!
+  ******************************************************************************
+  * @file    cache.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for cache.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_CACHE_H
+#define C_T9_CACHE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward declarations of cache to break cyclic redundancy.
+struct struct_t9_cache_t;
+typedef struct struct_t9_cache_t t9_cache_t;
+
+#include "t9/errno.h"
+#include "t9/corpus.h"
+#include "t9/metrics.h"
+#include "t9/session.h"
+
+// Initial number of hash buckets of a cache. The number is doubled whenever there are more entries than buckets.
+#define T9_CACHE_BUCKETS 1024
+
+// Parameters of the FNV-1a hash of key sequences.
+#define T9_CACHE_HASH_OFFSET 14695981039346656037ULL
+#define T9_CACHE_HASH_PRIME 1099511628211ULL
+
+/*!
+ * Entry of a cache. Holds the serialized state of a session after typing a key sequence.
+ * Entries are chained within their hash bucket and linked in the order of their last use.
+ */
+struct struct_t9_cache_entry_t {
+    uint64_t hash;
+    t9_symbol_t *keys;
+    size_t length;
+    uint8_t *state;
+    size_t size;
+    struct struct_t9_cache_entry_t *chain;
+    struct struct_t9_cache_entry_t *newer;
+    struct struct_t9_cache_entry_t *older;
+};
+
+typedef struct struct_t9_cache_entry_t t9_cache_entry_t;
+
+/*!
+ * Statistics of a cache.
+ * The memory counts the entries, their key sequences and their serialized states.
+ */
+struct struct_t9_cache_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t number_entries;
+    size_t memory;
+    size_t capacity;
+};
+
+typedef struct struct_t9_cache_stats_t t9_cache_stats_t;
+
+/*!
+ * Bounded least recently used cache from key sequences to decoder states.
+ * Sessions resume from the state of the longest cached prefix of their key sequence and only decode the remaining
+ * keys. Once the memory of all entries exceeds the capacity, the least recently used entries are evicted. A cache can
+ * be shared by the sessions of any number of threads.
+ */
+struct struct_t9_cache_t {
+    t9_cache_entry_t **buckets;
+    size_t number_buckets;
+    size_t number_entries;
+    size_t memory;
+    size_t capacity;
+    t9_cache_entry_t *newest;
+    t9_cache_entry_t *oldest;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    pthread_mutex_t lock;
+};
+
+typedef struct struct_t9_cache_t t9_cache_t;
+
+/*!
+ * Create a cache.
+ * @note The user is responsible for destroying the cache using t9_cache_destroy once it is no longer required.
+ * @param capacity Maximal memory of all entries in bytes.
+ * @return Pointer to a new cache. NULL if an error occurred.
+ */
+t9_cache_t *
+t9_cache_create(size_t capacity);
+
+/*!
+ * Destroy a cache and all of its entries.
+ * @param cache Pointer to a cache to be destroyed.
+ */
+void
+t9_cache_destroy(t9_cache_t *const cache);
+
+/*!
+ * Store the state of a session under the key sequence that was typed into it.
+ * An existing entry of the sequence is replaced. States larger than the capacity are not stored.
+ * @param cache Pointer to a cache.
+ * @param sequence Pointer to the lexicon sequence typed into the session.
+ * @param session Pointer to the session whose state is to be stored.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_cache_store(t9_cache_t *const cache,
+               const t9_symbol_t *const sequence,
+               const t9_session_t *const session);
+
+/*!
+ * Restore a session that typed the first keys of a sequence to the state of the longest cached prefix of the
+ * sequence, if that prefix is longer than the keys typed. Otherwise a session without keys typed is reset, and any
+ * other session keeps its state. Only lookups of prefixes longer than the keys typed count as hit or miss, in the
+ * statistics of the cache and in the metrics of the session.
+ * @param cache Pointer to a cache.
+ * @param session Pointer to the session to be restored.
+ * @param sequence Pointer to a lexicon sequence.
+ * @param typed Number of keys of the sequence the session typed already, 0 for a session starting over.
+ * @param restored Pointer to a variable where the number of keys of the sequence the session holds afterwards is
+ * placed. typed if no longer prefix is cached.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_cache_restore(t9_cache_t *const cache,
+                 t9_session_t *const session,
+                 const t9_symbol_t *const sequence,
+                 size_t typed,
+                 size_t *const restored);
+
+/*!
+ * Type the remaining keys of a sequence into a session that typed its first keys already, resuming from the longest
+ * cached prefix of the sequence. With 0 keys typed, the sequence is typed from scratch.
+ * The state after the whole sequence is stored in the cache, so that the sequence serves as prefix of later ones.
+ * @note The output of the session is not part of cached states, therefore sessions with an output are not supported.
+ * @param cache Pointer to a cache.
+ * @param session Pointer to a session without output.
+ * @param sequence Pointer to a string of lexicon symbols, all keys the session is to hold.
+ * @param typed Number of keys of the sequence the session typed already.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_cache_type(t9_cache_t *const cache,
+              t9_session_t *const session,
+              const t9_symbol_t *const sequence,
+              size_t typed);
+
+/*!
+ * Get the statistics of a cache.
+ * @param cache Pointer to a cache.
+ * @param stats Pointer to a structure where the statistics are placed.
+ */
+void
+t9_cache_stats(t9_cache_t *const cache,
+               t9_cache_stats_t *const stats);
+
+/*!
+ * Helper function used to find the entry of a key sequence. The cache has to be locked.
+ * @param cache Pointer to a cache.
+ * @param keys Pointer to the key sequence. Not zero terminated.
+ * @param length Length of the key sequence.
+ * @param hash Hash of the key sequence.
+ * @return Pointer to the entry. NULL if the sequence is not cached.
+ */
+t9_cache_entry_t *
+__t9_cache_find(const t9_cache_t *const cache,
+                const t9_symbol_t *const keys,
+                size_t length,
+                uint64_t hash);
+
+/*!
+ * Helper function used to mark an entry as the most recently used one. The cache has to be locked.
+ * @param cache Pointer to a cache.
+ * @param entry Pointer to an entry of the cache.
+ */
+void
+__t9_cache_touch(t9_cache_t *const cache,
+                 t9_cache_entry_t *const entry);
+
+/*!
+ * Helper function used to remove an entry from a cache and destroy it. The cache has to be locked.
+ * @param cache Pointer to a cache.
+ * @param entry Pointer to an entry of the cache.
+ */
+void
+__t9_cache_remove(t9_cache_t *const cache,
+                  t9_cache_entry_t *const entry);
+
+/*!
+ * Helper function used to double the number of hash buckets of a cache. The cache has to be locked.
+ * @param cache Pointer to a cache.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_cache_grow(t9_cache_t *const cache);
+
+/*!
+ * Helper function used to extend the hash of a key sequence by a key.
+ * @param hash Hash of the key sequence.
+ * @param key Key appended to the sequence.
+ * @return Hash of the extended key sequence.
+ */
+uint64_t
+__t9_cache_hash(uint64_t hash,
+                t9_symbol_t key);
+
+#endif //C_T9_CACHE_H
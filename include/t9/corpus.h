@@ -74,7 +74,7 @@ typedef uint8_t t9_symbol_t;
 #define NUM_LEXICON_SYMBOLS 12
 
 // Number of corpus symbols.
-#define NUM_CORPUS_SYMBOLS  1 + 3 + 7 + 7 + 7 + 7 + 7 + 9 + 7 + 9 + 1
+#define NUM_CORPUS_SYMBOLS  (1 + 3 + 7 + 7 + 7 + 7 + 7 + 9 + 7 + 9 + 1)
 
 
 /*!
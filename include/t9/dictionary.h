@@ -0,0 +1,428 @@
+/*!
+  ******************************************************************************
+  * @file    dictionary.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for dictionary.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_DICTIONARY_H
+#define C_T9_DICTIONARY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libraries/kvec/kvec.h"
+
+// Forward declarations of dictionary to break cyclic redundancy.
+struct struct_t9_dictionary_t;
+typedef struct struct_t9_dictionary_t t9_dictionary_t;
+
+struct struct_t9_dictionary_node_t;
+typedef struct struct_t9_dictionary_node_t t9_dictionary_node_t;
+
+// Vector of dictionary words.
+// Note: kvec_t can not be used, because it defines the same struct name for every vector.
+#define kvec_dword_t(type) struct struct_kvec_dword {size_t n, m; type *a; }
+#define kvec_dcompletion_t(type) struct struct_kvec_dcompletion {size_t n, m; type *a; }
+
+#include "t9/errno.h"
+#include "t9/corpus.h"
+
+// Keys whose symbols separate words instead of being part of them.
+#define T9_DICTIONARY_SEPARATORS "1*#"
+
+typedef kvec_dword_t(struct struct_t9_dictionary_word_t) t9_dictionary_word_vector_t;
+
+/*!
+ * Header of a dictionary within a model file, followed by number_entries entries. Every entry is a record of a word,
+ * its symbols and number_next records of the words following it, each followed by its symbols.
+ */
+struct struct_t9_dictionary_header_t {
+    uint64_t number_entries;
+    uint64_t number_occurrences;
+    uint32_t max_length;
+    uint16_t number_words;
+};
+
+typedef struct struct_t9_dictionary_header_t t9_dictionary_header_t;
+
+/*!
+ * Record of a word of a dictionary within a model file. number_next is 0 for the records of following words.
+ */
+struct struct_t9_dictionary_record_t {
+    uint64_t count;
+    uint32_t length;
+    uint32_t number_next;
+};
+
+typedef struct struct_t9_dictionary_record_t t9_dictionary_record_t;
+
+/*!
+ * Word of a dictionary together with the number of its occurrences and the words that follow it. Only words separated
+ * by spaces count as following each other. Until finalized, the following words are sorted by their symbols, once
+ * finalized only the most frequent ones remain.
+ */
+struct struct_t9_dictionary_word_t {
+    t9_symbol_t *word;
+    uint64_t count;
+    t9_dictionary_word_vector_t next;
+};
+
+typedef struct struct_t9_dictionary_word_t t9_dictionary_word_t;
+
+typedef kvec_dcompletion_t(const t9_dictionary_word_t *) t9_dictionary_completion_vector_t;
+
+/*!
+ * Node of a dictionary. The path from the root to a node spells a key sequence, the node holds the words typed with
+ * exactly this sequence. Until finalized, the words are sorted by their symbols, so that counting a word is a binary
+ * search. Once finalized, only the most frequent words remain, the most frequent one first.
+ * Finalizing also caches the most frequent words starting with the key sequence of the node, its completions.
+ */
+struct struct_t9_dictionary_node_t {
+    struct struct_t9_dictionary_node_t *children[NUM_LEXICON_SYMBOLS];
+    t9_dictionary_word_vector_t words;
+    t9_dictionary_completion_vector_t completions;
+};
+
+typedef struct struct_t9_dictionary_node_t t9_dictionary_node_t;
+
+/*!
+ * Word level T9 dictionary. A trie over key sequences, whose nodes hold the most frequent words of their key
+ * sequence. Words are runs of symbols between the symbols of the keys in T9_DICTIONARY_SEPARATORS.
+ * Looking up the words of a key sequence takes one step per key.
+ */
+struct struct_t9_dictionary_t {
+    t9_dictionary_node_t *root;
+    uint16_t number_words;
+    size_t number_nodes;
+    uint64_t number_occurrences;
+};
+
+typedef struct struct_t9_dictionary_t t9_dictionary_t;
+
+/*!
+ * Create an empty dictionary.
+ * @note The user is responsible for destroying the dictionary using t9_dictionary_destroy once it is no longer
+ * required.
+ * @param number_words Number of most frequent words kept per key sequence once the dictionary is finalized.
+ * @return Pointer to a new dictionary. NULL if an error occurred.
+ */
+t9_dictionary_t *
+t9_dictionary_create(uint16_t number_words);
+
+/*!
+ * Destroy a dictionary.
+ * @param dictionary Pointer to a dictionary to be destroyed.
+ */
+void
+t9_dictionary_destroy(t9_dictionary_t *const dictionary);
+
+/*!
+ * Count the occurrences of a word.
+ * @param dictionary Pointer to a dictionary that is not finalized yet.
+ * @param word Pointer to the symbols of the word. Not zero terminated.
+ * @param length Number of symbols of the word.
+ * @param count Number of occurrences to be added.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE. Words containing symbols that can not be typed or separate words
+ * are rejected.
+ */
+t9_error_t
+t9_dictionary_insert_word(t9_dictionary_t *const dictionary,
+                          const t9_symbol_t *const word,
+                          size_t length,
+                          uint64_t count);
+
+/*!
+ * Count the occurrences of all words of the training part of a corpus.
+ * @param dictionary Pointer to a dictionary that is not finalized yet.
+ * @param corpus Pointer to a corpus.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_dictionary_insert_corpus(t9_dictionary_t *const dictionary,
+                            const corpus_t *const corpus);
+
+/*!
+ * Rank the words of every key sequence by their number of occurrences and keep the most frequent ones.
+ * @param dictionary Pointer to a dictionary.
+ */
+void
+t9_dictionary_finalize(t9_dictionary_t *const dictionary);
+
+/*!
+ * Find the node of a key sequence.
+ * @param dictionary Pointer to a dictionary.
+ * @param sequence Pointer to a zero terminated lexicon sequence.
+ * @return Pointer to the node. NULL if no word starts with the key sequence.
+ */
+const t9_dictionary_node_t *
+t9_dictionary_lookup(const t9_dictionary_t *const dictionary,
+                     const t9_symbol_t *const sequence);
+
+/*!
+ * Get the most frequent words typed with exactly a given key sequence.
+ * @param dictionary Pointer to a finalized dictionary.
+ * @param sequence Pointer to a zero terminated lexicon sequence.
+ * @param words Pointer to a variable where the pointer to the words is placed, the most frequent one first. The words
+ * belong to the dictionary.
+ * @param count Pointer to a variable where the number of words is placed. 0 if the sequence does not spell a word.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_dictionary_words(const t9_dictionary_t *const dictionary,
+                    const t9_symbol_t *const sequence,
+                    const t9_dictionary_word_t **words,
+                    size_t *const count);
+
+/*!
+ * Get the most frequent words starting with a given key sequence, the completions of a partially typed word.
+ * The completions are cached when the dictionary is finalized, so nothing is searched.
+ * @param dictionary Pointer to a finalized dictionary.
+ * @param sequence Pointer to a zero terminated lexicon sequence.
+ * @param completions Pointer to a variable where the pointer to the completions is placed, the most frequent one first.
+ * The completions belong to the dictionary.
+ * @param count Pointer to a variable where the number of completions is placed. 0 if no word starts with the sequence.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_dictionary_complete(const t9_dictionary_t *const dictionary,
+                       const t9_symbol_t *const sequence,
+                       const t9_dictionary_word_t *const **completions,
+                       size_t *const count);
+
+/*!
+ * Find a word of a dictionary.
+ * @param dictionary Pointer to a dictionary.
+ * @param word Pointer to a zero terminated word.
+ * @return Pointer to the word. NULL if the word is not part of the dictionary. Once finalized, only the most frequent
+ * words of every key sequence can be found.
+ */
+const t9_dictionary_word_t *
+t9_dictionary_find(const t9_dictionary_t *const dictionary,
+                   const t9_symbol_t *const word);
+
+/*!
+ * Find the keys of the last word of a key sequence, the word that is being typed.
+ * @param sequence Pointer to a zero terminated lexicon sequence.
+ * @return Pointer to the first key following the last key in T9_DICTIONARY_SEPARATORS, the end of the sequence if it
+ * ends with a separator.
+ */
+const t9_symbol_t *
+t9_dictionary_last_word(const t9_symbol_t *const sequence);
+
+/*!
+ * Write a dictionary to a file. Only the words kept by finalizing are written.
+ * @param dictionary Pointer to a finalized dictionary.
+ * @param fp Pointer to a file opened for writing.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_dictionary_write(const t9_dictionary_t *const dictionary,
+                    FILE *const fp);
+
+/*!
+ * Read a dictionary written by t9_dictionary_write. The dictionary is finalized again, which ranks its words and
+ * caches their completions as before.
+ * @note The user is responsible for destroying the dictionary using t9_dictionary_destroy once it is no longer
+ * required.
+ * @param fp Pointer to a file opened for reading.
+ * @param dictionary Pointer to a variable where the pointer to the new dictionary is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_dictionary_read(FILE *const fp,
+                   t9_dictionary_t **dictionary);
+
+/*!
+ * Helper function used to count the occurrences of a word.
+ * @param dictionary Pointer to a dictionary that is not finalized yet.
+ * @param word Pointer to the symbols of the word. Not zero terminated.
+ * @param length Number of symbols of the word.
+ * @param count Number of occurrences to be added.
+ * @param node Pointer to a variable where the node of the word is placed.
+ * @param index Pointer to a variable where the index of the word within the words of the node is placed. It is valid
+ * until the next word is inserted into the node.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_dictionary_insert(t9_dictionary_t *const dictionary,
+                       const t9_symbol_t *const word,
+                       size_t length,
+                       uint64_t count,
+                       t9_dictionary_node_t **node,
+                       size_t *const index);
+
+/*!
+ * Helper function used to count the occurrences of a word, if the word is not known yet it is added.
+ * The word is found by a binary search, a new word is inserted at its position, moving the words behind it.
+ * @param words Pointer to a vector of words sorted by their symbols.
+ * @param word Pointer to the symbols of the word. Not zero terminated.
+ * @param length Number of symbols of the word.
+ * @param count Number of occurrences to be added.
+ * @param index Pointer to a variable where the index of the word within the vector is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_dictionary_count(t9_dictionary_word_vector_t *const words,
+                      const t9_symbol_t *const word,
+                      size_t length,
+                      uint64_t count,
+                      size_t *const index);
+
+/*!
+ * Helper function used to order a zero terminated word and the symbols of a word that is not zero terminated.
+ * @param word Pointer to a zero terminated word.
+ * @param symbols Pointer to the symbols of a word.
+ * @param length Number of symbols.
+ * @return Negative if the word comes first, positive if the symbols come first, 0 if both are equal.
+ */
+int
+__t9_dictionary_compare_symbols(const t9_symbol_t *const word,
+                                const t9_symbol_t *const symbols,
+                                size_t length);
+
+/*!
+ * Helper function used to rank a vector of words and free all but the most frequent ones.
+ * @param words Pointer to a vector of words.
+ * @param number_words Number of words to be kept.
+ */
+void
+__t9_dictionary_truncate(t9_dictionary_word_vector_t *const words,
+                         uint16_t number_words);
+
+/*!
+ * Helper function used to free the symbols and following words of a vector of words.
+ * @param words Pointer to a vector of words.
+ */
+void
+__t9_dictionary_free_words(t9_dictionary_word_vector_t *const words);
+
+/*!
+ * Helper function used to gather the number of words and the length of the longest word of a node and all of its
+ * descendants.
+ * @param node Pointer to a node.
+ * @param header Pointer to a header, whose number of entries and maximal length are updated.
+ */
+void
+__t9_dictionary_node_measure(const t9_dictionary_node_t *const node,
+                             t9_dictionary_header_t *const header);
+
+/*!
+ * Helper function used to write the words of a node and all of its descendants.
+ * @param node Pointer to a node.
+ * @param fp Pointer to a file opened for writing.
+ * @return true on success, false if an error occurred.
+ */
+bool
+__t9_dictionary_node_write(const t9_dictionary_node_t *const node,
+                           FILE *const fp);
+
+/*!
+ * Helper function used to write the record of a word and its symbols.
+ * @param word Pointer to a word.
+ * @param number_next Number of following words written after the record.
+ * @param fp Pointer to a file opened for writing.
+ * @return true on success, false if an error occurred.
+ */
+bool
+__t9_dictionary_write_word(const t9_dictionary_word_t *const word,
+                           size_t number_next,
+                           FILE *const fp);
+
+/*!
+ * Helper function used to read the record of a word and its symbols. The symbols have to be word symbols.
+ * @param fp Pointer to a file opened for reading.
+ * @param max_length Maximal length of the word.
+ * @param record Pointer to the record to be read.
+ * @param symbols Pointer to a buffer of at least max_length symbols, the symbols are read into.
+ * @return true on success, false if an error occurred or the word is invalid.
+ */
+bool
+__t9_dictionary_read_word(FILE *const fp,
+                          uint32_t max_length,
+                          t9_dictionary_record_t *const record,
+                          t9_symbol_t *const symbols);
+
+/*!
+ * Helper function used to create a dictionary node.
+ * @return Pointer to a new node. NULL if an error occurred.
+ */
+t9_dictionary_node_t *
+__t9_dictionary_node_create(void);
+
+/*!
+ * Helper function used to destroy a dictionary node together with all of its descendants.
+ * @param node Pointer to a node to be destroyed.
+ */
+void
+__t9_dictionary_node_destroy(t9_dictionary_node_t *const node);
+
+/*!
+ * Helper function used to rank and truncate the words of a node and all of its descendants and to cache their
+ * completions.
+ * @param node Pointer to a node.
+ * @param number_words Number of words to be kept per node.
+ */
+void
+__t9_dictionary_node_finalize(t9_dictionary_node_t *const node,
+                              uint16_t number_words);
+
+/*!
+ * Helper function used to sort dictionary words with qsort, the most frequent word first.
+ * @param a Pointer to a dictionary word.
+ * @param b Pointer to a dictionary word.
+ * @return Order of the words.
+ */
+int
+__t9_dictionary_compare_words(const void *a,
+                              const void *b);
+
+/*!
+ * Helper function used to sort completions with qsort, the most frequent word first.
+ * @param a Pointer to a pointer to a dictionary word.
+ * @param b Pointer to a pointer to a dictionary word.
+ * @return Order of the words.
+ */
+int
+__t9_dictionary_compare_completions(const void *a,
+                                    const void *b);
+
+/*!
+ * Helper function used to find the key a word symbol is typed with.
+ * @param symbol Corpus symbol.
+ * @return Lexicon index of the key. NUM_LEXICON_SYMBOLS if the symbol is not part of words.
+ */
+size_t
+__t9_dictionary_key(t9_symbol_t symbol);
+
+#endif //C_T9_DICTIONARY_H
@@ -38,6 +38,9 @@
 #include <math.h>
 #include <float.h>
 
+// Resolution of the scores of the beam search decoder.
+#define T9_SCORE_RESOLUTION (1.0 / 1048576.0)
+
 /*!
  * Wrapper around y = log(x), that calculates y = log(x + DBL_MIN) and limits y to 1.0.
  * @param x Value.
@@ -46,4 +49,15 @@
 float
 t9_ln(float x);
 
+/*!
+ * Round a score of the beam search decoder to a multiple of T9_SCORE_RESOLUTION.
+ * Sums and differences of such scores are exact as long as they stay below 2^33, so a score does not depend on the
+ * offset it is computed relative to. A session committing its output therefore decodes exactly like one that does
+ * not.
+ * @param score Score to be rounded.
+ * @return The multiple of T9_SCORE_RESOLUTION closest to the score.
+ */
+double
+t9_score_round(double score);
+
 #endif //C_T9_MATH_H
@@ -0,0 +1,200 @@
+/*!
+  ******************************************************************************
+  * @file    metrics.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for metrics.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_METRICS_H
+#define C_T9_METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward declarations of metrics to break cyclic redundancy.
+struct struct_t9_metrics_t;
+typedef struct struct_t9_metrics_t t9_metrics_t;
+
+#include "t9/errno.h"
+
+// Counters of decoding events and of lookups of the cache of decoder states.
+#define T9_METRICS_KEYS             0
+#define T9_METRICS_NODES_EXPANDED   1
+#define T9_METRICS_NODES_PRUNED     2
+#define T9_METRICS_PATHS            3
+#define T9_METRICS_CACHE_HITS       4
+#define T9_METRICS_CACHE_MISSES     5
+#define T9_METRICS_NUMBER_COUNTERS  6
+
+// Histograms of durations in nanoseconds and of beam sizes in nodes.
+#define T9_METRICS_INSERT             0
+#define T9_METRICS_SEARCH             1
+#define T9_METRICS_PRUNE              2
+#define T9_METRICS_BEAM               3
+#define T9_METRICS_NUMBER_HISTOGRAMS  4
+
+// Names of the counters and histograms in the Prometheus text format.
+#define T9_METRICS_COUNTER_NAMES {"t9_keys_total", "t9_nodes_expanded_total", "t9_nodes_pruned_total", "t9_paths_total", \
+                                  "t9_cache_hits_total", "t9_cache_misses_total"}
+#define T9_METRICS_HISTOGRAM_NAMES {"t9_insert_seconds", "t9_search_seconds", "t9_prune_seconds", "t9_beam_nodes"}
+
+// Every power of two is split into this many buckets, so values are recorded with a relative error below 1/16.
+#define T9_HISTOGRAM_SUB_BITS     4
+#define T9_HISTOGRAM_SUB_BUCKETS  (1 << T9_HISTOGRAM_SUB_BITS)
+
+// Values of 2^T9_HISTOGRAM_MAX_EXPONENT and above are recorded in the last bucket.
+#define T9_HISTOGRAM_MAX_EXPONENT  40
+#define T9_HISTOGRAM_BUCKETS  ((T9_HISTOGRAM_MAX_EXPONENT - T9_HISTOGRAM_SUB_BITS + 1) * T9_HISTOGRAM_SUB_BUCKETS)
+
+/*!
+ * Histogram with logarithmic buckets that are split linearly, as in HDR histograms.
+ */
+struct struct_t9_histogram_t {
+    atomic_uint_fast64_t buckets[T9_HISTOGRAM_BUCKETS];
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sum;
+};
+
+typedef struct struct_t9_histogram_t t9_histogram_t;
+
+/*!
+ * Decoding metrics of a single thread.
+ * Only the owning thread writes to a shard, so updates are plain relaxed loads and stores without locks. Other
+ * threads may read all shards at any time to export them.
+ */
+struct struct_t9_metrics_t {
+    atomic_uint_fast64_t counters[T9_METRICS_NUMBER_COUNTERS];
+    t9_histogram_t histograms[T9_METRICS_NUMBER_HISTOGRAMS];
+};
+
+typedef struct struct_t9_metrics_t t9_metrics_t;
+
+/*!
+ * Create an empty metrics shard.
+ * @note The user is responsible for destroying the shard using t9_metrics_destroy once it is no longer required.
+ * @return Pointer to a new shard. NULL if an error occurred.
+ */
+t9_metrics_t *
+t9_metrics_create(void);
+
+/*!
+ * Destroy a metrics shard.
+ * @param metrics Pointer to a shard to be destroyed.
+ */
+void
+t9_metrics_destroy(t9_metrics_t *const metrics);
+
+/*!
+ * Add to a counter. Must only be called by the thread owning the shard.
+ * @param metrics Pointer to a shard.
+ * @param counter Counter, one of T9_METRICS_KEYS to T9_METRICS_CACHE_MISSES.
+ * @param value Value to be added.
+ */
+void
+t9_metrics_add(t9_metrics_t *const metrics,
+               size_t counter,
+               uint64_t value);
+
+/*!
+ * Record a value in a histogram. Must only be called by the thread owning the shard.
+ * @param metrics Pointer to a shard.
+ * @param histogram Histogram, one of T9_METRICS_INSERT to T9_METRICS_BEAM.
+ * @param value Value to be recorded.
+ */
+void
+t9_metrics_record(t9_metrics_t *const metrics,
+                  size_t histogram,
+                  uint64_t value);
+
+/*!
+ * Sum up shards.
+ * @param metrics Pointer to a shard the sum is added to.
+ * @param shards Pointer to the shards to be added.
+ * @param number_shards Number of shards.
+ */
+void
+t9_metrics_merge(t9_metrics_t *const metrics,
+                 t9_metrics_t *const *const shards,
+                 size_t number_shards);
+
+/*!
+ * Get a quantile of a histogram.
+ * @param histogram Pointer to a histogram.
+ * @param quantile Quantile between 0 and 1.
+ * @return Upper bound of the bucket holding the quantile. 0 if the histogram is empty.
+ */
+uint64_t
+t9_histogram_quantile(const t9_histogram_t *const histogram,
+                      double quantile);
+
+/*!
+ * Write the sum of shards in the Prometheus text format.
+ * Counters are written as counters, histograms as summaries with the quantiles 0.5, 0.99 and 0.999. Durations are
+ * converted to seconds.
+ * @param shards Pointer to the shards to be written.
+ * @param number_shards Number of shards.
+ * @param stream Stream to be written to.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_metrics_write(t9_metrics_t *const *const shards,
+                 size_t number_shards,
+                 FILE *const stream);
+
+/*!
+ * Helper function used to find the bucket of a value.
+ * @param value Value.
+ * @return Index of the bucket.
+ */
+size_t
+__t9_histogram_bucket(uint64_t value);
+
+/*!
+ * Helper function used to get the largest value of a bucket.
+ * @param bucket Index of the bucket.
+ * @return Largest value recorded in the bucket.
+ */
+uint64_t
+__t9_histogram_bucket_limit(size_t bucket);
+
+/*!
+ * Helper function used to add a value to a counter owned by the calling thread.
+ * @param counter Pointer to a counter.
+ * @param value Value to be added.
+ */
+void
+__t9_metrics_increment(atomic_uint_fast64_t *const counter,
+                       uint64_t value);
+
+#endif //C_T9_METRICS_H
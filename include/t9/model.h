@@ -39,26 +39,203 @@
 struct t9_model_struct;
 typedef struct t9_model_struct t9_model_t;
 
+#define kvec_window_t(type) struct struct_kvec_window {size_t n, m; type *a; }
+
 #include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
 #include "libraries/kvec/kvec.h"
 
 #include "t9/tree.h"
 #include "t9/path.h"
+#include "t9/session.h"
+#include "t9/pool.h"
+#include "t9/timer.h"
+#include "t9/viterbi.h"
+#include "t9/astar.h"
+#include "t9/table.h"
+#include "t9/dictionary.h"
+
+// Decoders a model can use to search the best text suggestions.
+#define T9_DECODER_BEAM     0
+#define T9_DECODER_VITERBI  1
+#define T9_DECODER_ASTAR    2
+
+typedef uint8_t t9_decoder_t;
+
+// Maximal number of symbols in a single evaluation window.
+#define T9_EVALUATION_WINDOW_LENGTH 140
+
+// Number of chunks per pool thread, a batch with shared prefixes is split into.
+#define T9_BATCH_CHUNKS_PER_THREAD 4
+
+// Magic number and version of model files.
+#define T9_MODEL_MAGIC "T9MD"
+#define T9_MODEL_VERSION 3
+
+// Optional sections of a model file, which follow the corpus tree in this order.
+#define T9_MODEL_SECTION_DICTIONARY 1
+#define T9_MODEL_SECTION_TABLE 2
+
+/*!
+ * Header of a model file. Holds the decoding parameters, followed by number_nodes records of the corpus tree.
+ * tree_length is the depth of the corpus tree, it limits ngram_length and rescore_length. sections holds the flags of
+ * the optional sections following the corpus tree.
+ */
+struct struct_t9_model_header_t {
+    char magic[4];
+    uint32_t version;
+    uint8_t decoder;
+    uint8_t ngram_length;
+    uint8_t rescore_length;
+    uint8_t tree_length;
+    uint8_t sections;
+    uint16_t number_paths;
+    uint16_t paths_per_context;
+    uint16_t rescore_paths;
+    float beam_threshold;
+    uint64_t number_nodes;
+};
+
+typedef struct struct_t9_model_header_t t9_model_header_t;
+
+/*!
+ * Record of a corpus tree node in a model file. The nodes are stored depth first, every node is followed by its
+ * number_children children.
+ */
+struct struct_t9_model_node_t {
+    uint64_t count;
+    float probability;
+    uint32_t number_children;
+    t9_symbol_t symbol;
+};
+
+typedef struct struct_t9_model_node_t t9_model_node_t;
 
 /*!
  * T9 model.
+ * The model only holds data that does not change while decoding. Once built, it can be shared by any number of
+ * sessions (see session.h) across threads.
+ *
+ * Decoding parameters:
+ * - ngram_length: Ngram length used to look up symbol probabilities.
+ * - number_paths: Number of best paths that survive pruning after every key.
+ * - paths_per_context: Number of hypotheses kept for every context of (ngram_length - 1) symbols. Hypotheses sharing
+ *   their context have identical futures, so all but the best ones can be recombined. 0 disables recombination.
+ * - beam_threshold: Hypotheses whose score is worse than the best score plus this threshold are pruned after every
+ *   key. The beam therefore narrows on unambiguous input, number_paths remains its maximal width. 0 disables it.
+ * - rescore_length: Ngram length of a second pass. After every key, the number_paths best paths of the first pass
+ *   (ngram_length) are rescored with ngrams of this length, and the best rescored paths survive. The corpus tree has
+ *   to be built with at least this length, like it has to for ngram_length (see t9_session_create). 0 disables
+ *   rescoring.
+ * - rescore_paths: Number of rescored paths that survive every key. 0 keeps all number_paths paths.
+ * - decoder: T9_DECODER_BEAM searches a pruned search tree, T9_DECODER_VITERBI and T9_DECODER_ASTAR decode exactly
+ *   over the context states compiled into viterbi (see t9_model_set_decoder). The exact decoders ignore number_paths,
+ *   paths_per_context, beam_threshold and the rescoring.
+ * - table: Precomputed results of the first keys of every sequence (see t9_model_set_table). NULL if there is none.
+ * - dictionary: Finalized word dictionary of the corpus, which completes the word being typed (see dictionary.h). NULL
+ *   if there is none.
  */
 struct t9_model_struct {
     corpus_t corpus;
     t9_corpus_tree_t *corpus_tree;
-    t9_search_tree_t *search_tree;
-    t9_path_vector_t paths;
     uint8_t ngram_length;
     uint16_t number_paths;
+    uint16_t paths_per_context;
+    float beam_threshold;
+    uint8_t rescore_length;
+    uint16_t rescore_paths;
+    t9_decoder_t decoder;
+    t9_viterbi_t *viterbi;
+    t9_table_t *table;
+    t9_dictionary_t *dictionary;
 };
 
 typedef struct t9_model_struct t9_model_t;
 
+/*!
+ * Sequence of a batch together with its position in the batch. Used to sort a batch by its sequences.
+ */
+struct struct_t9_model_batch_entry_t {
+    const t9_symbol_t *sequence;
+    size_t index;
+};
+
+typedef struct struct_t9_model_batch_entry_t t9_model_batch_entry_t;
+
+/*!
+ * Job description of a batch autocompletion.
+ * A batch decoded with shared prefixes holds its sequences sorted, split into number_chunks consecutive chunks.
+ */
+struct struct_t9_model_batch_t {
+    const t9_symbol_t *const *sequences;
+    t9_symbol_t **suggestions;
+    t9_session_t **sessions;
+    t9_error_t *errors;
+    t9_model_batch_entry_t *entries;
+    size_t count;
+    size_t number_chunks;
+};
+
+typedef struct struct_t9_model_batch_t t9_model_batch_t;
+
+/*!
+ * Part of the test corpus that is evaluated independently of all other parts.
+ */
+struct struct_t9_evaluation_window_t {
+    size_t offset;
+    size_t length;
+    size_t symbol_errors;
+    size_t words;
+    size_t word_errors;
+    double duration_ms;
+    t9_error_t error;
+};
+
+typedef struct struct_t9_evaluation_window_t t9_evaluation_window_t;
+
+typedef kvec_window_t(t9_evaluation_window_t) t9_evaluation_window_vector_t;
+
+/*!
+ * Job description of a windowed evaluation.
+ */
+struct struct_t9_model_evaluation_job_t {
+    const t9_model_t *model;
+    t9_evaluation_window_t *windows;
+    t9_session_t **sessions;
+};
+
+typedef struct struct_t9_model_evaluation_job_t t9_model_evaluation_job_t;
+
+/*!
+ * Aggregated result of a model evaluation.
+ */
+struct struct_t9_evaluation_t {
+    size_t windows;
+    size_t symbols;
+    size_t symbol_errors;
+    size_t words;
+    size_t word_errors;
+    double duration_ms;
+    double latency_ms;
+    double symbol_error_rate;
+    double word_error_rate;
+    double keys_per_second;
+};
+
+typedef struct struct_t9_evaluation_t t9_evaluation_t;
+
+/*!
+ * Decoding parameters of a hyperparameter sweep and their evaluation result.
+ */
+struct struct_t9_sweep_setting_t {
+    uint8_t ngram_length;
+    uint16_t number_paths;
+    t9_evaluation_t result;
+};
+
+typedef struct struct_t9_sweep_setting_t t9_sweep_setting_t;
+
 
 /*!
  * Create a model.
@@ -70,57 +247,310 @@ t9_model_create(void);
 
 /*!
  * Destroy an existing model. All contained data is destroyed automatically.
+ * @note All sessions using the model have to be destroyed beforehand.
  * @param model Pointer to a model that is to be destroyed.
  */
 void
 t9_model_destroy(t9_model_t *const model);
 
 /*!
- * Sort the list of best paths ascending, so that the best path is the first entry.
- * @param model Pointer to a model whose paths are to be sorted.
+ * Select the decoder of a model.
+ * The Viterbi and A* decoders require the corpus tree to be compiled into context states for the current ngram length,
+ * which is done once here. The corpus tree and ngram length must not change afterwards.
+ * @note All sessions using the model have to be destroyed beforehand.
+ * @param model Pointer to a model with a finalized corpus tree.
+ * @param decoder Decoder to be used, T9_DECODER_BEAM, T9_DECODER_VITERBI or T9_DECODER_ASTAR.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
  */
-void
-t9_model_sort_paths(t9_model_t *const model);
+t9_error_t
+t9_model_set_decoder(t9_model_t *const model,
+                     t9_decoder_t decoder);
+
+/*!
+ * Attach a table of precomputed results to a model (see t9_table_build).
+ * Sessions without output start typing a new sequence from the table entry of its first keys, instead of decoding
+ * them. The table is only used while the decoding parameters of the model match the ones it was built with.
+ * @note All sessions using the model have to be destroyed beforehand.
+ * @param model Pointer to a model.
+ * @param table Pointer to a table built with the decoding parameters of the model. The model takes ownership of the
+ * table and destroys it with itself. NULL detaches and destroys the current table.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE. On failure the model does not take ownership of the table.
+ */
+t9_error_t
+t9_model_set_table(t9_model_t *const model,
+                   t9_table_t *const table);
+
+/*!
+ * Write the corpus tree, the decoding parameters, the dictionary and the table of a model to a file.
+ * The corpus itself is not written,
+ * neither is a table that does not match the decoding parameters of the model anymore.
+ * @param model Pointer to a model with a corpus tree.
+ * @param path Path of the file to be written.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_save(const t9_model_t *const model,
+              const char *const path);
+
+/*!
+ * Read a model written by t9_model_save. The model has no corpus loaded.
+ * @note The user is responsible for destroying the model using t9_model_destroy once it is no longer required.
+ * @param path Path of the file to be read.
+ * @param model Pointer to a variable where the pointer to the new model is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_load(const char *const path,
+              t9_model_t **model);
 
 /*!
  * Autocomplete a given symbol sequence as text based on the statistical model.
+ * A temporary session is used for decoding, so this function may be called concurrently on the same model.
+ * @note The user is responsible for destroying the suggestion using free once it is no longer required.
  * @param model Pointer to the model to be used for completion.
  * @param lexicon_sequence Pointer to a lexicon sequence to enter.
- * @param suggestion
+ * @param suggestion Pointer to a variable where the pointer to the resulting string is placed.
  * @return T9_SUCCESS on success, otherwise T9_FAILURE.
  */
-t9_error_t t9_model_autocomplete(t9_model_t *const model,
+t9_error_t t9_model_autocomplete(const t9_model_t *const model,
                                  const t9_symbol_t *const lexicon_sequence,
-                                 t9_symbol_t ** suggestion);
+                                 t9_symbol_t **suggestion);
+
+/*!
+ * Autocomplete a given symbol sequence and write the best suggestions into buffers of the caller.
+ * The session of the caller is reset and reused for decoding, and nothing is allocated to return the suggestions.
+ * @param model Pointer to the model to be used for completion.
+ * @param session Pointer to a session of the model.
+ * @param lexicon_sequence Pointer to a lexicon sequence to enter.
+ * @param suggestions Pointer to a buffer of capacity rows of stride symbols each. Suggestion i is written zero
+ * terminated to row i.
+ * @param stride Number of symbols per row. Must be at least the length of the sequence plus one.
+ * @param scores Pointer to an array of capacity scores. Score i is the negative log probability of suggestion i.
+ * @param capacity Maximal number of suggestions to be written.
+ * @param count Pointer to a variable where the number of suggestions written is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_autocomplete_nbest(const t9_model_t *const model,
+                            t9_session_t *const session,
+                            const t9_symbol_t *const lexicon_sequence,
+                            t9_symbol_t *const suggestions,
+                            size_t stride,
+                            float *const scores,
+                            size_t capacity,
+                            size_t *const count);
+
+/*!
+ * Autocomplete a batch of symbol sequences.
+ * The sequences are distributed over the workers of a thread pool. Every worker decodes with its own session, which
+ * is reused for all sequences the worker processes.
+ * @note The user is responsible for destroying every suggestion using free once it is no longer required.
+ * @param model Pointer to the model to be used for completion.
+ * @param sequences Array of pointers to lexicon sequences to enter.
+ * @param count Number of sequences.
+ * @param suggestions Array of size count, where the pointers to the resulting strings are placed. If a sequence can
+ * not be completed its entry is set to NULL.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the batch is decoded by the calling thread.
+ * @return T9_SUCCESS if all sequences were completed, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_autocomplete_batch(const t9_model_t *const model,
+                            const t9_symbol_t *const *const sequences,
+                            size_t count,
+                            t9_symbol_t **suggestions,
+                            t9_pool_t *const pool);
+
+/*!
+ * Autocomplete a batch of symbol sequences, decoding every prefix shared by several sequences only once.
+ * The sequences are sorted, which arranges them in a trie of keys. The trie is walked depth first with a single
+ * session, which is copied wherever the sequences branch. The sorted sequences are split into consecutive chunks,
+ * which are distributed over the workers of a thread pool.
+ * The suggestions are the same as the ones of t9_model_autocomplete_batch, but the more the sequences share prefixes,
+ * the less keys are decoded. A batch of all keystrokes of a user, each resubmitting the sequence typed so far, is
+ * decoded with the effort of its longest sequences.
+ * @note The user is responsible for destroying every suggestion using free once it is no longer required.
+ * @param model Pointer to the model to be used for completion.
+ * @param sequences Array of pointers to lexicon sequences to enter.
+ * @param count Number of sequences.
+ * @param suggestions Array of size count, where the pointers to the resulting strings are placed. If a sequence can
+ * not be completed its entry is set to NULL.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the batch is decoded by the calling thread.
+ * @return T9_SUCCESS if all sequences were completed, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_autocomplete_shared(const t9_model_t *const model,
+                             const t9_symbol_t *const *const sequences,
+                             size_t count,
+                             t9_symbol_t **suggestions,
+                             t9_pool_t *const pool);
 
 /*!
  * Evaluate a model by inserting text from an test set and comparing it to the original.
+ * The test set is evaluated in windows of T9_EVALUATION_WINDOW_LENGTH symbols by the calling thread.
  * @param model Pointer to the model to be evaluated.
- * @param error Pointer to a variable where the pointer to the resulting string is placed.
+ * @param error Pointer to a variable where the resulting symbol error rate is placed.
  * @return T9_SUCCESS on success, otherwise T9_FAILURE.
  */
 t9_error_t
-t9_model_evaluate(t9_model_t *const model,
+t9_model_evaluate(const t9_model_t *const model,
                   double *const error);
 
 /*!
- * Prune all nodes in a models search tree a given path consists of.
- * @param model Pointer toa model that is to be pruned.
- * @param path Pointer to a path that is to prune the search tree.
+ * Evaluate a model by inserting text from an test set and comparing it to the original.
+ * The test set is split into independent windows on sentence or word boundaries, which are decoded in parallel.
+ * Symbols that are not assigned to a lexicon symbol are skipped.
+ * @param model Pointer to the model to be evaluated.
+ * @param window_length Maximal number of symbols per window.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the windows are decoded by the calling thread.
+ * @param result Pointer to a structure where the aggregated result is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_evaluate_windows(const t9_model_t *const model,
+                          size_t window_length,
+                          t9_pool_t *const pool,
+                          t9_evaluation_t *const result);
+
+/*!
+ * Helper function used to count the nodes of a corpus subtree.
+ * @param node Pointer to the root of the subtree.
+ * @return Number of nodes including the root.
+ */
+uint64_t
+__t9_model_count_nodes(const t9_corpus_node_t *const node);
+
+/*!
+ * Helper function used to write a corpus subtree to a model file.
+ * @param node Pointer to the root of the subtree.
+ * @param fp Pointer to the file.
+ * @return true on success, false if an error occurred.
+ */
+bool
+__t9_model_save_node(const t9_corpus_node_t *const node,
+                     FILE *const fp);
+
+/*!
+ * Helper function used to read a corpus subtree from a model file.
+ * @param node Pointer to the node the root record is read into.
+ * @param fp Pointer to the file.
+ * @param remaining Pointer to the number of records left in the file, decremented for every record read.
+ * @param depth Maximal depth of the subtree. Records below it are rejected.
+ * @return true on success, false if an error occurred.
+ */
+bool
+__t9_model_load_node(t9_corpus_node_t *const node,
+                     FILE *const fp,
+                     uint64_t *const remaining,
+                     uint16_t depth);
+
+/*!
+ * Helper function used to run a batch job. Creates a session per worker, executes the task for every job item and
+ * destroys the sessions again.
+ * @param model Pointer to the model to be used for completion.
+ * @param batch Pointer to the batch job description.
+ * @param count Number of job items.
+ * @param task Task to be executed for every job item.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the job is executed by the calling thread.
+ * @return T9_SUCCESS if all job items succeeded, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_model_run_batch(const t9_model_t *const model,
+                     t9_model_batch_t *const batch,
+                     size_t count,
+                     t9_pool_task_t task,
+                     t9_pool_t *const pool);
+
+/*!
+ * Helper function used to complete a single sequence of a batch.
+ * @param worker Index of the worker executing the task.
+ * @param index Index of the sequence to be completed.
+ * @param arg Pointer to the batch job description.
+ */
+void
+__t9_model_autocomplete_batch_task(size_t worker,
+                                   size_t index,
+                                   void *arg);
+
+/*!
+ * Helper function used to complete a chunk of the sorted sequences of a batch with shared prefixes.
+ * @param worker Index of the worker executing the task.
+ * @param index Index of the chunk to be completed.
+ * @param arg Pointer to the batch job description.
+ */
+void
+__t9_model_autocomplete_shared_task(size_t worker,
+                                    size_t index,
+                                    void *arg);
+
+/*!
+ * Helper function used to complete a range of sorted sequences, that share a prefix which was typed into a session.
+ * Sequences ending with the prefix take the suggestion of the session. All other sequences are grouped by their next
+ * key. Every group but the last one continues on a copy of the session, the last one continues on the session itself.
+ * @param batch Pointer to the batch job description.
+ * @param session Pointer to a session the shared prefix was typed into. Is modified.
+ * @param begin Index of the first sorted sequence of the range.
+ * @param end Index after the last sorted sequence of the range.
+ * @param depth Length of the shared prefix.
+ * @return T9_SUCCESS if all sequences of the range were completed, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_model_autocomplete_shared_range(t9_model_batch_t *const batch,
+                                     t9_session_t *const session,
+                                     size_t begin,
+                                     size_t end,
+                                     size_t depth);
+
+/*!
+ * Helper function used to sort the sequences of a batch with qsort.
+ * @param a Pointer to a batch entry.
+ * @param b Pointer to a batch entry.
+ * @return Lexicographical order of the sequences of the entries.
+ */
+int
+__t9_model_compare_batch_entries(const void *a,
+                                 const void *b);
+
+/*!
+ * Evaluate a model for several decoding parameters without rebuilding the corpus tree.
+ * A corpus tree built with a ngram length n also contains the statistics of all shorter ngrams, therefore every
+ * setting with a ngram length of up to n is decoded against the same tree. The settings are evaluated one after
+ * another, the windows of each setting are decoded in parallel.
+ * @param model Pointer to the model to be evaluated. Its ngram length is the maximal ngram length of the sweep.
+ * @param settings Array of settings to be evaluated. The result of every setting is placed in the setting itself.
+ * @param count Number of settings.
+ * @param window_length Maximal number of symbols per window.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the windows are decoded by the calling thread.
  * @return T9_SUCCESS on success, otherwise T9_FAILURE.
  */
 t9_error_t
-t9_model_prune_path(t9_model_t *const model,
-                    t9_path_t *const path);
+t9_model_sweep(const t9_model_t *const model,
+               t9_sweep_setting_t *const settings,
+               size_t count,
+               size_t window_length,
+               t9_pool_t *const pool);
+
+/*!
+ * Helper function used to split a corpus text into evaluation windows.
+ * @param buffer Pointer to the corpus text.
+ * @param buffer_size Length of the corpus text.
+ * @param window_length Maximal number of symbols per window.
+ * @param windows Pointer to a vector the windows are appended to.
+ */
+void
+__t9_model_evaluation_split(const t9_symbol_t *const buffer,
+                            size_t buffer_size,
+                            size_t window_length,
+                            t9_evaluation_window_vector_t *const windows);
 
 /*!
- * Helper function used to remove a search node from a model.
- * @param model Pointer to a model from which a node is to me removed.
- * @param node Pointer to a node that is to be removed.
- * @param depth Level of the tree, the node to be removed is on.
+ * Helper function used to decode and score a single evaluation window.
+ * @param worker Index of the worker executing the task.
+ * @param index Index of the window to be evaluated.
+ * @param arg Pointer to the evaluation job description.
  */
-void __t9_model_prune_path_helper(t9_model_t *const model,
-                                  t9_search_node_t *const node,
-                                  size_t depth);
+void
+__t9_model_evaluation_task(size_t worker,
+                           size_t index,
+                           void *arg);
 
 #endif //C_T9_MODEL_H
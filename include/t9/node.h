@@ -35,9 +35,6 @@
 #ifndef C_T9_NODE_H
 #define C_T9_NODE_H
 
-// We use asprintf.
-// This function is a GNU extension, not in C or POSIX.
-#define _GNU_SOURCE
 #include <stdio.h>
 
 #define kvec_cnode_t(type) struct struct_kvec_cnode {size_t n, m; type *a; }
@@ -68,6 +65,7 @@ typedef kvec_snode_t(t9_search_node_t *) t9_search_node_vector_t;
 #include "t9/math.h"
 #include "t9/tree.h"
 #include "t9/model.h"
+#include "t9/session.h"
 #include "t9/path.h"
 
 /*!
@@ -87,10 +85,13 @@ typedef struct struct_t9_corpus_node_t t9_corpus_node_t;
  * Node structure used in a search tree.
  */
 struct struct_t9_search_node_t {
-    t9_symbol_t symbol;
-    float probability;
+    double probability;
+    double rescored;
     struct struct_t9_search_node_t *parent;
     list_t *children2;
+    list_node_t *level_entry;
+    t9_symbol_t symbol;
+    bool is_rescored;
 };
 
 typedef struct struct_t9_search_node_t t9_search_node_t;
@@ -168,6 +169,20 @@ void
 t9_corpus_node_add_child(t9_corpus_node_t *const node,
                          t9_corpus_node_t *const child);
 
+/*!
+ * Descend down a corpus tree starting at a given node with a given symbol sequence and return the last corpus node
+ * encountered.
+ * @param node Pointer to a corpus node to begin the descend with.
+ * @param sequence Pointer to the symbols that are to be followed through the corpus tree.
+ * @param length Number of symbols to be followed.
+ * @return Pointer to the last node of the followed sequence. The node itself if length is 0. NULL if the sequence is
+ * not contained in the tree.
+ */
+t9_corpus_node_t *
+t9_corpus_node_descend(const t9_corpus_node_t *const node,
+                       const t9_symbol_t *const sequence,
+                       size_t length);
+
 /* ================================================================================== */
 
 
@@ -197,12 +212,19 @@ t9_search_node_destroy(t9_search_node_t *const node);
 bool
 t9_search_node_is_leaf(const t9_search_node_t *const node);
 
+/*!
+ * Expand a leaf of a search tree by a child for every corpus symbol that could have been meant by a typed key.
+ * @param node Pointer to the leaf to be expanded.
+ * @param t9_input Lexicon symbol that was typed.
+ * @param depth Level of the tree, the new children are on.
+ * @param session Pointer to the session whose search tree is expanded.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
 t9_error_t
-t9_search_node_insert(t9_search_node_t *const node,
+t9_search_node_expand(t9_search_node_t *const node,
                       t9_symbol_t t9_input,
-                      const t9_symbol_t *sequence,
-                      const uint32_t depth,
-                      t9_model_t *const model);
+                      size_t depth,
+                      t9_session_t *const session);
 
 /*!
  * Add a child to a search node.
@@ -214,27 +236,27 @@ t9_search_node_add_child(t9_search_node_t *const node,
                          t9_search_node_t *const child);
 
 /*!
- * Populate the list of best paths in a given model, starting with a given node.
+ * Populate the list of best paths in a given session, starting with a given node.
  * @param node Pointer to a search node to start the path search at.
- * @param model Pointer to a model in which to search and store the best paths.
+ * @param session Pointer to a session in which to search and store the best paths.
  * @param tmp_path Pointer to a path that was taken to reach the given node. This path is modified as the tree is
  * searched.
  */
 void
 t9_node_search_paths(t9_search_node_t *const node,
-                     t9_model_t *const model,
+                     t9_session_t *const session,
                      t9_path_t *tmp_path);
 
 /*!
  * Prune a a given node (and all its children) that was reached over a given path.
- * All nodes that are not part of the paths that are known to be the best paths of the given model are pruned.
+ * All nodes that are not part of the paths that are known to be the best paths of the given session are pruned.
  * @param node Pointer to a search node to be pruned.
- * @param model Pointer to a model that contains the search node to be pruned.
+ * @param session Pointer to a session that contains the search node to be pruned.
  * @param path Pointer to a path that was taken to reach the node to be pruned.
  */
 void
 t9_search_node_prune(t9_search_node_t *const node,
-                     t9_model_t *const model,
+                     t9_session_t *const session,
                      t9_path_t *const path);
 
 /*!
@@ -258,6 +280,31 @@ t9_search_node_t *
 t9_search_node_descend(const t9_search_node_t *const node,
                        const t9_symbol_t *const sequence);
 
+/*!
+ * Calculate the language model cost of the symbol of a search node, given the symbols on the way to it.
+ * @param node Pointer to a search node below the root.
+ * @param tree Pointer to the corpus tree to look up the probability in.
+ * @param ngram_length Ngram length used to look up the probability.
+ * @return Negative logarithmic probability of the symbol.
+ */
+float
+t9_search_node_cost(const t9_search_node_t *const node,
+                    const t9_corpus_tree_t *const tree,
+                    uint8_t ngram_length);
+
+/*!
+ * Get the symbols of the last nodes on the way from the root of a search tree to a given node.
+ * The root node itself is not part of the context.
+ * @param node Pointer to the last search node of the context.
+ * @param length Maximal number of symbols of the context.
+ * @param context Pointer to a buffer of at least length symbols, where the context is placed in reading order.
+ * @return Number of symbols placed in context.
+ */
+size_t
+t9_search_node_context(const t9_search_node_t *const node,
+                       size_t length,
+                       t9_symbol_t *const context);
+
 /* ================================================================================== */
 
 
@@ -60,7 +60,7 @@ typedef kvec_path_t(t9_path_t *) t9_path_vector_t;
  * Path structure, describing a path trough a search tree.
  */
 struct struct_t9_path_t {
-    float probability;
+    double probability;
     t9_search_node_vector_t nodes;
 };
 
@@ -99,6 +99,14 @@ t9_path_push(t9_path_t *const path, t9_search_node_t *const node);
 t9_search_node_t *
 t9_path_pop(t9_path_t *const path);
 
+/*!
+ * Remove the first node of a path. The probability of the path is not changed.
+ * @param path Pointer to a non-empty path to be modified.
+ * @return Pointer to the node that was removed from the path.
+ */
+t9_search_node_t *
+t9_path_shift(t9_path_t *const path);
+
 /*!
  * Duplicate a path by creating a new path and coping the all contents.
  * @note The user is responsible for destroying the duplicated path using t9_path_destroy once it is no longer required.
@@ -108,6 +116,15 @@ t9_path_pop(t9_path_t *const path);
 t9_path_t *
 t9_path_duplicate(const t9_path_t *const path);
 
+/*!
+ * Copy the contents of a path into another path. The memory of the target path is reused.
+ * @param path Pointer to the path to be overwritten.
+ * @param source Pointer to the path to be copied.
+ */
+void
+t9_path_copy(t9_path_t *const path,
+             const t9_path_t *const source);
+
 /*!
  * Create a symbol string from a path.
  * This string represent the path taken trough the search tree.
@@ -118,6 +135,18 @@ t9_path_duplicate(const t9_path_t *const path);
 t9_symbol_t *
 t9_path_flatten(const t9_path_t *const path);
 
+/*!
+ * Write the symbols of a path into a buffer.
+ * @param path Pointer to a path to be written.
+ * @param buffer Pointer to a buffer the zero terminated symbols are written to.
+ * @param size Size of the buffer in symbols. Must be at least the length of the path plus one.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_path_write(const t9_path_t *const path,
+              t9_symbol_t *const buffer,
+              size_t size);
+
 /*!
  * Create a string from path that includes the symbols the path passes trough its nodes and the overall path
  * probability. The form is "sssss...sss" : probability.
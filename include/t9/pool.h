@@ -0,0 +1,149 @@
+/*!
+  ******************************************************************************
+  * @file    pool.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for pool.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_POOL_H
+#define C_T9_POOL_H
+
+// We use sysconf.
+// This function is a POSIX extension, not in C.
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "t9/errno.h"
+
+// Forward declarations of pool to break cyclic redundancy.
+struct struct_t9_pool_t;
+typedef struct struct_t9_pool_t t9_pool_t;
+
+/*!
+ * Task executed by a thread pool for every index of a job.
+ * @param worker Index of the worker thread executing the task. Ranges from 0 to the number of pool threads - 1.
+ * Can be used to address per worker data, that is never accessed by two threads at the same time.
+ * @param index Index of the job item to be processed.
+ * @param arg User supplied argument of the job.
+ */
+typedef void (*t9_pool_task_t)(size_t worker, size_t index, void *arg);
+
+/*!
+ * Range of job items owned by a single worker.
+ * The owner takes items from the front, idle workers steal from the back.
+ */
+struct struct_t9_pool_queue_t {
+    t9_pool_t *pool;
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+};
+
+typedef struct struct_t9_pool_queue_t t9_pool_queue_t;
+
+/*!
+ * Pool of worker threads executing jobs with work stealing.
+ */
+struct struct_t9_pool_t {
+    uint16_t number_threads;
+    pthread_t *threads;
+    t9_pool_queue_t *queues;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    t9_pool_task_t task;
+    void *arg;
+    uint64_t generation;
+    uint16_t active;
+    bool shutdown;
+};
+
+typedef struct struct_t9_pool_t t9_pool_t;
+
+/*!
+ * Create a thread pool.
+ * @note The user is responsible for destroying the pool using t9_pool_destroy once it is no longer required.
+ * @param number_threads Number of worker threads. 0 selects the number of online processors.
+ * @return Pointer to a new pool. NULL if an error occurred.
+ */
+t9_pool_t *
+t9_pool_create(uint16_t number_threads);
+
+/*!
+ * Destroy a thread pool. All worker threads are joined.
+ * @param pool Pointer to a pool to be destroyed.
+ */
+void
+t9_pool_destroy(t9_pool_t *const pool);
+
+/*!
+ * Execute a task for all indices 0 to count - 1 on the pool and wait until all of them are processed.
+ * The indices are split evenly between the workers. Workers that run out of work steal half of the remaining
+ * indices of another worker.
+ * @note Jobs of a pool are executed one after another. The function must not be called from within a task.
+ * @param pool Pointer to a pool to execute the job.
+ * @param count Number of job items.
+ * @param task Task to be executed for every job item.
+ * @param arg User supplied argument passed to every task.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_pool_run(t9_pool_t *const pool,
+            size_t count,
+            t9_pool_task_t task,
+            void *arg);
+
+/*!
+ * Helper function used to take the next job item for a worker. If the workers own range is exhausted, half of the
+ * remaining items of another worker are stolen.
+ * @param pool Pointer to the pool.
+ * @param worker Index of the worker looking for work.
+ * @param index Pointer to a variable where the index of the job item is placed.
+ * @return true if a job item was found, false if all job items are taken.
+ */
+bool
+__t9_pool_next(t9_pool_t *const pool,
+               size_t worker,
+               size_t *const index);
+
+/*!
+ * Helper function running the main loop of a worker thread.
+ * @param arg Pointer to the queue of the worker.
+ * @return Always NULL.
+ */
+void *
+__t9_pool_worker(void *arg);
+
+#endif //C_T9_POOL_H
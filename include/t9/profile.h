@@ -0,0 +1,161 @@
+/*!
+  ******************************************************************************
+  * @file    profile.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for profile.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_PROFILE_H
+#define C_T9_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "t9/timer.h"
+
+// Maximal number of zones. A zone is identified by its name together with its parent zone.
+#define T9_PROFILE_MAX_ZONES 128
+
+// Maximal depth zones can be nested to per thread. Deeper zones are not recorded.
+#define T9_PROFILE_MAX_DEPTH 32
+
+// Index of the root zone, the parent of all outermost zones.
+#define T9_PROFILE_ROOT 0
+
+// Profiling zones are only recorded if the library is built with the meson option instrument, otherwise they
+// compile out to nothing.
+#ifdef T9_INSTRUMENT
+#define T9_PROFILE_BEGIN(name) t9_profile_begin(name)
+#define T9_PROFILE_END() t9_profile_end()
+#else
+#define T9_PROFILE_BEGIN(name) ((void) 0)
+#define T9_PROFILE_END() ((void) 0)
+#endif
+
+/*!
+ * Profiling zone. Accumulates how often the zone was entered, and the total and maximal number of cycles spent in it.
+ * All threads record into the same zones.
+ */
+struct struct_t9_profile_zone_t {
+    const char *name;
+    uint32_t parent;
+    uint32_t depth;
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t total;
+    atomic_uint_fast64_t max;
+};
+
+typedef struct struct_t9_profile_zone_t t9_profile_zone_t;
+
+/*!
+ * Table of all zones of the process. Zones are only added, so they can be looked up without locking.
+ */
+struct struct_t9_profile_t {
+    t9_profile_zone_t zones[T9_PROFILE_MAX_ZONES];
+    atomic_uint_fast32_t number_zones;
+    pthread_mutex_t lock;
+};
+
+typedef struct struct_t9_profile_t t9_profile_t;
+
+/*!
+ * Zones a thread currently is in, innermost last.
+ * - dropped: Number of open zones that are not recorded, because they are nested too deep or the table is full.
+ */
+struct struct_t9_profile_stack_t {
+    uint32_t zones[T9_PROFILE_MAX_DEPTH];
+    uint64_t starts[T9_PROFILE_MAX_DEPTH];
+    uint32_t depth;
+    uint32_t dropped;
+};
+
+typedef struct struct_t9_profile_stack_t t9_profile_stack_t;
+
+// Zones of the process.
+extern t9_profile_t t9_profile;
+
+// Open zones of the calling thread.
+extern _Thread_local t9_profile_stack_t t9_profile_stack;
+
+/*!
+ * Enter a zone, nested into the zone the calling thread is in.
+ * @note Use T9_PROFILE_BEGIN, so that the zone compiles out unless instrumentation is enabled.
+ * @param name Name of the zone. The string has to live as long as the process, a literal is expected.
+ */
+void
+t9_profile_begin(const char *const name);
+
+/*!
+ * Leave the innermost zone of the calling thread and record the time spent in it.
+ * @note Use T9_PROFILE_END, so that the zone compiles out unless instrumentation is enabled.
+ */
+void
+t9_profile_end(void);
+
+/*!
+ * Reset the statistics of all zones. The zones themselves are kept.
+ */
+void
+t9_profile_reset(void);
+
+/*!
+ * Write the statistics of all zones as an indented tree. The times are converted from cycles to milliseconds and
+ * microseconds, which calibrates the cycle counter (see t9_timer_cycles_per_ns).
+ * @param fp Pointer to the file to be written to.
+ */
+void
+t9_profile_write(FILE *const fp);
+
+/*!
+ * Helper function used to look up a zone by its parent and name, adding it if it does not exist yet.
+ * @param parent Index of the parent zone.
+ * @param name Name of the zone.
+ * @return Index of the zone. T9_PROFILE_MAX_ZONES if the table is full.
+ */
+uint32_t
+__t9_profile_find(uint32_t parent,
+                  const char *const name);
+
+/*!
+ * Helper function used to write a zone and all of its children.
+ * @param fp Pointer to the file to be written to.
+ * @param index Index of the zone.
+ * @param number_zones Number of zones.
+ * @param cycles_per_ns Rate of the cycle counter.
+ */
+void
+__t9_profile_write_zone(FILE *const fp,
+                        uint32_t index,
+                        uint32_t number_zones,
+                        double cycles_per_ns);
+
+#endif //C_T9_PROFILE_H
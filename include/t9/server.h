@@ -0,0 +1,425 @@
+/*!
+  ******************************************************************************
+  * @file    server.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for server.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_SERVER_H
+#define C_T9_SERVER_H
+
+// We use accept4, epoll and eventfd.
+// These functions are Linux extensions, not in C.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "libraries/kvec/kvec.h"
+
+// Forward declarations of server to break cyclic redundancy.
+struct struct_t9_server_t;
+typedef struct struct_t9_server_t t9_server_t;
+
+struct struct_t9_server_connection_t;
+typedef struct struct_t9_server_connection_t t9_server_connection_t;
+
+// Vectors of bytes and connections.
+// Note: kvec_t can not be used, because it defines the same struct name for every vector.
+#define kvec_sbyte_t(type) struct struct_kvec_sbyte {size_t n, m; type *a; }
+#define kvec_sconnection_t(type) struct struct_kvec_sconnection {size_t n, m; type *a; }
+
+#include "t9/errno.h"
+#include "t9/cache.h"
+#include "t9/corpus.h"
+#include "t9/dictionary.h"
+#include "t9/metrics.h"
+#include "t9/model.h"
+#include "t9/pool.h"
+#include "t9/session.h"
+#include "t9/speculator.h"
+
+/*
+ * Protocol
+ * Every message is a frame of a uint32_t holding the number of bytes that follow and the bytes themselves. All
+ * integers and floats are in the byte order of the host, as client and server always run on the same host.
+ *
+ * Request:  [uint32_t size][uint8_t opcode][lexicon symbols, T9_SERVER_TYPE only]
+ * Response: [uint32_t size][uint8_t status][uint8_t count]
+ *           count times [float score][uint16_t length][length symbols], the best suggestion first.
+ *           [uint8_t count] count times [uint16_t length][length symbols], the dictionary completions of the word
+ *           being typed, the most frequent one first.
+ *
+ * Requests of a connection are answered in order. Every connection has its own session, keys typed with
+ * T9_SERVER_TYPE extend the sequence typed so far until T9_SERVER_RESET starts a new one. With a cache, sessions
+ * resume from the longest prefix of their sequence any connection typed before. With speculation, the most likely next
+ * keys are typed ahead of time while the client waits for its user.
+ */
+
+// Opcodes of requests.
+#define T9_SERVER_TYPE 1
+#define T9_SERVER_RESET 2
+
+// Status of responses.
+#define T9_SERVER_OK 0
+#define T9_SERVER_ERROR 1
+
+// Maximal number of bytes following the size of a request. Connections sending larger requests are closed.
+#define T9_SERVER_MAX_REQUEST 1024
+
+// Maximal number of events handled per iteration of the event loop.
+#define T9_SERVER_MAX_EVENTS 256
+
+// Number of pending connections the listening socket queues.
+#define T9_SERVER_BACKLOG 4096
+
+// Number of bytes read from a connection at least per call.
+#define T9_SERVER_READ_SIZE 4096
+
+// Number of bytes buffered per connection in either direction. A connection whose unsent responses exceed it is not
+// read from and its requests are not answered, until the client received enough of them.
+#define T9_SERVER_MAX_BUFFERED 65536
+
+typedef kvec_sbyte_t(uint8_t) t9_server_buffer_t;
+
+typedef kvec_sconnection_t(t9_server_connection_t *) t9_server_connection_vector_t;
+
+/*!
+ * Client connection of a server, typing into its own session. keys holds the sequence typed since the last reset, the
+ * key of cached states. word holds the keys typed since the last separator key, the word that is completed by the
+ * dictionary of the model. speculator is NULL unless the server speculates.
+ */
+struct struct_t9_server_connection_t {
+    int socket;
+    size_t index;
+    t9_session_t *session;
+    t9_speculator_t *speculator;
+    t9_server_buffer_t keys;
+    t9_server_buffer_t input;
+    t9_server_buffer_t output;
+    size_t written;
+    t9_server_buffer_t suggestions;
+    float *scores;
+    t9_server_buffer_t word;
+    const t9_dictionary_word_t *const *completions;
+    size_t number_completions;
+    size_t handled;
+    uint32_t events;
+    bool closing;
+};
+
+typedef struct struct_t9_server_connection_t t9_server_connection_t;
+
+/*!
+ * Completion server on a Unix domain socket.
+ * A single thread waits for events of all connections with epoll. Connections that received complete requests in
+ * one iteration are decoded together on a thread pool, every connection by one worker, and the responses are sent
+ * by the event loop again. The model is shared by all sessions and must not be modified while the server runs. It is
+ * loaded once with t9_model_load rather than mapped, as decoding walks the corpus tree built from the model file.
+ * Every worker records the metrics of the sessions it decodes in a shard of its own. The cache of decoder states is
+ * shared by all workers, it is NULL unless set with t9_server_set_cache. number_speculated is the number of keys the
+ * speculator of every connection types ahead of time, 0 unless set with t9_server_set_speculation.
+ */
+struct struct_t9_server_t {
+    const t9_model_t *model;
+    t9_pool_t *pool;
+    t9_metrics_t **metrics;
+    t9_cache_t *cache;
+    uint8_t number_speculated;
+    char *path;
+    char *metrics_path;
+    int listener;
+    int metrics_listener;
+    int epoll;
+    int wake;
+    uint8_t number_suggestions;
+    uint8_t number_completions;
+    t9_server_connection_vector_t connections;
+    t9_server_connection_vector_t ready;
+    uint64_t number_requests;
+    bool running;
+};
+
+typedef struct struct_t9_server_t t9_server_t;
+
+/*!
+ * Create a server listening on a Unix domain socket. An existing file at the path of the socket is replaced.
+ * @note The user is responsible for destroying the server using t9_server_destroy once it is no longer required.
+ * @param model Pointer to the model sessions are decoded with.
+ * @param path Path of the socket.
+ * @param number_threads Number of threads decoding requests. 0 selects the number of online processors.
+ * @param number_suggestions Maximal number of suggestions per response.
+ * @param number_completions Maximal number of completions of the word being typed per response. 0 disables them,
+ * otherwise the model has to hold a dictionary.
+ * @return Pointer to a new server. NULL if an error occurred.
+ */
+t9_server_t *
+t9_server_create(const t9_model_t *const model,
+                 const char *const path,
+                 uint16_t number_threads,
+                 uint8_t number_suggestions,
+                 uint8_t number_completions);
+
+/*!
+ * Destroy a server. All connections are closed and the socket file is removed.
+ * @param server Pointer to a server to be destroyed.
+ */
+void
+t9_server_destroy(t9_server_t *const server);
+
+/*!
+ * Serve the metrics of a server in the Prometheus text format on a second Unix domain socket.
+ * Every connection to the socket receives the current metrics and is closed. Besides the decoding metrics of all
+ * workers, including their hits and misses of the cache, the number of connections and requests, the memory of the
+ * sessions and of the cache by structure, and the entries and evictions of the cache are reported.
+ * @param server Pointer to a server that is not running.
+ * @param path Path of the socket. An existing file at the path is replaced.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_server_set_metrics(t9_server_t *const server,
+                      const char *const path);
+
+/*!
+ * Share the decoder states of the sequences typed by all connections in a cache. Every session stores its state after
+ * every request and resumes from the longest cached prefix of its sequence, when that is longer than the keys it typed.
+ * Users typing the same words skip decoding them.
+ * @note The cache and speculation exclude each other, as restoring a cached state would discard all speculations.
+ * @param server Pointer to a server that is not running.
+ * @param capacity Maximal memory of the cached states in bytes.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_server_set_cache(t9_server_t *const server,
+                    size_t capacity);
+
+/*!
+ * Speculate on the next keys of every connection (see t9_speculator_t). Every connection types its most likely next
+ * keys into copies of its session on a thread of its own, while its client waits for the next key of its user. A key
+ * that was speculated on is answered without decoding it. As every connection takes a thread, speculation suits
+ * servers of a few interactive clients rather than thousands of connections.
+ * @note The cache and speculation exclude each other, as restoring a cached state would discard all speculations.
+ * @param server Pointer to a server that is not running and has no connections yet.
+ * @param number_keys Number of most likely keys to speculate on after every key. Ranges from 1 to
+ * NUM_LEXICON_SYMBOLS.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_server_set_speculation(t9_server_t *const server,
+                          uint8_t number_keys);
+
+/*!
+ * Serve connections until the server is stopped.
+ * @param server Pointer to a server.
+ * @return T9_SUCCESS if the server was stopped, T9_FAILURE if an error occurred.
+ */
+t9_error_t
+t9_server_run(t9_server_t *const server);
+
+/*!
+ * Stop a running server. The function is async-signal-safe, so it may be called from a signal handler.
+ * @param server Pointer to a server.
+ */
+void
+t9_server_stop(t9_server_t *const server);
+
+/*!
+ * Helper function used to create a non-blocking socket listening on a path.
+ * @param path Path of the socket. An existing file at the path is replaced.
+ * @return Descriptor of the socket. -1 if an error occurred.
+ */
+int
+__t9_server_listen(const char *const path);
+
+/*!
+ * Helper function used to write the metrics of a server to all pending connections of the metrics socket.
+ * @param server Pointer to a server.
+ */
+void
+__t9_server_report(const t9_server_t *const server);
+
+/*!
+ * Helper function used to accept all pending connections.
+ * @param server Pointer to a server.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_accept(t9_server_t *const server);
+
+/*!
+ * Helper function used to read the available bytes of a connection, at most until T9_SERVER_MAX_BUFFERED bytes are
+ * buffered. A connection whose client shut down its side is marked as closing.
+ * @param connection Pointer to a connection.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_receive(t9_server_connection_t *const connection);
+
+/*!
+ * Helper function used to write the pending responses of a connection, as far as the socket accepts them.
+ * @param connection Pointer to a connection.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_send(t9_server_connection_t *const connection);
+
+/*!
+ * Helper function used to select the events the event loop waits for on a connection.
+ * A connection is only read from while its buffers are below T9_SERVER_MAX_BUFFERED, and waits for the socket to
+ * accept bytes while responses are unsent.
+ * @param server Pointer to a server.
+ * @param connection Pointer to a connection.
+ * @return T9_SUCCESS on success, T9_FAILURE if the connection is finished or an error occurred.
+ */
+t9_error_t
+__t9_server_watch(t9_server_t *const server,
+                  t9_server_connection_t *const connection);
+
+/*!
+ * Helper function used to check if a connection received a complete request that can be answered.
+ * Requests are held back while the unsent responses of the connection exceed T9_SERVER_MAX_BUFFERED.
+ * @param connection Pointer to a connection.
+ * @return true if a complete request is pending, false otherwise.
+ */
+bool
+__t9_server_is_pending(const t9_server_connection_t *const connection);
+
+/*!
+ * Helper function used to answer the complete requests of a connection, until its unsent responses exceed
+ * T9_SERVER_MAX_BUFFERED.
+ * @param worker Index of the pool worker.
+ * @param index Index of the connection within the connections ready.
+ * @param arg Pointer to the server.
+ */
+void
+__t9_server_task(size_t worker,
+                 size_t index,
+                 void *arg);
+
+/*!
+ * Helper function used to answer a single request.
+ * @param server Pointer to a server.
+ * @param connection Pointer to a connection.
+ * @param request Pointer to the bytes of the request following its size.
+ * @param size Number of bytes of the request.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_handle(const t9_server_t *const server,
+                   t9_server_connection_t *const connection,
+                   const uint8_t *const request,
+                   uint32_t size);
+
+/*!
+ * Helper function used to type keys into the session of a connection, using its speculator or the cache of the server
+ * if there is one.
+ * @param server Pointer to a server.
+ * @param connection Pointer to a connection, whose keys already hold the keys to be typed.
+ * @param sequence Pointer to the zero terminated keys to be typed.
+ * @param typed Number of keys the session typed before.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_type(const t9_server_t *const server,
+                 t9_server_connection_t *const connection,
+                 const t9_symbol_t *const sequence,
+                 size_t typed);
+
+/*!
+ * Helper function used to start a new sequence on a connection.
+ * @param connection Pointer to a connection.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_reset(t9_server_connection_t *const connection);
+
+/*!
+ * Helper function used to track the word a connection is typing and to look up its completions.
+ * @param server Pointer to a server.
+ * @param connection Pointer to a connection.
+ * @param sequence Pointer to the zero terminated keys typed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_complete(const t9_server_t *const server,
+                     t9_server_connection_t *const connection,
+                     const t9_symbol_t *const sequence);
+
+/*!
+ * Helper function used to append the suggestions and completions of a connection to its output as response.
+ * @param connection Pointer to a connection.
+ * @param status Status of the response.
+ * @param count Number of suggestions to be sent.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_server_respond(t9_server_connection_t *const connection,
+                    uint8_t status,
+                    size_t count);
+
+/*!
+ * Helper function used to append bytes to a buffer.
+ * @param buffer Pointer to a buffer.
+ * @param data Pointer to the bytes to be appended.
+ * @param size Number of bytes.
+ */
+void
+__t9_server_append(t9_server_buffer_t *const buffer,
+                   const void *const data,
+                   size_t size);
+
+/*!
+ * Helper function used to create a connection and register it with the event loop.
+ * @param server Pointer to a server.
+ * @param socket Socket of the connection.
+ * @return Pointer to a new connection. NULL if an error occurred.
+ */
+t9_server_connection_t *
+__t9_server_connection_create(t9_server_t *const server,
+                              int socket);
+
+/*!
+ * Helper function used to close a connection and to destroy it.
+ * @param server Pointer to a server.
+ * @param connection Pointer to a connection to be destroyed.
+ */
+void
+__t9_server_connection_destroy(t9_server_t *const server,
+                               t9_server_connection_t *const connection);
+
+#endif //C_T9_SERVER_H
@@ -0,0 +1,451 @@
+/*!
+  ******************************************************************************
+  * @file    session.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for session.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_SESSION_H
+#define C_T9_SESSION_H
+
+// Forward declarations of session to break cyclic redundancy.
+struct struct_t9_session_t;
+typedef struct struct_t9_session_t t9_session_t;
+
+#include <stdint.h>
+#include "libraries/kvec/kvec.h"
+
+#include "t9/model.h"
+#include "t9/tree.h"
+#include "t9/path.h"
+#include "t9/viterbi.h"
+#include "t9/astar.h"
+#include "t9/metrics.h"
+#include "libraries/list/list.h"
+
+// Vectors of the buffers a session reuses.
+// Note: kvec_t can not be used, because it defines the same struct name for every vector.
+#define kvec_slevel_t(type) struct struct_kvec_slevel {size_t n, m; type *a; }
+#define kvec_sscratch_t(type) struct struct_kvec_sscratch {size_t n, m; type *a; }
+
+/*!
+ * Output of a session. Receives symbols whose decoding is final, in the order they were typed.
+ * @param symbols Pointer to the committed symbols. Not zero terminated.
+ * @param length Number of committed symbols.
+ * @param arg User argument given to t9_session_set_output.
+ */
+typedef void (*t9_session_output_t)(const t9_symbol_t *symbols,
+                                    size_t length,
+                                    void *arg);
+
+/*!
+ * Decoding session.
+ * A session holds the mutable state of a single typing user (search tree and best paths, or the state of the
+ * Viterbi or A* decoder). The model a session decodes against is only read, so any number of sessions can share one
+ * model across threads without locking.
+ * With an output, the beam search decoder streams every symbol all of its paths agree on to the output and releases
+ * the part of the search tree before it (see t9_session_set_output).
+ * With metrics, the beam search decoder records its keys, nodes, paths and durations (see t9_session_set_metrics).
+ * Search nodes, list entries, levels and paths the beam search decoder releases are kept for reuse, as are its
+ * scratch buffers, so a session that decoded a sequence once decodes sequences up to the same size without
+ * allocating memory (see t9_session_reset).
+ */
+struct struct_t9_session_t {
+    const t9_model_t *model;
+    t9_search_tree_t *search_tree;
+    t9_path_vector_t paths;
+    t9_viterbi_lattice_t *lattice;
+    t9_astar_t *astar;
+    t9_session_output_t output;
+    void *output_arg;
+    size_t committed;
+    t9_metrics_t *metrics;
+    t9_search_node_vector_t free_nodes;
+    list_node_t *free_entries;
+    kvec_slevel_t(list_t *) free_levels;
+    t9_path_vector_t free_paths;
+    t9_search_node_vector_t leaves;
+    kvec_sscratch_t(uint8_t) scratch;
+};
+
+typedef struct struct_t9_session_t t9_session_t;
+
+// Index of a node that does not exist in a serialized session.
+#define T9_SESSION_NO_NODE UINT32_MAX
+
+/*!
+ * Header of a serialized session.
+ * The header is followed by the records of the decoder the session uses: the nodes and paths of the search tree, the
+ * entries of the Viterbi lattice or the keys and nodes of the A* decoder. Parents always precede their children.
+ */
+struct struct_t9_session_state_t {
+    uint8_t decoder;
+    uint32_t number_levels;
+    uint32_t number_nodes;
+    uint32_t number_paths;
+    uint32_t number_entries;
+    uint32_t number_keys;
+    uint64_t committed;
+    uint64_t column;
+    uint64_t length;
+    uint64_t best;
+};
+
+typedef struct struct_t9_session_state_t t9_session_state_t;
+
+/*!
+ * Search node of a serialized session. The parent of the root node is T9_SESSION_NO_NODE.
+ */
+struct struct_t9_session_state_node_t {
+    double probability;
+    double rescored;
+    uint32_t parent;
+    uint32_t level;
+    t9_symbol_t symbol;
+    bool is_rescored;
+};
+
+typedef struct struct_t9_session_state_node_t t9_session_state_node_t;
+
+/*!
+ * Best path of a serialized session, which is given by its leaf.
+ */
+struct struct_t9_session_state_path_t {
+    double probability;
+    uint32_t leaf;
+};
+
+typedef struct struct_t9_session_state_path_t t9_session_state_path_t;
+
+
+/*!
+ * Create a session decoding against a given model.
+ * @note The user is responsible for destroying the session using t9_session_destroy once it is no longer required.
+ * @note The model has to outlive the session and must not be modified while the session is in use.
+ * @param model Pointer to a model to be used for decoding.
+ * @return Pointer to a new session. NULL if an error occurred, or if the corpus tree of the model is not as deep as its
+ *         ngram_length or rescore_length.
+ */
+t9_session_t *
+t9_session_create(const t9_model_t *const model);
+
+/*!
+ * Destroy an existing session. The model the session refers to is not destroyed.
+ * @param session Pointer to a session that is to be destroyed.
+ */
+void
+t9_session_destroy(t9_session_t *const session);
+
+/*!
+ * Create a deep copy of a session, decoding against the same model and sending committed symbols to the same output.
+ * Keys typed into the copy do not affect the original session and vice versa.
+ * @note The user is responsible for destroying the copy using t9_session_destroy once it is no longer required.
+ * @param session Pointer to a session to be copied.
+ * @return Pointer to a new session. NULL if an error occurred.
+ */
+t9_session_t *
+t9_session_clone(const t9_session_t *const session);
+
+/*!
+ * Serialize the decoding state of a session into a flat buffer, which can be stored and later restored using
+ * t9_session_deserialize. The output of the session is not part of the state.
+ * @note The user is responsible for destroying the buffer using free once it is no longer required.
+ * @param session Pointer to a session to be serialized.
+ * @param state Pointer to a variable where the pointer to the buffer is placed.
+ * @param size Pointer to a variable where the size of the buffer in bytes is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_serialize(const t9_session_t *const session,
+                     uint8_t **state,
+                     size_t *const size);
+
+/*!
+ * Replace the decoding state of a session by a serialized one.
+ * The state has to be serialized from a session using a model with the same decoder. The output of the session is
+ * kept.
+ * @param session Pointer to a session to be restored.
+ * @param state Pointer to a buffer created by t9_session_serialize.
+ * @param size Size of the buffer in bytes.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE. On failure the session is reset.
+ */
+t9_error_t
+t9_session_deserialize(t9_session_t *const session,
+                       const uint8_t *const state,
+                       size_t size);
+
+/*!
+ * Reset a session, so that the next key typed starts a new sequence.
+ * The search tree is emptied in place, its nodes, list entries, levels and paths are kept for the next sequence.
+ * @param session Pointer to a session that is to be reset.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_reset(t9_session_t *const session);
+
+/*!
+ * Record the decoding metrics of a session in a metrics shard.
+ * The shard must only be written by one thread at a time, so sessions decoded concurrently need shards of their own.
+ * Copies of a session made with t9_session_clone do not record metrics.
+ * @param session Pointer to a session.
+ * @param metrics Pointer to a shard, not owned by the session. NULL disables recording.
+ */
+void
+t9_session_set_metrics(t9_session_t *const session,
+                       t9_metrics_t *const metrics);
+
+/*!
+ * Stream the decoded text of a session to an output.
+ * After every key, the symbols all best paths agree on are passed to the output and the part of the search tree
+ * holding them is released, so arbitrarily long inputs are decoded in bounded memory. Suggestions then only cover the
+ * symbols that were not committed yet. Only the beam search decoder commits symbols before the end of the input.
+ * @param session Pointer to a session.
+ * @param output Function to be called with committed symbols. NULL disables streaming.
+ * @param arg User argument passed to the output.
+ */
+void
+t9_session_set_output(t9_session_t *const session,
+                      t9_session_output_t output,
+                      void *arg);
+
+/*!
+ * Commit the best suggestion of a session to its output and reset the session.
+ * Used at the end of a stream of keys.
+ * @param session Pointer to a session with an output.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_flush(t9_session_t *const session);
+
+/*!
+ * Type a sequence of lexicon symbols into a session, using the decoder selected in the model.
+ * @param session Pointer to a session the sequence is typed into.
+ * @param sequence Pointer to a string of lexicon symbols.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_type(t9_session_t *const session,
+                const t9_symbol_t *const sequence);
+
+/*!
+ * Type a single lexicon symbol into a session within a time budget.
+ * The beam search decoder expands the most promising paths first and stops expanding once the budget is exceeded, so
+ * a suggestion is available in bounded time however large the model is. The Viterbi and A* decoders always decode
+ * completely. The A* decoder searches the whole sequence again for every key.
+ * @param session Pointer to a session the symbol is typed into.
+ * @param symbol Lexicon symbol to be typed.
+ * @param budget_ms Time budget in milliseconds. 0 disables the budget.
+ * @param truncated Pointer to a variable, where it is placed whether the search was cut short by the budget. May be
+ * NULL.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_insert(t9_session_t *const session,
+                  t9_symbol_t symbol,
+                  double budget_ms,
+                  bool *const truncated);
+
+/*!
+ * Sort the list of best paths ascending, so that the best path is the first entry.
+ * @param session Pointer to a session whose paths are to be sorted.
+ */
+void
+t9_session_sort_paths(t9_session_t *const session);
+
+/*!
+ * Get the best text suggestion for the keys typed into a session so far.
+ * @note The user is responsible for destroying the suggestion using free once it is no longer required.
+ * @param session Pointer to a session to query.
+ * @param suggestion Pointer to a variable where the pointer to the resulting string is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_suggestion(const t9_session_t *const session,
+                      t9_symbol_t **suggestion);
+
+/*!
+ * Write the best suggestions for the keys typed into a session, the best one first, without allocating memory.
+ * The beam search decoder writes its best paths, the Viterbi decoder the best hypotheses of the last key and the A*
+ * decoder continues its search until it found the best hypotheses of capacity context states, which may grow its
+ * buffers.
+ * @param session Pointer to a session to query.
+ * @param suggestions Pointer to a buffer of capacity rows of stride symbols each. Suggestion i is written zero
+ * terminated to row i.
+ * @param stride Number of symbols per row. Must be at least the number of keys typed plus one.
+ * @param scores Pointer to an array of capacity scores. Score i is the negative log probability of suggestion i.
+ * @param capacity Maximal number of suggestions to be written.
+ * @param count Pointer to a variable where the number of suggestions written is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_nbest(t9_session_t *const session,
+                 t9_symbol_t *const suggestions,
+                 size_t stride,
+                 float *const scores,
+                 size_t capacity,
+                 size_t *const count);
+
+/*!
+ * Prune all nodes in a sessions search tree a given path consists of.
+ * @param session Pointer to a session that is to be pruned.
+ * @param path Pointer to a path that is to prune the search tree.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_prune_path(t9_session_t *const session,
+                      t9_path_t *const path);
+
+/*!
+ * Prune a leaf from a sessions search tree, together with all ancestors that are left without children.
+ * @param session Pointer to a session that is to be pruned.
+ * @param node Pointer to a leaf node that is to be removed.
+ * @param depth Level of the tree, the node to be removed is on.
+ */
+void
+t9_session_prune_leaf(t9_session_t *const session,
+                      t9_search_node_t *const node,
+                      size_t depth);
+
+/*!
+ * Helper function used to remove a search node from a session.
+ * @param session Pointer to a session from which a node is to me removed.
+ * @param node Pointer to a node that is to be removed.
+ * @param depth Level of the tree, the node to be removed is on.
+ */
+void __t9_session_prune_path_helper(t9_session_t *const session,
+                                    t9_search_node_t *const node,
+                                    size_t depth);
+
+/*!
+ * Helper function used to take a search node from the released ones of a session, or to create one.
+ * The node is erased, except for its empty list of children.
+ * @param session Pointer to a session.
+ * @return Pointer to a node. NULL if an error occurred.
+ */
+t9_search_node_t *
+__t9_session_node_new(t9_session_t *const session);
+
+/*!
+ * Helper function used to release a search node together with all of its descendants for reuse.
+ * The node must not be registered with its parent or with a level any more, its descendants are unregistered.
+ * @param session Pointer to a session.
+ * @param node Pointer to a node to be released.
+ */
+void
+__t9_session_node_release(t9_session_t *const session,
+                          t9_search_node_t *const node);
+
+/*!
+ * Helper function used to take a list entry from the released ones of a session, or to create one.
+ * @param session Pointer to a session.
+ * @param value Value of the entry.
+ * @return Pointer to an entry. NULL if an error occurred.
+ */
+list_node_t *
+__t9_session_entry_new(t9_session_t *const session,
+                       void *value);
+
+/*!
+ * Helper function used to remove an entry from a list and to release it for reuse.
+ * @param session Pointer to a session.
+ * @param list Pointer to the list holding the entry.
+ * @param entry Pointer to the entry to be removed.
+ */
+void
+__t9_session_entry_release(t9_session_t *const session,
+                           list_t *const list,
+                           list_node_t *const entry);
+
+/*!
+ * Helper function used to append an empty level to the search tree of a session, reusing a released one.
+ * @param session Pointer to a session.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_session_level_push(t9_session_t *const session);
+
+/*!
+ * Helper function used to release a level together with its entries for reuse. The nodes are not released.
+ * @param session Pointer to a session.
+ * @param level Pointer to a level that is no longer part of the search tree.
+ */
+void
+__t9_session_level_release(t9_session_t *const session,
+                           list_t *const level);
+
+/*!
+ * Helper function used to take an empty path from the released ones of a session, or to create one.
+ * @param session Pointer to a session.
+ * @return Pointer to a path. NULL if an error occurred.
+ */
+t9_path_t *
+__t9_session_path_new(t9_session_t *const session);
+
+/*!
+ * Helper function used to release a path for reuse.
+ * @param session Pointer to a session.
+ * @param path Pointer to a path that is no longer used.
+ */
+void
+__t9_session_path_release(t9_session_t *const session,
+                          t9_path_t *const path);
+
+/*!
+ * Helper function used to serialize a search node together with all of its descendants.
+ * @param session Pointer to the session that is serialized.
+ * @param node Pointer to the node to be serialized.
+ * @param parent Index of the record of the parent node.
+ * @param level Level of the tree, the node resides on.
+ * @param nodes Pointer to the array of node records.
+ * @param paths Pointer to the array of path records, whose leaves are set once they are serialized.
+ * @param number Pointer to the number of node records written so far.
+ */
+void
+__t9_session_serialize_node(const t9_session_t *const session,
+                            const t9_search_node_t *const node,
+                            uint32_t parent,
+                            uint32_t level,
+                            t9_session_state_node_t *const nodes,
+                            t9_session_state_path_t *const paths,
+                            uint32_t *const number);
+
+/*!
+ * Helper function used to restore the search tree and the best paths of a serialized session.
+ * @param session Pointer to a session that was reset.
+ * @param header Pointer to the header of the serialized session.
+ * @param records Pointer to the records following the header.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_session_deserialize_tree(t9_session_t *const session,
+                              const t9_session_state_t *const header,
+                              const uint8_t *const records);
+
+#endif //C_T9_SESSION_H
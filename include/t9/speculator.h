@@ -0,0 +1,249 @@
+/*!
+  ******************************************************************************
+  * @file    speculator.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for speculator.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_SPECULATOR_H
+#define C_T9_SPECULATOR_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libraries/kvec/kvec.h"
+
+// Forward declarations of speculator to break cyclic redundancy.
+struct struct_t9_speculator_t;
+typedef struct struct_t9_speculator_t t9_speculator_t;
+
+struct struct_t9_speculation_t;
+typedef struct struct_t9_speculation_t t9_speculation_t;
+
+// Vectors of symbols and speculations.
+// Note: kvec_t can not be used, because it defines the same struct name for every vector.
+#define kvec_speculation_t(type) struct struct_kvec_speculation {size_t n, m; type *a; }
+#define kvec_discarded_t(type) struct struct_kvec_discarded {size_t n, m; type *a; }
+
+#include "t9/errno.h"
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/session.h"
+
+// Index of a key, that is not being speculated on.
+#define T9_SPECULATOR_NO_KEY UINT8_MAX
+
+typedef kvec_speculation_t(t9_symbol_t) t9_speculation_output_t;
+typedef kvec_discarded_t(t9_speculation_t *) t9_speculation_vector_t;
+
+/*!
+ * Copy of a session, into which a key was typed ahead of time.
+ * The symbols the copy commits are held back, until the key is actually typed.
+ */
+struct struct_t9_speculation_t {
+    t9_session_t *session;
+    t9_speculation_output_t output;
+};
+
+typedef struct struct_t9_speculation_t t9_speculation_t;
+
+/*!
+ * Speculator. Types the most likely next keys into copies of a session on a background thread, while the user has
+ * not typed the next key yet. If the key typed next was speculated on, the session adopts the state of the copy and
+ * the key costs no decoding at all.
+ * Keys are speculated on in the order of their probability given the end of the best suggestion. Speculations that
+ * are not needed any more are released by the background thread as well.
+ */
+struct struct_t9_speculator_t {
+    t9_session_t *session;
+    uint8_t number_keys;
+    t9_symbol_t keys[NUM_LEXICON_SYMBOLS];
+    t9_speculation_t *speculations[NUM_LEXICON_SYMBOLS];
+    uint8_t queued;
+    uint8_t next;
+    uint8_t current;
+    t9_speculation_vector_t discarded;
+    uint64_t generation;
+    uint64_t working;
+    uint64_t hits;
+    uint64_t misses;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    bool shutdown;
+};
+
+typedef struct struct_t9_speculator_t t9_speculator_t;
+
+/*!
+ * Create a speculator for a session and start speculating on the first key.
+ * @note The user is responsible for destroying the speculator using t9_speculator_destroy once it is no longer
+ * required.
+ * @note While the speculator exists, keys must only be typed into the session and the session must only be reset or
+ * flushed using the speculator. The best suggestion can be taken from the session as usual, the n best suggestions
+ * have to be taken using t9_speculator_nbest.
+ * @param session Pointer to a session to speculate for.
+ * @param number_keys Number of most likely keys to speculate on after every key. Ranges from 1 to
+ * NUM_LEXICON_SYMBOLS.
+ * @return Pointer to a new speculator. NULL if an error occurred.
+ */
+t9_speculator_t *
+t9_speculator_create(t9_session_t *const session,
+                     uint8_t number_keys);
+
+/*!
+ * Destroy a speculator. The background thread is joined, the session is not destroyed.
+ * @param speculator Pointer to a speculator to be destroyed.
+ */
+void
+t9_speculator_destroy(t9_speculator_t *const speculator);
+
+/*!
+ * Type a single lexicon symbol into the session of a speculator.
+ * If the symbol was speculated on, the result of the speculation is adopted. If the speculation on the symbol is still
+ * running, it is waited for. Otherwise the symbol is typed into the session within the time budget as usual.
+ * Afterwards speculation on the next key starts.
+ * @param speculator Pointer to a speculator.
+ * @param symbol Lexicon symbol to be typed.
+ * @param budget_ms Time budget in milliseconds, used if the symbol was not speculated on. 0 disables the budget.
+ * @param truncated Pointer to a variable, where it is placed whether the search was cut short by the budget. May be
+ * NULL.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_speculator_insert(t9_speculator_t *const speculator,
+                     t9_symbol_t symbol,
+                     double budget_ms,
+                     bool *const truncated);
+
+/*!
+ * Get the n best suggestions of the session of a speculator (see t9_session_nbest).
+ * The A* decoder continues its search to find them, so the background thread does not copy the session meanwhile.
+ * @param speculator Pointer to a speculator.
+ * @param suggestions Pointer to capacity buffers of stride symbols each, where the suggestions are placed.
+ * @param stride Size of every buffer, at least the number of keys typed plus one.
+ * @param scores Pointer to capacity scores, where the scores of the suggestions are placed.
+ * @param capacity Maximal number of suggestions.
+ * @param count Pointer to a variable, where the number of suggestions placed is stored.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_speculator_nbest(t9_speculator_t *const speculator,
+                    t9_symbol_t *const suggestions,
+                    size_t stride,
+                    float *const scores,
+                    size_t capacity,
+                    size_t *const count);
+
+/*!
+ * Reset the session of a speculator and start speculating on the first key of a new sequence.
+ * @param speculator Pointer to a speculator.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_speculator_reset(t9_speculator_t *const speculator);
+
+/*!
+ * Flush the session of a speculator (see t9_session_flush) and start speculating on the first key of a new sequence.
+ * @param speculator Pointer to a speculator.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_speculator_flush(t9_speculator_t *const speculator);
+
+/*!
+ * Helper function used to stop all speculations and take the one on a given key.
+ * A running speculation on the key is waited for, all other speculations are passed to the background thread to be
+ * destroyed.
+ * @param speculator Pointer to a speculator.
+ * @param symbol Lexicon symbol to take the speculation for. 0 takes none.
+ * @return Pointer to the finished speculation on the symbol. NULL if there is none.
+ */
+t9_speculation_t *
+__t9_speculator_stop(t9_speculator_t *const speculator,
+                     t9_symbol_t symbol);
+
+/*!
+ * Helper function used to pass a speculation to the background thread to be destroyed.
+ * @param speculator Pointer to a speculator.
+ * @param speculation Pointer to a speculation that is no longer required. May be NULL.
+ */
+void
+__t9_speculator_discard(t9_speculator_t *const speculator,
+                        t9_speculation_t *const speculation);
+
+/*!
+ * Helper function used to rank the keys by their probability to be typed next and pass the most likely ones to the
+ * background thread.
+ * @param speculator Pointer to a speculator.
+ */
+void
+__t9_speculator_start(t9_speculator_t *const speculator);
+
+/*!
+ * Helper function used to run the main loop of the background thread.
+ * The thread destroys discarded speculations and speculates on the keys passed to it.
+ * @param arg Pointer to the speculator.
+ * @return Always NULL.
+ */
+void *
+__t9_speculator_worker(void *arg);
+
+/*!
+ * Helper function used to collect the symbols committed by a speculation.
+ * @param symbols Pointer to the committed symbols.
+ * @param length Number of committed symbols.
+ * @param arg Pointer to the speculation.
+ */
+void
+__t9_speculation_output(const t9_symbol_t *symbols,
+                        size_t length,
+                        void *arg);
+
+/*!
+ * Helper function used to create a speculation on a copy of a session.
+ * @param session Pointer to a session to be copied.
+ * @return Pointer to a new speculation. NULL if an error occurred.
+ */
+t9_speculation_t *
+__t9_speculation_create(const t9_session_t *const session);
+
+/*!
+ * Helper function used to destroy a speculation together with its session.
+ * @param speculation Pointer to a speculation to be destroyed.
+ */
+void
+__t9_speculation_destroy(t9_speculation_t *const speculation);
+
+#endif //C_T9_SPECULATOR_H
@@ -0,0 +1,153 @@
+/*!
+  ******************************************************************************
+  * @file    stats.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for stats.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_STATS_H
+#define C_T9_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "libraries/list/list.h"
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/node.h"
+#include "t9/session.h"
+
+// Number of depths of the corpus tree counted separately. Deeper nodes are counted at the last depth.
+#define T9_STATS_MAX_DEPTH 16
+
+/*!
+ * Memory and shape of a model. All sizes are in bytes and count what the structures hold, not the overhead of the
+ * allocator.
+ * - corpus_bytes: Train and test buffers of the corpus.
+ * - corpus_children_bytes: Used entries of the child vectors of the corpus nodes.
+ * - corpus_slack_bytes: Allocated but unused entries of the child vectors, which grow by doubling.
+ * - nodes_per_depth: Number of corpus nodes per depth, the root is at depth 0.
+ * - children_distribution: Number of corpus nodes per number of children.
+ */
+struct struct_t9_model_stats_t {
+    size_t model_bytes;
+    size_t corpus_bytes;
+    size_t corpus_nodes;
+    size_t corpus_node_bytes;
+    size_t corpus_children_bytes;
+    size_t corpus_slack_bytes;
+    size_t viterbi_bytes;
+    size_t table_bytes;
+    size_t total_bytes;
+    size_t depth;
+    size_t nodes_per_depth[T9_STATS_MAX_DEPTH];
+    size_t children_distribution[NUM_CORPUS_SYMBOLS + 1];
+};
+
+typedef struct struct_t9_model_stats_t t9_model_stats_t;
+
+/*!
+ * Memory of a session. All sizes are in bytes.
+ * - lists, list_nodes: Child lists of the search nodes and the lists of the level table, and their entries.
+ * - level_table_slack_bytes: Allocated but unused entries of the level table.
+ * - path_slack_bytes: Allocated but unused entries of the path vectors.
+ * - decoder_bytes: Lattice of the Viterbi or the search state of the A* decoder.
+ * - reuse_bytes: Released search nodes, list entries, levels and paths and the scratch buffers, kept for reuse.
+ */
+struct struct_t9_session_stats_t {
+    size_t session_bytes;
+    size_t search_nodes;
+    size_t search_node_bytes;
+    size_t lists;
+    size_t list_bytes;
+    size_t list_nodes;
+    size_t list_node_bytes;
+    size_t level_table_bytes;
+    size_t level_table_slack_bytes;
+    size_t paths;
+    size_t path_bytes;
+    size_t path_slack_bytes;
+    size_t decoder_bytes;
+    size_t reuse_bytes;
+    size_t total_bytes;
+};
+
+typedef struct struct_t9_session_stats_t t9_session_stats_t;
+
+/*!
+ * Measure the memory and the shape of a model. The corpus tree is walked once.
+ * @param model Pointer to the model to be measured.
+ * @param stats Pointer to the statistics to be filled.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_model_stats(const t9_model_t *const model,
+               t9_model_stats_t *const stats);
+
+/*!
+ * Measure the memory of a session. The search tree is walked once.
+ * @param session Pointer to the session to be measured.
+ * @param stats Pointer to the statistics to be filled.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_session_stats(const t9_session_t *const session,
+                 t9_session_stats_t *const stats);
+
+/*!
+ * Write the statistics of a model as a report.
+ * @param stats Pointer to the statistics to be written.
+ * @param fp Pointer to the file to be written to.
+ */
+void
+t9_model_stats_write(const t9_model_stats_t *const stats,
+                     FILE *const fp);
+
+/*!
+ * Helper function used to measure a corpus subtree.
+ * @param node Pointer to the root of the subtree.
+ * @param depth Depth of the node.
+ * @param stats Pointer to the statistics to be updated.
+ */
+void
+__t9_stats_corpus_node(const t9_corpus_node_t *const node,
+                       size_t depth,
+                       t9_model_stats_t *const stats);
+
+/*!
+ * Helper function used to measure a search subtree.
+ * @param node Pointer to the root of the subtree.
+ * @param stats Pointer to the statistics to be updated.
+ */
+void
+__t9_stats_search_node(const t9_search_node_t *const node,
+                       t9_session_stats_t *const stats);
+
+#endif //C_T9_STATS_H
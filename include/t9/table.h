@@ -0,0 +1,253 @@
+/*!
+  ******************************************************************************
+  * @file    table.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for table.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_TABLE_H
+#define C_T9_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward declarations of table to break cyclic redundancy.
+struct struct_t9_table_t;
+typedef struct struct_t9_table_t t9_table_t;
+
+#include "t9/errno.h"
+#include "t9/corpus.h"
+#include "t9/model.h"
+#include "t9/session.h"
+#include "t9/pool.h"
+
+// Maximal length of the key sequences of a table.
+#define T9_TABLE_MAX_LENGTH 5
+
+// Identification of tables within model files.
+#define T9_TABLE_MAGIC "T9TB"
+#define T9_TABLE_VERSION 2
+
+/*!
+ * Header of a table. Holds the decoding parameters the table was built with and the fingerprint of the corpus tree it
+ * was decoded from (see t9_corpus_tree_fingerprint). The table is only used by models with the same parameters and
+ * the same corpus tree.
+ */
+struct struct_t9_table_header_t {
+    char magic[4];
+    uint32_t version;
+    uint8_t length;
+    uint8_t decoder;
+    uint8_t ngram_length;
+    uint8_t rescore_length;
+    uint16_t number_paths;
+    uint16_t paths_per_context;
+    uint16_t rescore_paths;
+    float beam_threshold;
+    uint64_t number_nodes;
+    uint64_t checksum;
+    uint64_t number_entries;
+    uint64_t size;
+};
+
+typedef struct struct_t9_table_header_t t9_table_header_t;
+
+/*!
+ * Precomputed decoding results of all key sequences up to a given length.
+ * The entries are ordered by the length of their sequence, sequences of the same length are ordered by the lexicon
+ * indices of their keys. Every entry holds the number of best suggestions (uint32_t), the suggestions (length symbols
+ * each, without zero termination, best first) and the serialized session state after typing the sequence.
+ * offsets holds number_entries + 1 offsets into data, the entry i spans offsets[i] to offsets[i + 1].
+ */
+struct struct_t9_table_t {
+    t9_table_header_t header;
+    uint64_t *offsets;
+    uint8_t *data;
+};
+
+typedef struct struct_t9_table_t t9_table_t;
+
+/*!
+ * Entry of a table. Points into the memory of the table.
+ */
+struct struct_t9_table_entry_t {
+    const t9_symbol_t *suggestions;
+    size_t number_suggestions;
+    size_t length;
+    const uint8_t *state;
+    size_t size;
+};
+
+typedef struct struct_t9_table_entry_t t9_table_entry_t;
+
+/*!
+ * Job description of building a table.
+ */
+struct struct_t9_table_build_t {
+    const t9_model_t *model;
+    uint8_t length;
+    uint8_t **entries;
+    size_t *sizes;
+};
+
+typedef struct struct_t9_table_build_t t9_table_build_t;
+
+/*!
+ * Build a table of all key sequences up to a given length by decoding them with a model.
+ * The sequences form a complete trie of keys, which is walked depth first. Every prefix is decoded once, the session
+ * is copied where the trie branches. The subtrees of the first keys are distributed over the workers of a pool.
+ * Only the beam search decoder is supported, the states of the exact decoders are too large to be tabulated.
+ * @note The user is responsible for destroying the table using t9_table_destroy once it is no longer required.
+ * @param model Pointer to a model using the beam search decoder.
+ * @param length Maximal length of the key sequences. Ranges from 1 to T9_TABLE_MAX_LENGTH. There are
+ * 12 + 12^2 + ... + 12^length sequences.
+ * @param pool Pointer to a pool to be used for decoding. If NULL, the table is built by the calling thread.
+ * @param table Pointer to a variable where the pointer to the new table is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_table_build(const t9_model_t *const model,
+               uint8_t length,
+               t9_pool_t *const pool,
+               t9_table_t **table);
+
+/*!
+ * Destroy a table.
+ * @param table Pointer to a table to be destroyed.
+ */
+void
+t9_table_destroy(t9_table_t *const table);
+
+/*!
+ * Write a table to a file. Tables are written into model files (see t9_model_save).
+ * @param table Pointer to a table to be written.
+ * @param fp Pointer to a file opened for writing.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_table_write(const t9_table_t *const table,
+               FILE *const fp);
+
+/*!
+ * Read a table written by t9_table_write.
+ * @note The user is responsible for destroying the table using t9_table_destroy once it is no longer required.
+ * @param fp Pointer to a file opened for reading.
+ * @param table Pointer to a variable where the pointer to the new table is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_table_read(FILE *const fp,
+              t9_table_t **table);
+
+/*!
+ * Check whether a table was built with the decoding parameters and the corpus tree of a model.
+ * @param table Pointer to a table.
+ * @param model Pointer to a model.
+ * @return true if the model can use the table, otherwise false.
+ */
+bool
+t9_table_matches(const t9_table_t *const table,
+                 const t9_model_t *const model);
+
+/*!
+ * Look up the entry of a key sequence.
+ * @param table Pointer to a table.
+ * @param sequence Pointer to a lexicon sequence.
+ * @param length Length of the sequence. Ranges from 1 to the length of the table.
+ * @param entry Pointer to a structure where the entry is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_table_lookup(const t9_table_t *const table,
+                const t9_symbol_t *const sequence,
+                size_t length,
+                t9_table_entry_t *const entry);
+
+/*!
+ * Restore a new session to the state after the longest prefix of a key sequence held by a table.
+ * @param table Pointer to a table built with the decoding parameters of the model of the session.
+ * @param session Pointer to the session to be restored.
+ * @param sequence Pointer to a lexicon sequence.
+ * @param restored Pointer to a variable where the length of the restored prefix is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_table_resume(const t9_table_t *const table,
+                t9_session_t *const session,
+                const t9_symbol_t *const sequence,
+                size_t *const restored);
+
+/*!
+ * Helper function used to calculate the index of the entry of a key sequence.
+ * @param sequence Pointer to a lexicon sequence of valid lexicon symbols.
+ * @param length Length of the sequence.
+ * @return Index of the entry.
+ */
+size_t
+__t9_table_index(const t9_symbol_t *const sequence,
+                 size_t length);
+
+/*!
+ * Helper function used to calculate the number of key sequences up to a given length.
+ * @param length Maximal length of the key sequences.
+ * @return Number of entries of a table.
+ */
+uint64_t
+__t9_table_number_entries(uint8_t length);
+
+/*!
+ * Helper function used to build all entries whose sequences start with a given key.
+ * @param worker Index of the worker executing the task.
+ * @param index Lexicon index of the first key.
+ * @param arg Pointer to the job description.
+ */
+void
+__t9_table_build_task(size_t worker,
+                      size_t index,
+                      void *arg);
+
+/*!
+ * Helper function used to store the entry of a sequence typed into a session and build the entries of all of its
+ * continuations.
+ * @param build Pointer to the job description.
+ * @param session Pointer to the session the sequence was typed into. Is modified.
+ * @param sequence Pointer to a buffer of length symbols, holding the sequence.
+ * @param depth Length of the sequence.
+ */
+void
+__t9_table_build_node(t9_table_build_t *const build,
+                      t9_session_t *const session,
+                      t9_symbol_t *const sequence,
+                      size_t depth);
+
+#endif //C_T9_TABLE_H
@@ -35,15 +35,27 @@
 #ifndef C_T9_TIMER_H
 #define C_T9_TIMER_H
 
+// We use clock_gettime.
+// This function is a POSIX extension, not in C.
+#define _GNU_SOURCE
 #include <time.h>
 #include <stdint.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Duration the cycle counter is calibrated for.
+#define T9_TIMER_CALIBRATION_MS 10
+
 /*!
  * Timer that can be used to measure code execution times.
+ * The timer reads a monotonic wall clock in nanoseconds, so it measures the latency of single keys as well as the
+ * duration of work done by several threads.
  */
 struct struct_t9_timer_t {
-    clock_t start;
-    clock_t end;
+    uint64_t start;
+    uint64_t end;
 };
 
 typedef struct struct_t9_timer_t t9_timer_t;
@@ -77,4 +89,33 @@ t9_timer_restart(t9_timer_t *const timer);
 double
 t9_timer_duration_ms(t9_timer_t *const timer);
 
+/*!
+ * Query the time of a monotonic wall clock.
+ * @return Current time in milliseconds since an arbitrary starting point.
+ */
+double
+t9_timer_now_ms(void);
+
+/*!
+ * Query the time of a monotonic wall clock in nanoseconds.
+ * @return Current time in nanoseconds since an arbitrary starting point.
+ */
+uint64_t
+t9_timer_now_ns(void);
+
+/*!
+ * Read the cycle counter of the processor (rdtsc on x86). It is cheaper to read than the wall clock, but its rate has
+ * to be calibrated with t9_timer_cycles_per_ns. On other architectures the wall clock in nanoseconds is returned.
+ * @return Current value of the cycle counter.
+ */
+uint64_t
+t9_timer_cycles(void);
+
+/*!
+ * Calibrate the rate of the cycle counter against the wall clock. Takes about T9_TIMER_CALIBRATION_MS.
+ * @return Number of cycles per nanosecond.
+ */
+double
+t9_timer_cycles_per_ns(void);
+
 #endif //C_T9_TIMER_H
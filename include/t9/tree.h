@@ -49,15 +49,34 @@ typedef struct struct_t9_search_node_t t9_search_node_t;
 
 #include "t9/node.h"
 #include "t9/model.h"
+#include "t9/session.h"
+#include "t9/timer.h"
+#include "t9/profile.h"
 #include "libraries/list/list.h"
 
 #define PROBABILITY_BUTTON 1.0
 
+// Maximal number of symbols passed to the output of a session at once.
+#define T9_SEARCH_TREE_COMMIT_LENGTH 64
+
+// Share of the time budget of a key that may be spent on expanding leaves.
+#define T9_SEARCH_TREE_EXPANSION_BUDGET 0.5
+
+// Parameters of the FNV-1a hash a corpus tree is fingerprinted with.
+#define T9_CORPUS_TREE_HASH_OFFSET 14695981039346656037ULL
+#define T9_CORPUS_TREE_HASH_PRIME 1099511628211ULL
+
 /*!
  * Corpus tree. Used build a statistical model of a corpus.
+ * number_nodes and checksum fingerprint the tree, so that data derived from it can tell whether it still belongs to
+ * the tree (see t9_corpus_tree_fingerprint).
  */
 struct struct_t9_corpus_tree_t {
     t9_corpus_node_t *root;
+    // Length of the longest ngrams inserted into the tree (the depth of the tree).
+    uint16_t ngram_length;
+    uint64_t number_nodes;
+    uint64_t checksum;
 };
 
 typedef struct struct_t9_corpus_tree_t t9_corpus_tree_t;
@@ -72,6 +91,20 @@ struct struct_t9_search_tree_t {
 
 typedef struct struct_t9_search_tree_t t9_search_tree_t;
 
+/*!
+ * Leaf of a search tree together with the context of symbols that leads to it.
+ * Used to find hypotheses that can be recombined.
+ */
+struct struct_t9_search_tree_hypothesis_t {
+    t9_search_node_t *node;
+    const t9_symbol_t *context;
+    size_t length;
+    size_t next;
+    bool kept;
+};
+
+typedef struct struct_t9_search_tree_hypothesis_t t9_search_tree_hypothesis_t;
+
 
 /* === Corpus tree ================================================================== */
 
@@ -124,12 +157,29 @@ t9_corpus_tree_insert_ngrams(t9_corpus_tree_t *const tree,
                              uint16_t ngram_length);
 
 /*!
- * Calculate the probabilities for all tree nodes.
+ * Calculate the probabilities for all tree nodes. The tree is fingerprinted afterwards.
  * @param tree Pointer to a corpus tree to be finalized.
  */
 void
 t9_corpus_tree_finalize(t9_corpus_tree_t *const tree);
 
+/*!
+ * Fingerprint a corpus tree by the number of its nodes and a checksum of their symbols, counts and children.
+ * @note Finalizing a tree fingerprints it. Trees whose nodes are set otherwise have to be fingerprinted explicitly.
+ * @param tree Pointer to a corpus tree.
+ */
+void
+t9_corpus_tree_fingerprint(t9_corpus_tree_t *const tree);
+
+/*!
+ * Helper function used to fingerprint a corpus node and all of its descendants, depth first.
+ * @param node Pointer to a corpus node.
+ * @param tree Pointer to the corpus tree, whose number of nodes and checksum are updated.
+ */
+void
+__t9_corpus_tree_fingerprint_node(const t9_corpus_node_t *const node,
+                                  t9_corpus_tree_t *const tree);
+
 /* ================================================================================== */
 
 
@@ -151,42 +201,167 @@ t9_search_tree_create(void);
 void
 t9_search_tree_destroy(t9_search_tree_t *const tree);
 
+/*!
+ * Create a deep copy of a search tree, including its level table.
+ * @note The user is responsible for destroying the copy using t9_search_tree_destroy once it is no longer required.
+ * @param tree Pointer to a search tree to be copied.
+ * @return Pointer to a new search tree. NULL if an error occurred.
+ */
+t9_search_tree_t *
+t9_search_tree_clone(const t9_search_tree_t *const tree);
+
+/*!
+ * Helper function used to copy a search node with all of its descendants into a search tree.
+ * @param tree Pointer to the search tree the copy is added to. Its level table has to hold all levels already.
+ * @param parent Pointer to the copy of the parent of the node.
+ * @param node Pointer to the node to be copied.
+ * @param depth Level of the tree, the node resides on.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_search_tree_clone_node(t9_search_tree_t *const tree,
+                            t9_search_node_t *const parent,
+                            const t9_search_node_t *const node,
+                            size_t depth);
+
 /*!
  * Type a sequence of keys into the search tree and calculate the best text suggestions for the netered keys.
- * @param model Pointer to a model to be used for searching the best text suggestions.
+ * @param session Pointer to a session to be used for searching the best text suggestions.
  * @param sequence Pointer to a lexicon sequence to enter.
  * @return T9_SUCCESS on success. Otherwise T9_FAILURE.
  */
 t9_error_t
-t9_search_tree_type(t9_model_t *const model,
+t9_search_tree_type(t9_session_t *const session,
                     const t9_symbol_t *const sequence);
 
 /*!
- * Type a single symbol into a search tree and update the whole model.
- * This includes searching the best paths and pruning the model.
- * @param model Pointer to a model the key is to be typed into.
+ * Type a single symbol into a search tree and update the whole session.
+ * This includes searching the best paths and pruning the search tree. The level of the tree the new leaves are placed
+ * on has to be added to the level table beforehand.
+ * With a time budget, the leaves are expanded best first and the expansion stops once T9_SEARCH_TREE_EXPANSION_BUDGET
+ * of the budget is used up. Leaves that were not expanded in time are pruned, the best paths are then searched among
+ * the expanded ones. At least the best leaf is always expanded.
+ * With metrics, the duration of the key, the resulting beam size and the key itself are recorded.
+ * @param session Pointer to a session the key is to be typed into.
  * @param symbol Lexicon symbol to be typed.
+ * @param budget_ms Time budget of the expansion in milliseconds. 0 expands all leaves.
+ * @param truncated Pointer to a variable, where it is placed whether leaves were left unexpanded. May be NULL.
  * @return T9_SUCCESS on success. Otherwise T9_FAILURE.
  */
 t9_error_t
-t9_search_tree_insert(t9_model_t *const model,
-                      t9_symbol_t symbol);
+t9_search_tree_insert(t9_session_t *const session,
+                      t9_symbol_t symbol,
+                      double budget_ms,
+                      bool *const truncated);
+
+/*!
+ * Helper function used to type a single symbol into a search tree, without recording metrics.
+ * @param session Pointer to a session the key is to be typed into.
+ * @param symbol Lexicon symbol to be typed.
+ * @param budget_ms Time budget of the expansion in milliseconds. 0 expands all leaves.
+ * @param truncated Pointer to a variable, where it is placed whether leaves were left unexpanded. May be NULL.
+ * @return T9_SUCCESS on success. Otherwise T9_FAILURE.
+ */
+t9_error_t
+__t9_search_tree_insert(t9_session_t *const session,
+                        t9_symbol_t symbol,
+                        double budget_ms,
+                        bool *const truncated);
+
+/*!
+ * Update a session after new leaves were added to its search tree.
+ * The leaves are recombined and thresholded, the best paths are searched and the search tree is pruned.
+ * @param session Pointer to a session whose search tree was expanded.
+ * @return T9_SUCCESS on success. Otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_search_tree_update(t9_session_t *const session);
+
+/*!
+ * Helper function used to order search nodes ascending by their score.
+ * @param a Pointer to a pointer to the first search node.
+ * @param b Pointer to a pointer to the second search node.
+ * @return Negative if the first node is better, positive if the second node is better, otherwise 0.
+ */
+int
+__t9_search_tree_compare_nodes(const void *a,
+                               const void *b);
 
 /*!
  * Prune a search tree.
  * All nodes that are not an element of the best known paths are pruned.
- * @param model Pointer to a model containing the search tree to be pruned.
+ * @param session Pointer to a session containing the search tree to be pruned.
+ */
+void
+t9_search_tree_prune(t9_session_t *const session);
+
+/*!
+ * Recombine the leaves of a search tree.
+ * Under a ngram model, leaves sharing their last (ngram_length - 1) symbols have identical futures. Of every group of
+ * such leaves only the model->paths_per_context best are kept, all others are pruned. With rescoring, the contexts
+ * are (rescore_length - 1) symbols long, so paths the second pass tells apart are not merged.
+ * @param session Pointer to a session containing the search tree to be recombined.
+ * @return T9_SUCCESS on success. Otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_search_tree_recombine(t9_session_t *const session);
+
+/*!
+ * Rescore the best paths of a search tree with the rescore length of the model.
+ * The rescored score of a node is the one of its parent plus the key cost of the node and its language model cost
+ * under the rescore length. Only the nodes of best paths are rescored, most of their ancestors were rescored after
+ * earlier keys already. The paths are then sorted by their rescored score and cut to model->rescore_paths.
+ * @param session Pointer to a session whose best paths were searched.
  */
 void
-t9_search_tree_prune(t9_model_t *const model);
+t9_search_tree_rescore(t9_session_t *const session);
+
+/*!
+ * Helper function used to rescore a search node and all of its ancestors that were not rescored yet.
+ * @param session Pointer to the session containing the node.
+ * @param node Pointer to the node to be rescored.
+ */
+void
+__t9_search_tree_rescore_node(const t9_session_t *const session,
+                              t9_search_node_t *const node);
+
+/*!
+ * Prune all leaves of a search tree whose score is worse than the score of the best leaf plus model->beam_threshold.
+ * Unlike the pruning to model->number_paths, this is applied at every tree depth.
+ * @param session Pointer to a session containing the search tree to be pruned.
+ */
+void
+t9_search_tree_threshold(t9_session_t *const session);
+
+/*!
+ * Helper function used to mark the best hypotheses of a group of hypotheses sharing their context as kept.
+ * @param session Pointer to a session containing the search tree to be recombined.
+ * @param hypotheses Array of all hypotheses.
+ * @param head Index of the first hypothesis of the group. The group is linked by the next member.
+ */
+void
+__t9_search_tree_recombine_group(const t9_session_t *const session,
+                                 t9_search_tree_hypothesis_t *const hypotheses,
+                                 size_t head);
 
 /*!
  * Update the list of best paths by searching a search tree.
  * @note The existing list of best paths is overwritten.
- * @param model Pointer to a model containing the search tree to be used for searching.
+ * @param session Pointer to a session containing the search tree to be used for searching.
+ */
+void
+t9_search_tree_search_paths(t9_session_t *const session);
+
+/*!
+ * Commit the symbols all paths of a search tree agree on to the output of its session.
+ * As long as the root has a single child, and the leaves keep a full context of both passes (ngram_length and
+ * rescore_length) below it, the child becomes the new root and its level is removed from the level table. Scores are
+ * rebased on the new root, so they do not grow with the length of the input. The memory of the tree therefore stays
+ * bounded for arbitrarily long inputs.
+ * @param session Pointer to a session with an output callback.
  */
 void
-t9_search_tree_search_paths(t9_model_t *const model);
+t9_search_tree_commit(t9_session_t *const session);
 
 /* ================================================================================== */
 
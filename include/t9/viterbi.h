@@ -0,0 +1,234 @@
+/*!
+  ******************************************************************************
+  * @file    viterbi.h
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Header file for viterbi.c
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#ifndef C_T9_VITERBI_H
+#define C_T9_VITERBI_H
+
+// Forward declarations of the viterbi decoder to break cyclic redundancy.
+struct struct_t9_viterbi_t;
+typedef struct struct_t9_viterbi_t t9_viterbi_t;
+
+struct struct_t9_viterbi_lattice_t;
+typedef struct struct_t9_viterbi_lattice_t t9_viterbi_lattice_t;
+
+struct struct_t9_corpus_tree_t;
+typedef struct struct_t9_corpus_tree_t t9_corpus_tree_t;
+
+#define kvec_ventry_t(type) struct struct_kvec_ventry {size_t n, m; type *a; }
+#define kvec_vdepth_t(type) struct struct_kvec_vdepth {size_t n, m; type *a; }
+
+#include <stdint.h>
+#include "libraries/kvec/kvec.h"
+
+#include "t9/corpus.h"
+#include "t9/math.h"
+#include "t9/node.h"
+#include "t9/profile.h"
+#include "t9/tree.h"
+
+// Marks a state that has no entry in the current lattice column.
+#define T9_VITERBI_NO_ENTRY UINT32_MAX
+
+/*!
+ * Corpus tree compiled into a table of context states.
+ * The probability of a symbol only depends on the last (ngram_length - 1) symbols typed before. Every context that
+ * is a path of the corpus tree is a state. A context that is not a path of the tree leads to a probability of zero
+ * for every symbol, until a suffix of it grows back into a complete context. Such contexts are represented by a
+ * backoff state of their longest suffix that is a path of the tree.
+ *
+ * - transitions: Next state for every state and corpus symbol (number_states x NUM_CORPUS_SYMBOLS).
+ * - costs: Negative logarithmic probability of a corpus symbol in a state.
+ * - emissions: Negative logarithmic probability of a corpus symbol for a lexicon symbol.
+ * - minimal_costs: Lowest cost of a corpus symbol in any state. A lower bound for the cost of future symbols.
+ */
+struct struct_t9_viterbi_t {
+    uint8_t ngram_length;
+    size_t number_states;
+    uint32_t *transitions;
+    float *costs;
+    float emissions[NUM_LEXICON_SYMBOLS][NUM_CORPUS_SYMBOLS];
+    float minimal_costs[NUM_CORPUS_SYMBOLS];
+    t9_symbol_t symbols[NUM_CORPUS_SYMBOLS];
+};
+
+typedef struct struct_t9_viterbi_t t9_viterbi_t;
+
+/*!
+ * Best hypothesis ending in a state after a number of keys.
+ */
+struct struct_t9_viterbi_entry_t {
+    uint32_t state;
+    uint32_t previous;
+    float probability;
+    t9_symbol_t symbol;
+};
+
+typedef struct struct_t9_viterbi_entry_t t9_viterbi_entry_t;
+
+typedef kvec_ventry_t(t9_viterbi_entry_t) t9_viterbi_entry_vector_t;
+
+/*!
+ * Decoding lattice of a single sequence.
+ * The entries of all keys are stored in one vector. The entries of the last key typed start at column.
+ */
+struct struct_t9_viterbi_lattice_t {
+    const t9_viterbi_t *viterbi;
+    t9_viterbi_entry_vector_t entries;
+    size_t column;
+    size_t length;
+    uint32_t *slots;
+};
+
+typedef struct struct_t9_viterbi_lattice_t t9_viterbi_lattice_t;
+
+
+/*!
+ * Compile a corpus tree into a table of context states.
+ * @note The user is responsible for destroying the table using t9_viterbi_destroy once it is no longer required.
+ * @param tree Pointer to a finalized corpus tree.
+ * @param ngram_length Ngram length used to look up symbol probabilities. Must not exceed the ngram length the tree was
+ * built with.
+ * @return Pointer to a new table. NULL if an error occurred.
+ */
+t9_viterbi_t *
+t9_viterbi_compile(const t9_corpus_tree_t *const tree,
+                   uint8_t ngram_length);
+
+/*!
+ * Destroy a table of context states.
+ * @param viterbi Pointer to a table that is to be destroyed.
+ */
+void
+t9_viterbi_destroy(t9_viterbi_t *const viterbi);
+
+/*!
+ * Create an empty lattice decoding against a table of context states.
+ * @note The user is responsible for destroying the lattice using t9_viterbi_lattice_destroy once it is no longer
+ * required.
+ * @param viterbi Pointer to the table to be used for decoding.
+ * @return Pointer to a new lattice. NULL if an error occurred.
+ */
+t9_viterbi_lattice_t *
+t9_viterbi_lattice_create(const t9_viterbi_t *const viterbi);
+
+/*!
+ * Destroy a lattice. The table the lattice refers to is not destroyed.
+ * @param lattice Pointer to a lattice that is to be destroyed.
+ */
+void
+t9_viterbi_lattice_destroy(t9_viterbi_lattice_t *const lattice);
+
+/*!
+ * Create a copy of a lattice, which continues decoding independently of the original one.
+ * @note The user is responsible for destroying the copy using t9_viterbi_lattice_destroy once it is no longer required.
+ * @param lattice Pointer to a lattice to be copied.
+ * @return Pointer to a new lattice. NULL if an error occurred.
+ */
+t9_viterbi_lattice_t *
+t9_viterbi_lattice_clone(const t9_viterbi_lattice_t *const lattice);
+
+/*!
+ * Reset a lattice, so that the next key typed starts a new sequence.
+ * @param lattice Pointer to a lattice that is to be reset.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_viterbi_lattice_reset(t9_viterbi_lattice_t *const lattice);
+
+/*!
+ * Type a single lexicon symbol.
+ * For every state the best hypothesis ending in it is kept. No hypothesis is pruned, so the best suggestion is exact.
+ * @param lattice Pointer to a lattice the symbol is typed into.
+ * @param symbol Lexicon symbol to be typed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_viterbi_lattice_insert(t9_viterbi_lattice_t *const lattice,
+                          t9_symbol_t symbol);
+
+/*!
+ * Get the best text suggestion for the keys typed into a lattice so far.
+ * @note The user is responsible for destroying the suggestion using free once it is no longer required.
+ * @param lattice Pointer to a lattice to query.
+ * @param suggestion Pointer to a variable where the pointer to the resulting string is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_viterbi_lattice_suggestion(const t9_viterbi_lattice_t *const lattice,
+                              t9_symbol_t **suggestion);
+
+/*!
+ * Write the best suggestions for the keys typed into a lattice, the best one first, without allocating memory.
+ * Every state of the last key holds the best hypothesis ending in it, the suggestions are the best of them.
+ * @param lattice Pointer to a lattice to query.
+ * @param suggestions Pointer to a buffer of capacity rows of stride symbols each. Suggestion i is written zero
+ * terminated to row i.
+ * @param stride Number of symbols per row. Must be at least the number of keys typed plus one.
+ * @param scores Pointer to an array of capacity scores. Score i is the negative log probability of suggestion i.
+ * @param capacity Maximal number of suggestions to be written.
+ * @param count Pointer to a variable where the number of suggestions written is placed.
+ * @return T9_SUCCESS on success, otherwise T9_FAILURE.
+ */
+t9_error_t
+t9_viterbi_lattice_nbest(const t9_viterbi_lattice_t *const lattice,
+                         t9_symbol_t *const suggestions,
+                         size_t stride,
+                         float *const scores,
+                         size_t capacity,
+                         size_t *const count);
+
+/*!
+ * Helper function used to trace the symbols of a hypothesis back to the start of the sequence.
+ * @param lattice Pointer to a lattice to query.
+ * @param entry Index of the last entry of the hypothesis.
+ * @param suggestion Pointer to a buffer of (lattice->length + 1) symbols the text is written to.
+ */
+void
+__t9_viterbi_lattice_trace(const t9_viterbi_lattice_t *const lattice,
+                           size_t entry,
+                           t9_symbol_t *const suggestion);
+
+/*!
+ * Helper function used to find the state index of a corpus node while compiling.
+ * @param table Open addressing table of node pointers.
+ * @param size Size of the table. Must be a power of two.
+ * @param node Pointer to the node to look up.
+ * @return Index of the slot holding the node. If the node is not stored yet, the index of an empty slot.
+ */
+size_t
+__t9_viterbi_node_slot(const t9_corpus_node_t *const *const table,
+                       size_t size,
+                       const t9_corpus_node_t *const node);
+
+#endif //C_T9_VITERBI_H
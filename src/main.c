@@ -34,16 +34,967 @@
 
 #include "main.h"
 
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
 
-void build_corpus_tree(t9_model_t *const model) {
+#include "t9/cache.h"
+#include "t9/dictionary.h"
+#include "t9/server.h"
+#include "t9/table.h"
+
+// Server stopped by the signal handler of the serve command.
+static t9_server_t *server_instance = NULL;
+
+void options_usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s <command> [options]\n"
+            "\n"
+            "Commands:\n"
+            "  train     Train a model on the corpus and write it to --out.\n"
+            "  eval      Evaluate a model on the test corpus.\n"
+            "  sweep     Evaluate a model for several ngram lengths and numbers of paths.\n"
+            "  stream    Decode the test corpus as a single stream of keys.\n"
+            "  complete  Complete key sequences read from stdin, one per line.\n"
+            "  bench     Measure the batch completion throughput, prints CSV.\n"
+            "  stats     Report the memory of the model and of a session after every key.\n"
+            "  serve     Serve completions on the Unix domain socket --socket.\n"
+            "\n"
+            "Options:\n"
+            "  -c, --corpus PATH            Corpus to train on and to take the test data from (default: %s).\n"
+            "  -m, --model PATH             Model file written by train, used instead of training.\n"
+            "  -o, --out PATH               Model file to be written by train.\n"
+            "  -t, --table-length N         Keys per sequence of the table built by train and written into the model,\n"
+            "                               0 for none (default: 0).\n"
+            "  -w, --words N                Words per key sequence of the dictionary built by train (default: %u),\n"
+            "                               completions of the last word per line of complete and per response of\n"
+            "                               serve (default: 0).\n"
+            "  -L, --train-limit BYTES      Bytes of the corpus to train on, 0 for all (default: 0).\n"
+            "  -l, --test-limit BYTES       Bytes of the corpus to test on, 0 for all (default: 1000).\n"
+            "  -n, --ngram N                Ngram length (default: %u).\n"
+            "  -p, --paths N                Number of best paths (default: %u).\n"
+            "  -P, --paths-per-context N    Paths per ngram context, 0 disables recombination (default: %u).\n"
+            "  -B, --threshold SCORE        Beam threshold, 0 disables it (default: %.0f).\n"
+            "  -d, --decoder NAME           beam, viterbi or astar (default: beam).\n"
+            "  -r, --rescore-length N       Ngram length of the rescoring pass, 0 disables it.\n"
+            "  -R, --rescore-paths N        Number of rescored paths, 0 keeps all.\n"
+            "  -j, --threads N              Worker threads, 0 for all processors (default: 0).\n"
+            "  -b, --batch N                Lines per batch of complete (default: 64).\n"
+            "  -k, --nbest N                Suggestions per line of complete and per request of serve.\n"
+            "  -S, --sequences N            Sequences of bench (default: 1000).\n"
+            "  -K, --length N               Keys per sequence of bench and keys typed by stats (default: 20).\n"
+            "  -s, --socket PATH            Socket of serve.\n"
+            "  -M, --metrics PATH           Metrics socket of serve (default: <socket>.metrics).\n"
+            "  -C, --cache BYTES            Capacity of the cache of decoder states of complete and serve, sequences\n"
+            "                               resume from their longest cached prefix. 0 disables it (default: 0).\n"
+            "  -e, --speculate N            Keys serve speculates on ahead of time per connection, on a thread per\n"
+            "                               connection. 0 disables speculation (default: 0).\n"
+            "  -h, --help                   Print this help.\n",
+            name, MAIN_DEFAULT_CORPUS, MAIN_DEFAULT_DICTIONARY_WORDS, MAIN_DEFAULT_NGRAM_LENGTH,
+            MAIN_DEFAULT_NUMBER_PATHS, MAIN_DEFAULT_PATHS_PER_CONTEXT, (double) MAIN_DEFAULT_BEAM_THRESHOLD);
+}
+
+bool options_parse(int argc, char **argv, options_t *const options) {
+    const struct option long_options[] = {
+            {"corpus",            required_argument, NULL, 'c'},
+            {"model",             required_argument, NULL, 'm'},
+            {"out",               required_argument, NULL, 'o'},
+            {"table-length",      required_argument, NULL, 't'},
+            {"words",             required_argument, NULL, 'w'},
+            {"train-limit",       required_argument, NULL, 'L'},
+            {"test-limit",        required_argument, NULL, 'l'},
+            {"ngram",             required_argument, NULL, 'n'},
+            {"paths",             required_argument, NULL, 'p'},
+            {"paths-per-context", required_argument, NULL, 'P'},
+            {"threshold",         required_argument, NULL, 'B'},
+            {"decoder",           required_argument, NULL, 'd'},
+            {"rescore-length",    required_argument, NULL, 'r'},
+            {"rescore-paths",     required_argument, NULL, 'R'},
+            {"threads",           required_argument, NULL, 'j'},
+            {"batch",             required_argument, NULL, 'b'},
+            {"nbest",             required_argument, NULL, 'k'},
+            {"sequences",         required_argument, NULL, 'S'},
+            {"length",            required_argument, NULL, 'K'},
+            {"socket",            required_argument, NULL, 's'},
+            {"metrics",           required_argument, NULL, 'M'},
+            {"cache",             required_argument, NULL, 'C'},
+            {"speculate",         required_argument, NULL, 'e'},
+            {"help",              no_argument,       NULL, 'h'},
+            {NULL, 0,                                NULL, 0}
+    };
+    unsigned long value;
+    char *end;
+    int option;
+
+    memset(options, 0, sizeof(options_t));
+    options->test_limit = 1000;
+    options->paths_per_context = -1;
+    options->beam_threshold = -1.0f;
+    options->decoder = UINT8_MAX;
+    options->batch = 64;
+    options->sequences = 1000;
+    options->length = 20;
+
+    if (argc < 2 || argv[1][0] == '-') {
+        return false;
+    }
+    options->command = argv[1];
+
+    // The command takes the place of the program name.
+    while ((option = getopt_long(argc - 1, argv + 1, "c:m:o:t:w:L:l:n:p:P:B:d:r:R:j:b:k:S:K:s:M:C:e:h", long_options,
+                                 NULL)) != -1) {
+        // Every numeric option is a non-negative integer, except for the threshold.
+        value = 0;
+        if (optarg != NULL && strchr("twLlnpPrRjbkSKCe", option) != NULL) {
+            value = strtoul(optarg, &end, 10);
+            if (optarg[0] == '\0' || optarg[0] == '-' || *end != '\0') {
+                fprintf(stderr, "Error: Invalid number \"%s\".\n", optarg);
+                return false;
+            }
+        }
+
+        switch (option) {
+            case 'c':
+                options->corpus = optarg;
+                break;
+            case 'm':
+                options->model = optarg;
+                break;
+            case 'o':
+                options->out = optarg;
+                break;
+            case 't':
+                if (value > T9_TABLE_MAX_LENGTH) {
+                    fprintf(stderr, "Error: The table length must be within 0 and %u.\n", T9_TABLE_MAX_LENGTH);
+                    return false;
+                }
+                options->table_length = (uint8_t) value;
+                break;
+            case 'w':
+                if (value > UINT8_MAX) {
+                    fprintf(stderr, "Error: The number of words must be within 0 and %u.\n", UINT8_MAX);
+                    return false;
+                }
+                options->words = (uint8_t) value;
+                break;
+            case 'L':
+                options->train_limit = value;
+                break;
+            case 'l':
+                options->test_limit = value;
+                break;
+            case 'n':
+                if (value == 0 || value > UINT8_MAX) {
+                    fprintf(stderr, "Error: The ngram length must be within 1 and %u.\n", UINT8_MAX);
+                    return false;
+                }
+                options->ngram_length = (uint8_t) value;
+                break;
+            case 'p':
+                if (value == 0 || value > UINT16_MAX) {
+                    fprintf(stderr, "Error: The number of paths must be within 1 and %u.\n", UINT16_MAX);
+                    return false;
+                }
+                options->number_paths = (uint16_t) value;
+                break;
+            case 'P':
+                if (value > UINT16_MAX) {
+                    fprintf(stderr, "Error: The paths per context must be within 0 and %u.\n", UINT16_MAX);
+                    return false;
+                }
+                options->paths_per_context = (int32_t) value;
+                break;
+            case 'B':
+                options->beam_threshold = strtof(optarg, &end);
+                if (optarg[0] == '\0' || *end != '\0' || options->beam_threshold < 0.0f) {
+                    fprintf(stderr, "Error: Invalid threshold \"%s\".\n", optarg);
+                    return false;
+                }
+                break;
+            case 'd':
+                if (strcmp(optarg, "beam") == 0) {
+                    options->decoder = T9_DECODER_BEAM;
+                } else if (strcmp(optarg, "viterbi") == 0) {
+                    options->decoder = T9_DECODER_VITERBI;
+                } else if (strcmp(optarg, "astar") == 0) {
+                    options->decoder = T9_DECODER_ASTAR;
+                } else {
+                    fprintf(stderr, "Error: Unknown decoder \"%s\".\n", optarg);
+                    return false;
+                }
+                break;
+            case 'r':
+                options->rescore_length = (uint8_t) (value > UINT8_MAX ? UINT8_MAX : value);
+                break;
+            case 'R':
+                options->rescore_paths = (uint16_t) (value > UINT16_MAX ? UINT16_MAX : value);
+                break;
+            case 'j':
+                options->threads = (uint16_t) (value > UINT16_MAX ? UINT16_MAX : value);
+                break;
+            case 'b':
+                options->batch = value > 0 ? value : 1;
+                break;
+            case 'k':
+                options->nbest = (uint8_t) (value > UINT8_MAX ? UINT8_MAX : value);
+                break;
+            case 'S':
+                options->sequences = value > 0 ? value : 1;
+                break;
+            case 'K':
+                options->length = value > 0 ? value : 1;
+                break;
+            case 's':
+                options->socket = optarg;
+                break;
+            case 'M':
+                options->metrics = optarg;
+                break;
+            case 'C':
+                options->cache = value;
+                break;
+            case 'e':
+                if (value > NUM_LEXICON_SYMBOLS) {
+                    fprintf(stderr, "Error: The number of keys to speculate on must be within 0 and %u.\n",
+                            NUM_LEXICON_SYMBOLS);
+                    return false;
+                }
+                options->speculate = (uint8_t) value;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        fprintf(stderr, "Error: Unexpected argument \"%s\".\n", argv[optind + 1]);
+        return false;
+    }
+
+    // Without a model there is nothing to decode but the default corpus.
+    if (options->model == NULL && options->corpus == NULL) {
+        options->corpus = MAIN_DEFAULT_CORPUS;
+    }
+
+    return true;
+}
+
+t9_model_t *model_prepare(const options_t *const options) {
+    t9_model_t *model;
+    t9_decoder_t decoder;
+    double start;
+
+    start = t9_timer_now_ms();
+    if (options->model != NULL) {
+        if (t9_model_load(options->model, &model) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not load model \"%s\".\n", options->model);
+            return NULL;
+        }
+    } else {
+        model = t9_model_create();
+        if (model == NULL) {
+            fprintf(stderr, "Error: Could not create a model.\n");
+            return NULL;
+        }
+    }
+
+    // The corpus provides the train data of a new model and the test data of both.
+    if (options->corpus != NULL) {
+        if (t9_corpus_load(options->corpus, options->train_limit,
+                           options->corpus, options->test_limit,
+                           &model->corpus) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not load corpus \"%s\".\n", options->corpus);
+            t9_model_destroy(model);
+            return NULL;
+        }
+    }
+
+    if (options->model == NULL) {
+        // A new model takes the decoding parameters given on the command line, or the defaults.
+        model->ngram_length = options->ngram_length > 0 ? options->ngram_length : MAIN_DEFAULT_NGRAM_LENGTH;
+        model->number_paths = options->number_paths > 0 ? options->number_paths : MAIN_DEFAULT_NUMBER_PATHS;
+        model->paths_per_context = options->paths_per_context >= 0 ? (uint16_t) options->paths_per_context
+                                                                   : MAIN_DEFAULT_PATHS_PER_CONTEXT;
+        model->beam_threshold = options->beam_threshold >= 0.0f ? options->beam_threshold
+                                                                : MAIN_DEFAULT_BEAM_THRESHOLD;
+        model->rescore_length = options->rescore_length;
+        model->rescore_paths = options->rescore_paths;
+        if (build_corpus_tree(model) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not build the corpus tree.\n");
+            t9_model_destroy(model);
+            return NULL;
+        }
+
+        // The dictionary is built if it is written with the model or words are to be completed.
+        if ((strcmp(options->command, "train") == 0 || options->words > 0)
+            && build_dictionary(model, options->words > 0 ? options->words : MAIN_DEFAULT_DICTIONARY_WORDS)
+               != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not build the dictionary.\n");
+            t9_model_destroy(model);
+            return NULL;
+        }
+    } else {
+        // A tree holds the statistics of all ngrams up to the length it was built with.
+        if (options->ngram_length > model->corpus_tree->ngram_length
+            || options->rescore_length > model->corpus_tree->ngram_length) {
+            fprintf(stderr, "Error: The model holds ngrams up to a length of %u.\n", model->corpus_tree->ngram_length);
+            t9_model_destroy(model);
+            return NULL;
+        }
+
+        // Decoding parameters given on the command line override the ones of a loaded model.
+        if (options->ngram_length > 0) {
+            model->ngram_length = options->ngram_length;
+        }
+        if (options->number_paths > 0) {
+            model->number_paths = options->number_paths;
+        }
+        if (options->paths_per_context >= 0) {
+            model->paths_per_context = (uint16_t) options->paths_per_context;
+        }
+        if (options->beam_threshold >= 0.0f) {
+            model->beam_threshold = options->beam_threshold;
+        }
+        if (options->rescore_length > 0) {
+            model->rescore_length = options->rescore_length;
+            model->rescore_paths = options->rescore_paths;
+        }
+    }
+
+    if (options->words > 0 && model->dictionary == NULL) {
+        fprintf(stderr, "Error: The model holds no dictionary to complete words with.\n");
+        t9_model_destroy(model);
+        return NULL;
+    }
+
+    // Recompile the context states in case the ngram length changed.
+    decoder = options->decoder != UINT8_MAX ? options->decoder : model->decoder;
+    if (t9_model_set_decoder(model, decoder) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Could not select the decoder.\n");
+        t9_model_destroy(model);
+        return NULL;
+    }
+
+    fprintf(stderr, "[Model]: %s in %.2f ms (ngram %u, paths %u, threshold %.1f).\n",
+            options->model != NULL ? "Loaded" : "Trained", t9_timer_now_ms() - start,
+            model->ngram_length, model->number_paths, (double) model->beam_threshold);
+    return model;
+}
+
+t9_error_t build_dictionary(t9_model_t *const model, uint16_t number_words) {
+    t9_dictionary_t *dictionary;
+
+    dictionary = t9_dictionary_create(number_words);
+    if (dictionary == NULL) {
+        return T9_FAILURE;
+    }
+    if (t9_dictionary_insert_corpus(dictionary, &model->corpus) != T9_SUCCESS) {
+        t9_dictionary_destroy(dictionary);
+        return T9_FAILURE;
+    }
+    t9_dictionary_finalize(dictionary);
+
+    model->dictionary = dictionary;
+    return T9_SUCCESS;
+}
+
+t9_error_t build_corpus_tree(t9_model_t *const model) {
     t9_corpus_tree_t *corpus_tree;
+    uint8_t length;
+
+    // The tree holds the ngrams of both the first pass and the rescoring pass.
+    length = model->rescore_length > model->ngram_length ? model->rescore_length : model->ngram_length;
 
     // Build a corpus tree.
     corpus_tree = t9_corpus_tree_create();
-    t9_corpus_tree_insert_ngrams(corpus_tree, &model->corpus, model->ngram_length);
+    if (corpus_tree == NULL) {
+        return T9_FAILURE;
+    }
+    if (t9_corpus_tree_insert_ngrams(corpus_tree, &model->corpus, length) != T9_SUCCESS) {
+        t9_corpus_tree_destroy(corpus_tree);
+        return T9_FAILURE;
+    }
     t9_corpus_tree_finalize(corpus_tree);
 
     model->corpus_tree = corpus_tree;
+    return T9_SUCCESS;
+}
+
+int command_train(const options_t *const options) {
+    t9_model_t *model;
+    t9_table_t *table;
+    t9_pool_t *pool;
+    double start;
+
+    if (options->out == NULL) {
+        fprintf(stderr, "Error: train requires --out.\n");
+        return EXIT_FAILURE;
+    }
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    // The table holds the results of the decoding parameters of the model, it has to be rebuilt once they change.
+    if (options->table_length > 0) {
+        start = t9_timer_now_ms();
+        pool = t9_pool_create(options->threads);
+        if (pool == NULL || t9_table_build(model, options->table_length, pool, &table) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not build the table.\n");
+            t9_pool_destroy(pool);
+            t9_model_destroy(model);
+            return EXIT_FAILURE;
+        }
+        t9_pool_destroy(pool);
+
+        if (t9_model_set_table(model, table) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Could not attach the table.\n");
+            t9_table_destroy(table);
+            t9_model_destroy(model);
+            return EXIT_FAILURE;
+        }
+        printf("[Train]: Built %lu table entries in %.2f ms.\n",
+               (unsigned long) table->header.number_entries, t9_timer_now_ms() - start);
+    }
+
+    if (t9_model_save(model, options->out) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Could not write model \"%s\".\n", options->out);
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+    printf("[Train]: Wrote %lu nodes to \"%s\".\n",
+           (unsigned long) __t9_model_count_nodes(model->corpus_tree->root), options->out);
+
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int command_eval(const options_t *const options) {
+    t9_model_t *model;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+    if (model->corpus.test_buffer_size == 0) {
+        fprintf(stderr, "Error: eval requires --corpus.\n");
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    example_evaluation(model, options->threads);
+
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int command_sweep(const options_t *const options) {
+    t9_model_t *model;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+    if (model->corpus.test_buffer_size == 0) {
+        fprintf(stderr, "Error: sweep requires --corpus.\n");
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    example_sweep(model, options->threads);
+
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int command_stream(const options_t *const options) {
+    t9_model_t *model;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    example_stream(model);
+
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int reader_next(reader_t *const reader, bool block, char **line) {
+    struct pollfd descriptor;
+    char *newline;
+    ssize_t received;
+
+    for (;;) {
+        newline = (char *) memchr(reader->buffer + reader->start, '\n', reader->end - reader->start);
+        if (newline != NULL || (reader->eof == true && reader->start < reader->end)) {
+            if (newline == NULL) {
+                newline = reader->buffer + reader->end;
+            }
+            *newline = '\0';
+            *line = reader->buffer + reader->start;
+            reader->start = (size_t) (newline - reader->buffer) + 1;
+            if (reader->start > reader->end) {
+                reader->start = reader->end;
+            }
+
+            // Accept line endings of both kinds.
+            if (newline > *line && newline[-1] == '\r') {
+                newline[-1] = '\0';
+            }
+            return 1;
+        }
+        if (reader->eof == true) {
+            return -1;
+        }
+
+        if (block == false) {
+            descriptor.fd = reader->fd;
+            descriptor.events = POLLIN;
+            descriptor.revents = 0;
+            if (poll(&descriptor, 1, 0) <= 0) {
+                return 0;
+            }
+        }
+
+        // Move the incomplete line to the front. A line filling the whole buffer is split.
+        if (reader->start > 0) {
+            memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+            reader->end -= reader->start;
+            reader->start = 0;
+        }
+        if (reader->end == MAIN_READ_BUFFER_SIZE) {
+            reader->buffer[reader->end] = '\0';
+            *line = reader->buffer;
+            reader->start = reader->end;
+            return 1;
+        }
+
+        received = read(reader->fd, reader->buffer + reader->end, MAIN_READ_BUFFER_SIZE - reader->end);
+        if (received > 0) {
+            reader->end += (size_t) received;
+        } else if (received == 0 || errno != EINTR) {
+            reader->eof = true;
+        }
+    }
+}
+
+void complete_batch(const t9_model_t *const model, char **lines, size_t count, uint8_t nbest, uint8_t words,
+                    t9_cache_t *const cache, t9_pool_t *const pool) {
+    t9_symbol_t **suggestions;
+    t9_session_t *session;
+    t9_symbol_t *buffer;
+    t9_error_t error;
+    float *scores;
+    size_t capacity;
+    size_t number;
+    size_t stride;
+    size_t i;
+    size_t j;
+
+    if (nbest == 0 && cache == NULL) {
+        // Lines that can not be completed are answered with an empty line.
+        suggestions = (t9_symbol_t **) calloc(count, sizeof(t9_symbol_t *));
+        if (suggestions != NULL) {
+            t9_model_autocomplete_batch(model, (const t9_symbol_t *const *) lines, count, suggestions, pool);
+        }
+        for (i = 0; i < count; i++) {
+            printf("%s", suggestions != NULL && suggestions[i] != NULL ? (const char *) suggestions[i] : "");
+            complete_words(model, lines[i], words);
+            printf("\n");
+            if (suggestions != NULL) {
+                free(suggestions[i]);
+            }
+            free(lines[i]);
+        }
+        free(suggestions);
+        fflush(stdout);
+        return;
+    }
+
+    // Every line of suggestions holds the suggestions and their scores, separated by tabs. Lines decoded with the
+    // cache but without --nbest hold the best suggestion only, like the ones of a batch.
+    capacity = nbest > 0 ? nbest : 1;
+    session = t9_session_create(model);
+    scores = (float *) calloc(capacity, sizeof(float));
+    for (i = 0; i < count; i++) {
+        number = 0;
+        stride = strlen(lines[i]) + 1;
+        buffer = (t9_symbol_t *) calloc(capacity, stride);
+        if (session != NULL && scores != NULL && buffer != NULL) {
+            if (cache != NULL) {
+                error = t9_cache_type(cache, session, (const t9_symbol_t *) lines[i], 0);
+                if (error == T9_SUCCESS) {
+                    error = t9_session_nbest(session, buffer, stride, scores, capacity, &number);
+                }
+            } else {
+                error = t9_model_autocomplete_nbest(model, session, (const t9_symbol_t *) lines[i], buffer, stride,
+                                                    scores, capacity, &number);
+            }
+            if (error != T9_SUCCESS) {
+                number = 0;
+            }
+        }
+        for (j = 0; j < number && nbest == 0; j++) {
+            printf("%s", (const char *) (buffer + j * stride));
+        }
+        for (j = 0; j < number && nbest > 0; j++) {
+            printf("%s%s\t%.3f", j > 0 ? "\t" : "", (const char *) (buffer + j * stride), (double) scores[j]);
+        }
+        complete_words(model, lines[i], words);
+        printf("\n");
+        free(buffer);
+        free(lines[i]);
+    }
+    free(scores);
+    t9_session_destroy(session);
+    fflush(stdout);
+}
+
+void complete_words(const t9_model_t *const model, const char *const line, uint8_t words) {
+    const t9_dictionary_word_t *const *completions;
+    const t9_symbol_t *word;
+    size_t count;
+    size_t i;
+
+    if (words == 0) {
+        return;
+    }
+
+    // Nothing is completed before the first key of a word.
+    count = 0;
+    word = t9_dictionary_last_word((const t9_symbol_t *) line);
+    if (*word != 0 && t9_dictionary_complete(model->dictionary, word, &completions, &count) != T9_SUCCESS) {
+        count = 0;
+    }
+
+    printf("\t");
+    for (i = 0; i < count && i < words; i++) {
+        printf("%s%s", i > 0 ? " " : "", (const char *) completions[i]->word);
+    }
+}
+
+int command_complete(const options_t *const options) {
+    t9_model_t *model;
+    t9_cache_t *cache;
+    t9_pool_t *pool;
+    reader_t *reader;
+    char **lines;
+    char *line;
+    size_t count;
+    int status;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    pool = t9_pool_create(options->threads);
+    reader = (reader_t *) calloc(1, sizeof(reader_t));
+    lines = (char **) calloc(options->batch, sizeof(char *));
+    cache = options->cache > 0 ? t9_cache_create(options->cache) : NULL;
+    if (pool == NULL || reader == NULL || lines == NULL || (options->cache > 0 && cache == NULL)) {
+        fprintf(stderr, "Error: Could not allocate the batch.\n");
+        t9_cache_destroy(cache);
+        free(lines);
+        free(reader);
+        t9_pool_destroy(pool);
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+    reader->fd = STDIN_FILENO;
+
+    // Wait for input only while the batch is empty, a partial batch is decoded once the input pauses.
+    count = 0;
+    while ((status = reader_next(reader, count == 0, &line)) >= 0) {
+        if (status == 1) {
+            lines[count] = strdup(line);
+            if (lines[count] != NULL) {
+                count++;
+            }
+        }
+        if (count > 0 && (status == 0 || count == options->batch)) {
+            complete_batch(model, lines, count, options->nbest, options->words, cache, pool);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        complete_batch(model, lines, count, options->nbest, options->words, cache, pool);
+    }
+
+    cache_report(cache);
+    t9_cache_destroy(cache);
+    free(lines);
+    free(reader);
+    t9_pool_destroy(pool);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int command_bench(const options_t *const options) {
+    const char *decoders[] = {"beam", "viterbi", "astar"};
+    const char *modes[] = {"batch", "shared"};
+    t9_symbol_t **suggestions;
+    t9_symbol_t **sequences;
+    t9_symbol_t *keys;
+    t9_model_t *model;
+    t9_pool_t *pool;
+    t9_timer_t timer;
+    t9_error_t error;
+    size_t number_keys;
+    size_t offset;
+    size_t mode;
+    size_t i;
+    double duration;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    // Convert the test corpus to keys, the sequences are consecutive windows of them.
+    keys = (t9_symbol_t *) malloc(model->corpus.test_buffer_size + 1);
+    number_keys = 0;
+    for (i = 0; keys != NULL && i < model->corpus.test_buffer_size; i++) {
+        if (t9_corpus_ctol(model->corpus.test_buffer[i], &keys[number_keys]) == T9_SUCCESS) {
+            number_keys++;
+        }
+    }
+    if (keys == NULL || number_keys < options->length) {
+        fprintf(stderr, "Error: bench requires a test corpus of at least %zu keys.\n", options->length);
+        free(keys);
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    pool = t9_pool_create(options->threads);
+    sequences = (t9_symbol_t **) calloc(options->sequences, sizeof(t9_symbol_t *));
+    suggestions = (t9_symbol_t **) calloc(options->sequences, sizeof(t9_symbol_t *));
+    for (i = 0; sequences != NULL && i < options->sequences; i++) {
+        sequences[i] = (t9_symbol_t *) calloc(options->length + 1, sizeof(t9_symbol_t));
+        if (sequences[i] == NULL) {
+            break;
+        }
+        offset = (i * options->length) % (number_keys - options->length + 1);
+        memcpy(sequences[i], keys + offset, options->length);
+    }
+    free(keys);
+    if (pool == NULL || sequences == NULL || suggestions == NULL || i < options->sequences) {
+        fprintf(stderr, "Error: Could not allocate the sequences.\n");
+        for (i = 0; sequences != NULL && i < options->sequences; i++) {
+            free(sequences[i]);
+        }
+        free(sequences);
+        free(suggestions);
+        t9_pool_destroy(pool);
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    printf("mode,decoder,threads,sequences,length,duration_ms,keys_per_second,us_per_sequence\n");
+    for (mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++) {
+        t9_timer_start(&timer);
+        if (mode == 0) {
+            error = t9_model_autocomplete_batch(model, (const t9_symbol_t *const *) sequences, options->sequences,
+                                                suggestions, pool);
+        } else {
+            error = t9_model_autocomplete_shared(model, (const t9_symbol_t *const *) sequences, options->sequences,
+                                                 suggestions, pool);
+        }
+        t9_timer_stop(&timer);
+        for (i = 0; i < options->sequences; i++) {
+            free(suggestions[i]);
+        }
+        if (error != T9_SUCCESS) {
+            fprintf(stderr, "Error: Decoding the %s batch failed.\n", modes[mode]);
+            continue;
+        }
+
+        duration = t9_timer_duration_ms(&timer);
+        printf("%s,%s,%u,%zu,%zu,%.3f,%.1f,%.3f\n", modes[mode], decoders[model->decoder],
+               (unsigned int) pool->number_threads, options->sequences, options->length, duration,
+               (double) (options->sequences * options->length) / (duration / 1000.0),
+               duration * 1000.0 / (double) options->sequences);
+    }
+
+    for (i = 0; i < options->sequences; i++) {
+        free(sequences[i]);
+    }
+    free(sequences);
+    free(suggestions);
+    t9_pool_destroy(pool);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+int command_stats(const options_t *const options) {
+    t9_model_stats_t model_stats;
+    t9_session_stats_t session_stats;
+    t9_session_t *session;
+    t9_model_t *model;
+    t9_symbol_t key;
+    size_t typed;
+    size_t i;
+
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    if (t9_model_stats(model, &model_stats) != T9_SUCCESS) {
+        fprintf(stderr, "Error: Could not measure the model.\n");
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+    printf("[Stats]: %zu corpus nodes, %zu bytes.\n\n", model_stats.corpus_nodes, model_stats.total_bytes);
+    t9_model_stats_write(&model_stats, stdout);
+
+    session = t9_session_create(model);
+    if (session == NULL) {
+        fprintf(stderr, "Error: Could not create a session.\n");
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    // The live search nodes after every key show how the beam grows and is pruned.
+    printf("\n%-6s %-6s %12s %12s %8s %12s %12s\n", "key", "symbol", "search_nodes", "list_nodes", "paths",
+           "slack_bytes", "total_bytes");
+    typed = 0;
+    for (i = 0; i < model->corpus.test_buffer_size && typed < options->length; i++) {
+        if (t9_corpus_ctol(model->corpus.test_buffer[i], &key) != T9_SUCCESS) {
+            continue;
+        }
+        if (t9_session_insert(session, key, 0.0, NULL) != T9_SUCCESS
+            || t9_session_stats(session, &session_stats) != T9_SUCCESS) {
+            fprintf(stderr, "Error: Decoding failed.\n");
+            break;
+        }
+        typed++;
+        printf("%-6zu %-6c %12zu %12zu %8zu %12zu %12zu\n", typed, (char) model->corpus.test_buffer[i],
+               session_stats.search_nodes, session_stats.list_nodes, session_stats.paths,
+               session_stats.level_table_slack_bytes + session_stats.path_slack_bytes + session_stats.reuse_bytes,
+               session_stats.total_bytes);
+    }
+
+    t9_session_destroy(session);
+    t9_model_destroy(model);
+    return EXIT_SUCCESS;
+}
+
+void cache_report(t9_cache_t *const cache) {
+    t9_cache_stats_t stats;
+    uint64_t lookups;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    t9_cache_stats(cache, &stats);
+    lookups = stats.hits + stats.misses;
+    fprintf(stderr, "[Cache]: %lu hits, %lu misses (%.1f%% hit rate), %lu evictions, %zu entries, %zu of %zu bytes.\n",
+            (unsigned long) stats.hits, (unsigned long) stats.misses,
+            lookups > 0 ? 100.0 * (double) stats.hits / (double) lookups : 0.0, (unsigned long) stats.evictions,
+            stats.number_entries, stats.memory, stats.capacity);
+}
+
+/*!
+ * Stop the server of the serve command on SIGINT and SIGTERM.
+ * @param signal Number of the signal.
+ */
+static void server_stop(int signal) {
+    (void) signal;
+    t9_server_stop(server_instance);
+}
+
+int command_serve(const options_t *const options) {
+    char metrics_path[256];
+    struct sigaction action;
+    struct rlimit limit;
+    t9_model_t *model;
+    int status;
+
+    if (options->socket == NULL) {
+        fprintf(stderr, "Error: serve requires --socket.\n");
+        return EXIT_FAILURE;
+    }
+    if (options->cache > 0 && options->speculate > 0) {
+        fprintf(stderr, "Error: serve can not use --cache and --speculate at once.\n");
+        return EXIT_FAILURE;
+    }
+
+    // The model is built once and shared by all sessions.
+    model = model_prepare(options);
+    if (model == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    // Every connection takes one descriptor, raise the limit of open files to its maximum.
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    server_instance = t9_server_create(model, options->socket, options->threads,
+                                       options->nbest > 0 ? options->nbest : 3, options->words);
+    if (server_instance == NULL) {
+        fprintf(stderr, "Error: Could not listen on \"%s\".\n", options->socket);
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    if ((options->cache > 0 && t9_server_set_cache(server_instance, options->cache) != T9_SUCCESS)
+        || (options->speculate > 0 && t9_server_set_speculation(server_instance, options->speculate) != T9_SUCCESS)) {
+        fprintf(stderr, "Error: Could not create the cache or set up speculation.\n");
+        t9_server_destroy(server_instance);
+        server_instance = NULL;
+        t9_model_destroy(model);
+        return EXIT_FAILURE;
+    }
+
+    // The metrics are served next to the socket, unless another path is given.
+    if (options->metrics != NULL) {
+        snprintf(metrics_path, sizeof(metrics_path), "%s", options->metrics);
+    } else {
+        snprintf(metrics_path, sizeof(metrics_path), "%s.metrics", options->socket);
+    }
+    // A metrics path that was asked for has to work, the default one is optional.
+    if (t9_server_set_metrics(server_instance, metrics_path) != T9_SUCCESS) {
+        if (options->metrics != NULL) {
+            fprintf(stderr, "Error: Could not serve metrics on \"%s\".\n", metrics_path);
+            t9_server_destroy(server_instance);
+            server_instance = NULL;
+            t9_model_destroy(model);
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "Warning: Could not serve metrics on \"%s\", metrics are disabled.\n", metrics_path);
+    }
+
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = server_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("[Server]: Listening on \"%s\" with %u threads.\n", options->socket,
+           (unsigned int) server_instance->pool->number_threads);
+    fflush(stdout);
+    status = EXIT_SUCCESS;
+    if (t9_server_run(server_instance) != T9_SUCCESS) {
+        fprintf(stderr, "Error: The server failed.\n");
+        status = EXIT_FAILURE;
+    }
+    printf("[Server]: Stopped after %lu requests.\n", (unsigned long) server_instance->number_requests);
+    cache_report(server_instance->cache);
+
+    t9_server_destroy(server_instance);
+    server_instance = NULL;
+    t9_model_destroy(model);
+    return status;
 }
 
 /*!
@@ -51,98 +1002,152 @@ void build_corpus_tree(t9_model_t *const model) {
  * Evaluate the given statistical model by generating completing a known symbol sequence and comparing the deviation
  * between the generated sequence and the ground truth sequence.
  * @param model Pointer to the model to be evaluated.
+ * @param number_threads Number of threads to decode with, 0 uses all processors.
  */
-void example_evaluation(t9_model_t *const model) {
-    t9_timer_t timer;
-    double error;
+void example_evaluation(t9_model_t *const model, uint16_t number_threads) {
+    t9_evaluation_t result;
+    t9_pool_t *pool;
 
-// Evaluate model with the test corpus.
+    // Evaluate model with the test corpus.
     printf("[Evaluation]: ...\n");
 
-    t9_timer_start(&timer);
-    if (t9_model_evaluate(model, &error) == T9_FAILURE) {
+    // Decode the test corpus on the requested number of processors.
+    pool = t9_pool_create(number_threads);
+    if (pool == NULL) {
+        printf("[Evaluation]: Error creating the thread pool.\n");
+        return;
+    }
+
+    if (t9_model_evaluate_windows(model, T9_EVALUATION_WINDOW_LENGTH, pool, &result) == T9_FAILURE) {
         printf("[Evaluation]: Error during evaluation.\n");
+        t9_pool_destroy(pool);
         return;
-    };
-    t9_timer_stop(&timer);
+    }
+    t9_pool_destroy(pool);
 
-    printf("[Evaluation]: error %.3f, duration: %.2f ms.\n", error, t9_timer_duration_ms(&timer));
+    printf("[Evaluation]: %zu windows, %zu symbols, %zu words.\n", result.windows, result.symbols, result.words);
+    printf("[Evaluation]: symbol error %.3f, word error %.3f, %.1f keys/s, %.3f ms/key, duration: %.2f ms.\n",
+           result.symbol_error_rate, result.word_error_rate, result.keys_per_second, result.latency_ms,
+           result.duration_ms);
 }
 
 /*!
  * Example:
- * Autocomplete a given input sequence based on the statistical model.
- * @param model Pointer to the model to be used for completion.
+ * Evaluate the given statistical model for all ngram lengths up to the one it was built with and several numbers of
+ * best paths. The corpus tree is only built once.
+ * @param model Pointer to the model to be evaluated.
+ * @param number_threads Number of threads to decode with, 0 uses all processors.
  */
-void example_autocomplete(t9_model_t *const model, const char * text) {
-    t9_timer_t timer;
-    t9_symbol_t *suggestion;
-    const t9_symbol_t * input = (const t9_symbol_t *)text;
+void example_sweep(t9_model_t *const model, uint16_t number_threads) {
+    const uint16_t number_paths[] = {1, 5, 15, 30};
+    t9_sweep_setting_t *settings;
+    t9_pool_t *pool;
+    size_t number_widths;
+    size_t count;
+    size_t i;
+    size_t j;
 
-    // Autocomplete a given input sequence based onm the model.
-    printf("[Completion]: Typing sequence: \"%s\"\n", (const char *) input);
+    // Build the grid of settings to be evaluated.
+    number_widths = sizeof(number_paths) / sizeof(number_paths[0]);
+    count = model->ngram_length * number_widths;
+    settings = (t9_sweep_setting_t *) calloc(count, sizeof(t9_sweep_setting_t));
+    if (settings == NULL) {
+        printf("[Sweep]: Error allocating settings.\n");
+        return;
+    }
+    for (i = 0; i < model->ngram_length; i++) {
+        for (j = 0; j < number_widths; j++) {
+            settings[i * number_widths + j].ngram_length = (uint8_t) (i + 1);
+            settings[i * number_widths + j].number_paths = number_paths[j];
+        }
+    }
 
-    t9_timer_start(&timer);
-    if (t9_model_autocomplete(model, input, &suggestion) == T9_FAILURE) {
-        printf("[Completion]: Error during completion.\n");
+    printf("[Sweep]: ...\n");
+    pool = t9_pool_create(number_threads);
+    if (pool == NULL || t9_model_sweep(model, settings, count, T9_EVALUATION_WINDOW_LENGTH, pool) == T9_FAILURE) {
+        printf("[Sweep]: Error during sweep.\n");
+        t9_pool_destroy(pool);
+        free(settings);
         return;
-    };
-    t9_timer_stop(&timer);
+    }
+    t9_pool_destroy(pool);
 
-    printf("[Completion]: Suggested: \"%s\"\n", suggestion);
-    free(suggestion);
+    printf("| ngram_length | number_paths | symbol error | word error | ms/key | keys/s |\n");
+    printf("|--------------|--------------|--------------|------------|--------|--------|\n");
+    for (i = 0; i < count; i++) {
+        printf("| %12u | %12u | %12.3f | %10.3f | %6.3f | %6.1f |\n",
+               settings[i].ngram_length, settings[i].number_paths,
+               settings[i].result.symbol_error_rate, settings[i].result.word_error_rate,
+               settings[i].result.latency_ms, settings[i].result.keys_per_second);
+    }
+    free(settings);
 }
 
-int main(void) {
-    t9_timer_t timer;
-    t9_model_t *model;
-    const char *train_file;
-    const char *test_file;
-    size_t train_symbols;
-    size_t test_symbols;
+void example_stream_output(const t9_symbol_t *symbols, size_t length, void *arg) {
+    (void) arg;
+    fwrite(symbols, sizeof(t9_symbol_t), length, stdout);
+    fflush(stdout);
+}
 
-    printf("============================================================\n");
-    printf("C-T9 Version: %s | GIT: %s\n", CT9_VERSION, CT9_GIT_DESCRIPTION);
-    printf("============================================================\n");
+void example_stream(t9_model_t *const model) {
+    t9_session_t *session;
+    t9_symbol_t key;
+    size_t i;
+
+    session = t9_session_create(model);
+    if (session == NULL) {
+        printf("[Stream]: Error creating a session.\n");
+        return;
+    }
+    t9_session_set_output(session, example_stream_output, NULL);
 
-    model = t9_model_create();
+    // Type every symbol of the test corpus that can be typed. The decoded text is printed by the output.
+    printf("[Stream]: ");
+    for (i = 0; i < model->corpus.test_buffer_size; i++) {
+        if (t9_corpus_ctol(model->corpus.test_buffer[i], &key) != T9_SUCCESS) {
+            continue;
+        }
+        if (t9_session_insert(session, key, 0.0, NULL) != T9_SUCCESS) {
+            printf("\n[Stream]: Error during decoding.\n");
+            t9_session_destroy(session);
+            return;
+        }
+    }
+    t9_session_flush(session);
+    printf("\n");
 
-    // Load the whole file for model training.
-    train_file = "../data/trump/twitter.txt";
-    train_symbols = 0;
+    t9_session_destroy(session);
+}
 
-    // Use only 1000 symbols for testing.
-    test_file = "../data/trump/twitter.txt";
-    test_symbols = 1000;
+int main(int argc, char **argv) {
+    const char *commands[] = {"train", "eval", "sweep", "stream", "complete", "bench", "stats", "serve"};
+    int (*const handlers[])(const options_t *const) = {
+            command_train, command_eval, command_sweep, command_stream, command_complete, command_bench,
+            command_stats, command_serve
+    };
+    options_t options;
+    size_t i;
+    int status;
 
-    // Load corpus.
-    t9_timer_start(&timer);
-    if (t9_corpus_load(train_file, train_symbols,
-                       test_file, test_symbols,
-                       &model->corpus) != T9_SUCCESS) {
-        printf("Error: Could not load corpus.\n");
+    if (options_parse(argc, argv, &options) == false) {
+        options_usage(argv[0]);
         return EXIT_FAILURE;
     }
-    t9_timer_stop(&timer);
-    printf("[Corpus]: Loaded (%zd bytes) in %.2f ms.\n",
-           model->corpus.train_buffer_size + model->corpus.test_buffer_size,
-           t9_timer_duration_ms(&timer));
-
-    // Populate model with the train corpus.
-    model->ngram_length = 3;
-    // Number best completion paths (completion sequences) to maintain.
-    model->number_paths = 15;
-    // Build the statistical model.
-    build_corpus_tree(model);
-    // Initialize the search tree.
-    model->search_tree = t9_search_tree_create();
 
-    // Example 1: Simple completion of text.
-    example_autocomplete(model, "366253#87867");
+    for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(options.command, commands[i]) == 0) {
+            fprintf(stderr, "C-T9 Version: %s | GIT: %s\n", CT9_VERSION, CT9_GIT_DESCRIPTION);
+            status = handlers[i](&options);
 
-    // Example 2: Evaluation of the statistical model.
-    // example_evaluation(model);
+            // Builds with the meson option instrument report the time spent in every profiling zone.
+#ifdef T9_INSTRUMENT
+            t9_profile_write(stderr);
+#endif
+            return status;
+        }
+    }
 
-    t9_model_destroy(model);
-    return EXIT_SUCCESS;
+    fprintf(stderr, "Error: Unknown command \"%s\".\n", options.command);
+    options_usage(argv[0]);
+    return EXIT_FAILURE;
 }
@@ -0,0 +1,473 @@
+/*!
+  ******************************************************************************
+  * @file    astar.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements A* decoding over the context states of a corpus tree.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/astar.h"
+
+t9_astar_t *
+t9_astar_create(const t9_viterbi_t *const viterbi) {
+    t9_astar_t *astar;
+    double cost;
+    size_t i;
+    size_t k;
+
+    if (viterbi == NULL) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    astar = (t9_astar_t *) malloc(sizeof(t9_astar_t));
+    if (astar == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(astar, 0, sizeof(t9_astar_t));
+    astar->viterbi = viterbi;
+    kv_init(astar->keys);
+    kv_init(astar->prefix);
+    kv_init(astar->nodes);
+    kv_init(astar->heap);
+    kv_init(astar->finals);
+
+    // The cost of a key is at least the one of the cheapest symbol it can produce in any state.
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        astar->bounds[i] = (double) viterbi->emissions[i][0] + viterbi->minimal_costs[0];
+        for (k = 1; k < NUM_CORPUS_SYMBOLS; k++) {
+            cost = (double) viterbi->emissions[i][k] + viterbi->minimal_costs[k];
+            if (cost < astar->bounds[i]) {
+                astar->bounds[i] = cost;
+            }
+        }
+    }
+
+    t9_astar_reset(astar);
+    return astar;
+}
+
+void
+t9_astar_destroy(t9_astar_t *const astar) {
+    if (astar == NULL) {
+        return;
+    }
+
+    kv_destroy(astar->keys);
+    kv_destroy(astar->prefix);
+    kv_destroy(astar->nodes);
+    kv_destroy(astar->heap);
+    kv_destroy(astar->finals);
+    free(astar->slots);
+
+    // Erase and free memory.
+    memset(astar, 0, sizeof(t9_astar_t));
+    free(astar);
+}
+
+t9_astar_t *
+t9_astar_clone(const t9_astar_t *const astar) {
+    t9_astar_t *clone;
+
+    if (astar == NULL) {
+        return NULL;
+    }
+
+    clone = t9_astar_create(astar->viterbi);
+    if (clone == NULL) {
+        return NULL;
+    }
+
+    // The copy continues the same search, so the queue and the slots are copied as well.
+    kv_copy(t9_symbol_t, clone->keys, astar->keys);
+    kv_copy(double, clone->prefix, astar->prefix);
+    kv_copy(t9_astar_node_t, clone->nodes, astar->nodes);
+    kv_copy(t9_astar_item_t, clone->heap, astar->heap);
+    kv_copy(uint32_t, clone->finals, astar->finals);
+    if (astar->number_slots > 0) {
+        clone->slots = (t9_astar_slot_t *) malloc(astar->number_slots * sizeof(t9_astar_slot_t));
+        if (clone->slots == NULL) {
+            t9_astar_destroy(clone);
+            return NULL;
+        }
+        memcpy(clone->slots, astar->slots, astar->number_slots * sizeof(t9_astar_slot_t));
+    }
+    clone->number_slots = astar->number_slots;
+    clone->used_slots = astar->used_slots;
+    clone->expanded = astar->expanded;
+    clone->best = astar->best;
+
+    return clone;
+}
+
+void
+t9_astar_reset(t9_astar_t *const astar) {
+    if (astar == NULL) {
+        return;
+    }
+
+    kv_size(astar->keys) = 0;
+    kv_size(astar->prefix) = 0;
+    kv_size(astar->nodes) = 0;
+    kv_size(astar->heap) = 0;
+    kv_size(astar->finals) = 0;
+    astar->expanded = 0;
+    astar->best = T9_VITERBI_NO_ENTRY;
+}
+
+t9_error_t
+t9_astar_type(t9_astar_t *const astar,
+              const t9_symbol_t *const sequence) {
+    const t9_symbol_t *symbol;
+    const t9_astar_node_t *node;
+    t9_astar_slot_t *slot;
+    t9_astar_item_t item;
+    const char *key;
+    t9_error_t error;
+    size_t i;
+
+    if (astar == NULL || sequence == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Validate that the sequence to be inserted only contains valid lexicon symbols.
+    if (t9_corpus_validate_lexicon_symbols(sequence) == false) {
+        return T9_FAILURE;
+    }
+
+    // Keys are stored as their index in the lexicon.
+    for (symbol = sequence; *symbol != 0; symbol++) {
+        key = strchr(LEXICON_SYMBOLS, *symbol);
+        kv_push(t9_symbol_t, astar->keys, (t9_symbol_t) (key - LEXICON_SYMBOLS));
+    }
+
+    // The complete hypotheses of the previous keys are continued, their states are open again.
+    for (i = 0; i < kv_size(astar->finals); i++) {
+        node = &kv_A(astar->nodes, kv_A(astar->finals, i));
+        slot = __t9_astar_slot(astar, (uint64_t) node->position * astar->viterbi->number_states + node->state + 1);
+        if (slot == NULL) {
+            return T9_FAILURE;
+        }
+        slot->closed = false;
+        item.priority = node->probability - kv_A(astar->prefix, node->position);
+        item.node = kv_A(astar->finals, i);
+        __t9_astar_heap_push(astar, item);
+    }
+    kv_size(astar->finals) = 0;
+
+    T9_PROFILE_BEGIN("astar_search");
+    error = __t9_astar_search(astar, 1);
+    T9_PROFILE_END();
+
+    return error;
+}
+
+t9_error_t
+t9_astar_suggestion(const t9_astar_t *const astar,
+                    t9_symbol_t **suggestion) {
+    uint32_t node;
+    size_t i;
+
+    if (astar == NULL || suggestion == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Nothing was typed yet.
+    if (astar->best == T9_VITERBI_NO_ENTRY || kv_size(astar->keys) == 0) {
+        return T9_FAILURE;
+    }
+
+    *suggestion = (t9_symbol_t *) malloc(kv_size(astar->keys) + 1);
+    if (*suggestion == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Follow the best hypothesis back to the start node, which does not carry a symbol.
+    (*suggestion)[kv_size(astar->keys)] = 0;
+    node = astar->best;
+    for (i = kv_size(astar->keys); i > 0; i--) {
+        (*suggestion)[i - 1] = kv_A(astar->nodes, node).symbol;
+        node = kv_A(astar->nodes, node).previous;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_astar_nbest(t9_astar_t *const astar,
+               t9_symbol_t *const suggestions,
+               size_t stride,
+               float *const scores,
+               size_t capacity,
+               size_t *const count) {
+    t9_symbol_t *suggestion;
+    uint32_t node;
+    size_t length;
+    size_t i;
+    size_t j;
+
+    if (astar == NULL || suggestions == NULL || scores == NULL || count == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Nothing was typed yet.
+    length = kv_size(astar->keys);
+    if (astar->best == T9_VITERBI_NO_ENTRY || length == 0 || stride < length + 1) {
+        return T9_FAILURE;
+    }
+
+    *count = 0;
+    if (capacity == 0) {
+        return T9_SUCCESS;
+    }
+
+    // Further complete hypotheses are found by continuing the search.
+    if (kv_size(astar->finals) < capacity && __t9_astar_search(astar, capacity) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    // Follow every hypothesis back to the start node, which does not carry a symbol.
+    for (j = 0; j < kv_size(astar->finals) && j < capacity; j++) {
+        suggestion = &suggestions[j * stride];
+        suggestion[length] = 0;
+        node = kv_A(astar->finals, j);
+        scores[j] = kv_A(astar->nodes, node).probability;
+        for (i = length; i > 0; i--) {
+            suggestion[i - 1] = kv_A(astar->nodes, node).symbol;
+            node = kv_A(astar->nodes, node).previous;
+        }
+    }
+    *count = j;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_astar_search(t9_astar_t *const astar,
+                  size_t number_finals) {
+    const t9_viterbi_t *viterbi;
+    const float *emissions;
+    t9_astar_node_t node;
+    t9_astar_node_t child;
+    t9_astar_item_t item;
+    t9_astar_slot_t *slot;
+    size_t length;
+    size_t row;
+    size_t i;
+    size_t k;
+    uint32_t current;
+    uint32_t next;
+    float probability;
+
+    viterbi = astar->viterbi;
+    length = kv_size(astar->keys);
+
+    // Lower bound of the cost of all keys up to a position, extended by the keys typed since the last search. The
+    // bound is relaxed slightly, so rounding of the scores never lets it overestimate.
+    if (kv_size(astar->prefix) == 0) {
+        kv_push(double, astar->prefix, 0.0);
+    }
+    for (i = kv_size(astar->prefix); i <= length; i++) {
+        kv_push(double, astar->prefix,
+                kv_A(astar->prefix, i - 1) + astar->bounds[kv_A(astar->keys, i - 1)] * (1.0 - 1e-6));
+    }
+
+    // Start a new search, unless there is one to be continued.
+    if (kv_size(astar->heap) == 0 && kv_size(astar->finals) == 0) {
+        kv_size(astar->nodes) = 0;
+        if (astar->slots != NULL) {
+            memset(astar->slots, 0, astar->number_slots * sizeof(t9_astar_slot_t));
+        }
+        astar->used_slots = 0;
+        astar->expanded = 0;
+
+        memset(&node, 0, sizeof(t9_astar_node_t));
+        node.previous = T9_VITERBI_NO_ENTRY;
+        kv_push(t9_astar_node_t, astar->nodes, node);
+        item.priority = 0.0;
+        item.node = 0;
+        __t9_astar_heap_push(astar, item);
+    }
+
+    while (kv_size(astar->finals) < number_finals && kv_size(astar->heap) > 0) {
+        __t9_astar_heap_pop(astar, &item);
+        current = item.node;
+        node = kv_A(astar->nodes, current);
+
+        // A state is only expanded once per position, by its best hypothesis.
+        slot = __t9_astar_slot(astar, (uint64_t) node.position * viterbi->number_states + node.state + 1);
+        if (slot == NULL) {
+            return T9_FAILURE;
+        }
+        if (slot->closed == true) {
+            continue;
+        }
+        slot->closed = true;
+
+        // Complete hypotheses are taken in the order of their scores, the first one is the best one.
+        if (node.position == length) {
+            kv_push(uint32_t, astar->finals, current);
+            continue;
+        }
+        astar->expanded++;
+
+        emissions = viterbi->emissions[kv_A(astar->keys, node.position)];
+        row = node.state * NUM_CORPUS_SYMBOLS;
+        for (k = 0; k < NUM_CORPUS_SYMBOLS; k++) {
+            next = viterbi->transitions[row + k];
+            probability = emissions[k] + viterbi->costs[row + k] + node.probability;
+
+            // Skip hypotheses that are not better than a known one of the same state.
+            slot = __t9_astar_slot(astar, (uint64_t) (node.position + 1) * viterbi->number_states + next + 1);
+            if (slot == NULL) {
+                return T9_FAILURE;
+            }
+            if (slot->closed == true || slot->probability <= probability) {
+                continue;
+            }
+            slot->probability = probability;
+
+            child.state = next;
+            child.previous = current;
+            child.position = node.position + 1;
+            child.probability = probability;
+            child.symbol = viterbi->symbols[k];
+            kv_push(t9_astar_node_t, astar->nodes, child);
+
+            item.priority = probability - kv_A(astar->prefix, child.position);
+            item.node = (uint32_t) (kv_size(astar->nodes) - 1);
+            __t9_astar_heap_push(astar, item);
+        }
+    }
+
+    if (kv_size(astar->finals) == 0) {
+        astar->best = T9_VITERBI_NO_ENTRY;
+        return T9_FAILURE;
+    }
+
+    astar->best = kv_A(astar->finals, 0);
+    return T9_SUCCESS;
+}
+
+t9_astar_slot_t *
+__t9_astar_slot(t9_astar_t *const astar,
+                uint64_t key) {
+    t9_astar_slot_t *slots;
+    size_t number_slots;
+    size_t index;
+    size_t i;
+
+    // Keep the table at most half full.
+    if (2 * (astar->used_slots + 1) > astar->number_slots) {
+        slots = astar->slots;
+        number_slots = astar->number_slots;
+        astar->number_slots = number_slots > 0 ? 2 * number_slots : 1024;
+        astar->slots = (t9_astar_slot_t *) calloc(astar->number_slots, sizeof(t9_astar_slot_t));
+        if (astar->slots == NULL) {
+            astar->slots = slots;
+            astar->number_slots = number_slots;
+            return NULL;
+        }
+        // Move all used slots to the new table.
+        for (i = 0; i < number_slots; i++) {
+            if (slots[i].key != 0) {
+                index = (size_t) (slots[i].key * 0x9E3779B97F4A7C15ULL) & (astar->number_slots - 1);
+                while (astar->slots[index].key != 0) {
+                    index = (index + 1) & (astar->number_slots - 1);
+                }
+                astar->slots[index] = slots[i];
+            }
+        }
+        free(slots);
+    }
+
+    index = (size_t) (key * 0x9E3779B97F4A7C15ULL) & (astar->number_slots - 1);
+    while (astar->slots[index].key != 0 && astar->slots[index].key != key) {
+        index = (index + 1) & (astar->number_slots - 1);
+    }
+
+    // A state seen for the first time has no score yet.
+    if (astar->slots[index].key == 0) {
+        astar->slots[index].key = key;
+        astar->slots[index].probability = FLT_MAX;
+        astar->slots[index].closed = false;
+        astar->used_slots++;
+    }
+
+    return &astar->slots[index];
+}
+
+void
+__t9_astar_heap_push(t9_astar_t *const astar,
+                     t9_astar_item_t item) {
+    t9_astar_item_t tmp;
+    size_t i;
+
+    kv_push(t9_astar_item_t, astar->heap, item);
+
+    // Move the item up until its parent has a lower priority.
+    i = kv_size(astar->heap) - 1;
+    while (i > 0 && kv_A(astar->heap, (i - 1) / 2).priority > kv_A(astar->heap, i).priority) {
+        tmp = kv_A(astar->heap, (i - 1) / 2);
+        kv_A(astar->heap, (i - 1) / 2) = kv_A(astar->heap, i);
+        kv_A(astar->heap, i) = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+void
+__t9_astar_heap_pop(t9_astar_t *const astar,
+                    t9_astar_item_t *const item) {
+    t9_astar_item_t tmp;
+    size_t size;
+    size_t child;
+    size_t i;
+
+    *item = kv_A(astar->heap, 0);
+    kv_A(astar->heap, 0) = kv_pop(astar->heap);
+
+    // Move the new first item down until both children have a higher priority.
+    size = kv_size(astar->heap);
+    i = 0;
+    while (2 * i + 1 < size) {
+        child = 2 * i + 1;
+        if (child + 1 < size && kv_A(astar->heap, child + 1).priority < kv_A(astar->heap, child).priority) {
+            child++;
+        }
+        if (kv_A(astar->heap, i).priority <= kv_A(astar->heap, child).priority) {
+            break;
+        }
+        tmp = kv_A(astar->heap, i);
+        kv_A(astar->heap, i) = kv_A(astar->heap, child);
+        kv_A(astar->heap, child) = tmp;
+        i = child;
+    }
+}
@@ -0,0 +1,408 @@
+/*!
+  ******************************************************************************
+  * @file    cache.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements a LRU cache from key sequences to decoder states.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/cache.h"
+
+t9_cache_t *
+t9_cache_create(size_t capacity) {
+    t9_cache_t *cache;
+
+    // Allocate memory.
+    cache = (t9_cache_t *) malloc(sizeof(t9_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(cache, 0, sizeof(t9_cache_t));
+    cache->capacity = capacity;
+
+    cache->number_buckets = T9_CACHE_BUCKETS;
+    cache->buckets = (t9_cache_entry_t **) calloc(cache->number_buckets, sizeof(t9_cache_entry_t *));
+    if (cache->buckets == NULL) {
+        free(cache);
+        return NULL;
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+
+    return cache;
+}
+
+void
+t9_cache_destroy(t9_cache_t *const cache) {
+    if (cache == NULL) {
+        return;
+    }
+
+    // Destroy all entries.
+    while (cache->oldest != NULL) {
+        __t9_cache_remove(cache, cache->oldest);
+    }
+
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+
+    // Erase and free memory.
+    memset(cache, 0, sizeof(t9_cache_t));
+    free(cache);
+}
+
+t9_error_t
+t9_cache_store(t9_cache_t *const cache,
+               const t9_symbol_t *const sequence,
+               const t9_session_t *const session) {
+    t9_cache_entry_t *entry;
+    t9_cache_entry_t *existing;
+    size_t bucket;
+    size_t i;
+
+    if (cache == NULL || sequence == NULL || session == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Allocate memory.
+    entry = (t9_cache_entry_t *) malloc(sizeof(t9_cache_entry_t));
+    if (entry == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Erase memory.
+    memset(entry, 0, sizeof(t9_cache_entry_t));
+
+    // The session is serialized before the cache is locked.
+    if (t9_session_serialize(session, &entry->state, &entry->size) != T9_SUCCESS) {
+        free(entry);
+        return T9_FAILURE;
+    }
+
+    entry->length = strlen((const char *) sequence);
+    entry->keys = (t9_symbol_t *) malloc(entry->length + 1);
+    if (entry->keys == NULL) {
+        free(entry->state);
+        free(entry);
+        return T9_FAILURE;
+    }
+    memcpy(entry->keys, sequence, entry->length + 1);
+
+    entry->hash = T9_CACHE_HASH_OFFSET;
+    for (i = 0; i < entry->length; i++) {
+        entry->hash = __t9_cache_hash(entry->hash, sequence[i]);
+    }
+
+    // Entries that would evict the whole cache are not worth storing.
+    if (sizeof(t9_cache_entry_t) + entry->length + 1 + entry->size > cache->capacity) {
+        free(entry->keys);
+        free(entry->state);
+        free(entry);
+        return T9_SUCCESS;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    // Replace an existing entry of the sequence.
+    existing = __t9_cache_find(cache, entry->keys, entry->length, entry->hash);
+    if (existing != NULL) {
+        __t9_cache_remove(cache, existing);
+    }
+
+    if (cache->number_entries >= cache->number_buckets) {
+        __t9_cache_grow(cache);
+    }
+
+    // Insert the entry as the most recently used one.
+    bucket = entry->hash % cache->number_buckets;
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    entry->older = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    }
+    cache->newest = entry;
+    if (cache->oldest == NULL) {
+        cache->oldest = entry;
+    }
+    cache->number_entries++;
+    cache->memory += sizeof(t9_cache_entry_t) + entry->length + 1 + entry->size;
+
+    // Evict the least recently used entries, until the cache fits its capacity.
+    while (cache->memory > cache->capacity && cache->oldest != entry) {
+        __t9_cache_remove(cache, cache->oldest);
+        cache->evictions++;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_cache_restore(t9_cache_t *const cache,
+                 t9_session_t *const session,
+                 const t9_symbol_t *const sequence,
+                 size_t typed,
+                 size_t *const restored) {
+    t9_cache_entry_t *entry;
+    uint64_t *hashes;
+    uint8_t *state;
+    size_t length;
+    size_t size;
+    size_t i;
+    t9_error_t error;
+
+    if (cache == NULL || session == NULL || sequence == NULL || restored == NULL) {
+        return T9_FAILURE;
+    }
+
+    *restored = typed;
+    length = strlen((const char *) sequence);
+    if (typed > length) {
+        return T9_FAILURE;
+    }
+
+    // The session holds the whole sequence already.
+    if (typed == length) {
+        return typed == 0 ? t9_session_reset(session) : T9_SUCCESS;
+    }
+
+    // Hash all prefixes of the sequence at once.
+    hashes = (uint64_t *) malloc((length + 1) * sizeof(uint64_t));
+    if (hashes == NULL) {
+        return T9_FAILURE;
+    }
+    hashes[0] = T9_CACHE_HASH_OFFSET;
+    for (i = 0; i < length; i++) {
+        hashes[i + 1] = __t9_cache_hash(hashes[i], sequence[i]);
+    }
+
+    // Look for the longest cached prefix and copy its state, as the entry may be evicted once the cache is unlocked.
+    // Prefixes the session typed already are not worth restoring.
+    state = NULL;
+    size = 0;
+    pthread_mutex_lock(&cache->lock);
+    for (i = length; i > typed && state == NULL; i--) {
+        entry = __t9_cache_find(cache, sequence, i, hashes[i]);
+        if (entry != NULL) {
+            state = (uint8_t *) malloc(entry->size);
+            if (state != NULL) {
+                memcpy(state, entry->state, entry->size);
+                size = entry->size;
+                *restored = i;
+                __t9_cache_touch(cache, entry);
+            }
+        }
+    }
+    if (state != NULL) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    free(hashes);
+
+    // The metrics shard belongs to the thread of the session, so it is updated without the lock.
+    if (session->metrics != NULL) {
+        t9_metrics_add(session->metrics, state != NULL ? T9_METRICS_CACHE_HITS : T9_METRICS_CACHE_MISSES, 1);
+    }
+
+    if (state == NULL) {
+        return typed == 0 ? t9_session_reset(session) : T9_SUCCESS;
+    }
+
+    // A session that could not be restored is reset.
+    error = t9_session_deserialize(session, state, size);
+    if (error != T9_SUCCESS) {
+        *restored = 0;
+    }
+    free(state);
+
+    return error;
+}
+
+t9_error_t
+t9_cache_type(t9_cache_t *const cache,
+              t9_session_t *const session,
+              const t9_symbol_t *const sequence,
+              size_t typed) {
+    const t9_symbol_t *symbol;
+    size_t restored;
+
+    if (cache == NULL || session == NULL || sequence == NULL || session->output != NULL) {
+        return T9_FAILURE;
+    }
+
+    // Validate that the sequence only contains valid lexicon symbols.
+    if (t9_corpus_validate_lexicon_symbols(sequence) == false) {
+        return T9_FAILURE;
+    }
+
+    if (t9_cache_restore(cache, session, sequence, typed, &restored) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    // Only the keys after the cached prefix are decoded.
+    for (symbol = sequence + restored; *symbol != 0; symbol++) {
+        if (t9_session_insert(session, *symbol, 0.0, NULL) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+
+    if (*(sequence + restored) == 0) {
+        return T9_SUCCESS;
+    }
+
+    return t9_cache_store(cache, sequence, session);
+}
+
+void
+t9_cache_stats(t9_cache_t *const cache,
+               t9_cache_stats_t *const stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->number_entries = cache->number_entries;
+    stats->memory = cache->memory;
+    stats->capacity = cache->capacity;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+t9_cache_entry_t *
+__t9_cache_find(const t9_cache_t *const cache,
+                const t9_symbol_t *const keys,
+                size_t length,
+                uint64_t hash) {
+    t9_cache_entry_t *entry;
+
+    for (entry = cache->buckets[hash % cache->number_buckets]; entry != NULL; entry = entry->chain) {
+        if (entry->hash == hash && entry->length == length && memcmp(entry->keys, keys, length) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+void
+__t9_cache_touch(t9_cache_t *const cache,
+                 t9_cache_entry_t *const entry) {
+    if (cache->newest == entry) {
+        return;
+    }
+
+    // Unlink the entry from its position.
+    entry->newer->older = entry->older;
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+
+    // Link it as the newest entry.
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    cache->newest->newer = entry;
+    cache->newest = entry;
+}
+
+void
+__t9_cache_remove(t9_cache_t *const cache,
+                  t9_cache_entry_t *const entry) {
+    t9_cache_entry_t **link;
+
+    // Unlink the entry from its bucket.
+    link = &cache->buckets[entry->hash % cache->number_buckets];
+    while (*link != entry) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+
+    // Unlink the entry from the order of use.
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+
+    cache->number_entries--;
+    cache->memory -= sizeof(t9_cache_entry_t) + entry->length + 1 + entry->size;
+
+    // Erase and free memory.
+    free(entry->keys);
+    free(entry->state);
+    memset(entry, 0, sizeof(t9_cache_entry_t));
+    free(entry);
+}
+
+t9_error_t
+__t9_cache_grow(t9_cache_t *const cache) {
+    t9_cache_entry_t **buckets;
+    t9_cache_entry_t *entry;
+    size_t number_buckets;
+    size_t bucket;
+
+    number_buckets = cache->number_buckets * 2;
+    buckets = (t9_cache_entry_t **) calloc(number_buckets, sizeof(t9_cache_entry_t *));
+    if (buckets == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Rehash all entries.
+    for (entry = cache->newest; entry != NULL; entry = entry->older) {
+        bucket = entry->hash % number_buckets;
+        entry->chain = buckets[bucket];
+        buckets[bucket] = entry;
+    }
+
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->number_buckets = number_buckets;
+
+    return T9_SUCCESS;
+}
+
+uint64_t
+__t9_cache_hash(uint64_t hash,
+                t9_symbol_t key) {
+    return (hash ^ key) * T9_CACHE_HASH_PRIME;
+}
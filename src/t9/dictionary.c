@@ -0,0 +1,694 @@
+/*!
+  ******************************************************************************
+  * @file    dictionary.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements a word level T9 dictionary.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/dictionary.h"
+
+t9_dictionary_t *
+t9_dictionary_create(uint16_t number_words) {
+    t9_dictionary_t *dictionary;
+
+    if (number_words == 0) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    dictionary = (t9_dictionary_t *) malloc(sizeof(t9_dictionary_t));
+    if (dictionary == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(dictionary, 0, sizeof(t9_dictionary_t));
+    dictionary->number_words = number_words;
+
+    dictionary->root = __t9_dictionary_node_create();
+    if (dictionary->root == NULL) {
+        free(dictionary);
+        return NULL;
+    }
+    dictionary->number_nodes = 1;
+
+    return dictionary;
+}
+
+void
+t9_dictionary_destroy(t9_dictionary_t *const dictionary) {
+    if (dictionary == NULL) {
+        return;
+    }
+
+    __t9_dictionary_node_destroy(dictionary->root);
+
+    // Erase and free memory.
+    memset(dictionary, 0, sizeof(t9_dictionary_t));
+    free(dictionary);
+}
+
+t9_error_t
+t9_dictionary_insert_word(t9_dictionary_t *const dictionary,
+                          const t9_symbol_t *const word,
+                          size_t length,
+                          uint64_t count) {
+    t9_dictionary_node_t *node;
+    size_t index;
+
+    return __t9_dictionary_insert(dictionary, word, length, count, &node, &index);
+}
+
+t9_error_t
+t9_dictionary_insert_corpus(t9_dictionary_t *const dictionary,
+                            const corpus_t *const corpus) {
+    t9_dictionary_node_t *previous;
+    t9_dictionary_node_t *node;
+    size_t previous_index;
+    size_t index;
+    size_t next;
+    size_t begin;
+    size_t end;
+
+    if (dictionary == NULL || corpus == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Words are the runs of word symbols.
+    previous = NULL;
+    previous_index = 0;
+    begin = 0;
+    while (begin < corpus->train_buffer_size) {
+        if (__t9_dictionary_key(corpus->train_buffer[begin]) == NUM_LEXICON_SYMBOLS) {
+            // Only words separated by spaces follow each other.
+            if (corpus->train_buffer[begin] != ' ') {
+                previous = NULL;
+            }
+            begin++;
+            continue;
+        }
+        end = begin;
+        while (end < corpus->train_buffer_size && __t9_dictionary_key(corpus->train_buffer[end]) != NUM_LEXICON_SYMBOLS) {
+            end++;
+        }
+        // The previous word is counted first, inserting the word may move the previous one within its node.
+        if (previous != NULL) {
+            if (__t9_dictionary_count(&kv_A(previous->words, previous_index).next,
+                                      &corpus->train_buffer[begin], end - begin, 1, &next) != T9_SUCCESS) {
+                return T9_FAILURE;
+            }
+        }
+        if (__t9_dictionary_insert(dictionary, &corpus->train_buffer[begin], end - begin, 1, &node, &index)
+            != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+        previous = node;
+        previous_index = index;
+        begin = end;
+    }
+
+    return T9_SUCCESS;
+}
+
+void
+t9_dictionary_finalize(t9_dictionary_t *const dictionary) {
+    if (dictionary == NULL) {
+        return;
+    }
+
+    __t9_dictionary_node_finalize(dictionary->root, dictionary->number_words);
+}
+
+const t9_dictionary_node_t *
+t9_dictionary_lookup(const t9_dictionary_t *const dictionary,
+                     const t9_symbol_t *const sequence) {
+    const t9_dictionary_node_t *node;
+    const char *key;
+    const t9_symbol_t *symbol;
+
+    if (dictionary == NULL || sequence == NULL) {
+        return NULL;
+    }
+
+    node = dictionary->root;
+    for (symbol = sequence; *symbol != 0 && node != NULL; symbol++) {
+        key = strchr(LEXICON_SYMBOLS, *symbol);
+        if (key == NULL) {
+            return NULL;
+        }
+        node = node->children[key - LEXICON_SYMBOLS];
+    }
+
+    return node;
+}
+
+t9_error_t
+t9_dictionary_words(const t9_dictionary_t *const dictionary,
+                    const t9_symbol_t *const sequence,
+                    const t9_dictionary_word_t **words,
+                    size_t *const count) {
+    const t9_dictionary_node_t *node;
+
+    if (dictionary == NULL || sequence == NULL || words == NULL || count == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (t9_corpus_validate_lexicon_symbols(sequence) == false) {
+        return T9_FAILURE;
+    }
+
+    node = t9_dictionary_lookup(dictionary, sequence);
+    *words = node != NULL ? node->words.a : NULL;
+    *count = node != NULL ? kv_size(node->words) : 0;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_dictionary_complete(const t9_dictionary_t *const dictionary,
+                       const t9_symbol_t *const sequence,
+                       const t9_dictionary_word_t *const **completions,
+                       size_t *const count) {
+    const t9_dictionary_node_t *node;
+
+    if (dictionary == NULL || sequence == NULL || completions == NULL || count == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (t9_corpus_validate_lexicon_symbols(sequence) == false) {
+        return T9_FAILURE;
+    }
+
+    node = t9_dictionary_lookup(dictionary, sequence);
+    *completions = node != NULL ? (const t9_dictionary_word_t *const *) node->completions.a : NULL;
+    *count = node != NULL ? kv_size(node->completions) : 0;
+
+    return T9_SUCCESS;
+}
+
+const t9_dictionary_word_t *
+t9_dictionary_find(const t9_dictionary_t *const dictionary,
+                   const t9_symbol_t *const word) {
+    const t9_dictionary_node_t *node;
+    const t9_symbol_t *symbol;
+    size_t key;
+    size_t i;
+
+    if (dictionary == NULL || word == NULL) {
+        return NULL;
+    }
+
+    node = dictionary->root;
+    for (symbol = word; *symbol != 0 && node != NULL; symbol++) {
+        key = __t9_dictionary_key(*symbol);
+        if (key == NUM_LEXICON_SYMBOLS) {
+            return NULL;
+        }
+        node = node->children[key];
+    }
+    if (node == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < kv_size(node->words); i++) {
+        if (strcmp((const char *) kv_A(node->words, i).word, (const char *) word) == 0) {
+            return &kv_A(node->words, i);
+        }
+    }
+
+    return NULL;
+}
+
+const t9_symbol_t *
+t9_dictionary_last_word(const t9_symbol_t *const sequence) {
+    const t9_symbol_t *word;
+    const t9_symbol_t *symbol;
+
+    if (sequence == NULL) {
+        return NULL;
+    }
+
+    word = sequence;
+    for (symbol = sequence; *symbol != 0; symbol++) {
+        if (strchr(T9_DICTIONARY_SEPARATORS, *symbol) != NULL) {
+            word = symbol + 1;
+        }
+    }
+
+    return word;
+}
+
+t9_error_t
+t9_dictionary_write(const t9_dictionary_t *const dictionary,
+                    FILE *const fp) {
+    t9_dictionary_header_t header;
+
+    if (dictionary == NULL || fp == NULL) {
+        return T9_FAILURE;
+    }
+
+    memset(&header, 0, sizeof(t9_dictionary_header_t));
+    header.number_occurrences = dictionary->number_occurrences;
+    header.number_words = dictionary->number_words;
+    __t9_dictionary_node_measure(dictionary->root, &header);
+
+    if (fwrite(&header, sizeof(t9_dictionary_header_t), 1, fp) != 1
+        || __t9_dictionary_node_write(dictionary->root, fp) == false) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_dictionary_read(FILE *const fp,
+                   t9_dictionary_t **dictionary) {
+    t9_dictionary_header_t header;
+    t9_dictionary_record_t record;
+    t9_dictionary_record_t next_record;
+    t9_dictionary_t *result;
+    t9_dictionary_node_t *node;
+    t9_symbol_t *symbols;
+    size_t index;
+    size_t next;
+    uint64_t i;
+    uint32_t j;
+    bool valid;
+
+    if (fp == NULL || dictionary == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (fread(&header, sizeof(t9_dictionary_header_t), 1, fp) != 1) {
+        return T9_FAILURE;
+    }
+
+    result = t9_dictionary_create(header.number_words);
+    symbols = (t9_symbol_t *) malloc((size_t) header.max_length + 1);
+    valid = result != NULL && symbols != NULL;
+
+    // Count every word and the words following it, as they were counted before finalizing.
+    for (i = 0; valid == true && i < header.number_entries; i++) {
+        valid = __t9_dictionary_read_word(fp, header.max_length, &record, symbols) == true
+                && record.number_next <= header.number_words
+                && __t9_dictionary_insert(result, symbols, record.length, record.count, &node, &index) == T9_SUCCESS;
+        for (j = 0; valid == true && j < record.number_next; j++) {
+            valid = __t9_dictionary_read_word(fp, header.max_length, &next_record, symbols) == true
+                    && next_record.number_next == 0
+                    && __t9_dictionary_count(&kv_A(node->words, index).next, symbols, next_record.length,
+                                             next_record.count, &next) == T9_SUCCESS;
+        }
+    }
+    free(symbols);
+
+    if (valid == false) {
+        t9_dictionary_destroy(result);
+        return T9_FAILURE;
+    }
+
+    result->number_occurrences = header.number_occurrences;
+    t9_dictionary_finalize(result);
+
+    *dictionary = result;
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_dictionary_insert(t9_dictionary_t *const dictionary,
+                       const t9_symbol_t *const word,
+                       size_t length,
+                       uint64_t count,
+                       t9_dictionary_node_t **node,
+                       size_t *const index) {
+    t9_dictionary_node_t *current;
+    size_t key;
+    size_t i;
+
+    if (dictionary == NULL || word == NULL || length == 0 || node == NULL || index == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Descend along the keys of the word, missing nodes are added.
+    current = dictionary->root;
+    for (i = 0; i < length; i++) {
+        key = __t9_dictionary_key(word[i]);
+        if (key == NUM_LEXICON_SYMBOLS) {
+            return T9_FAILURE;
+        }
+        if (current->children[key] == NULL) {
+            current->children[key] = __t9_dictionary_node_create();
+            if (current->children[key] == NULL) {
+                return T9_FAILURE;
+            }
+            dictionary->number_nodes++;
+        }
+        current = current->children[key];
+    }
+
+    if (__t9_dictionary_count(&current->words, word, length, count, index) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+    dictionary->number_occurrences += count;
+    *node = current;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_dictionary_count(t9_dictionary_word_vector_t *const words,
+                      const t9_symbol_t *const word,
+                      size_t length,
+                      uint64_t count,
+                      size_t *const index) {
+    t9_dictionary_word_t entry;
+    size_t lower;
+    size_t upper;
+    size_t middle;
+    int order;
+
+    // Binary search the word, the words are sorted by their symbols.
+    lower = 0;
+    upper = kv_size(*words);
+    while (lower < upper) {
+        middle = lower + (upper - lower) / 2;
+        order = __t9_dictionary_compare_symbols(kv_A(*words, middle).word, word, length);
+        if (order == 0) {
+            // Count the known word.
+            kv_A(*words, middle).count += count;
+            *index = middle;
+            return T9_SUCCESS;
+        }
+        if (order < 0) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+
+    // Add a new word at its position.
+    memset(&entry, 0, sizeof(t9_dictionary_word_t));
+    entry.word = (t9_symbol_t *) malloc(length + 1);
+    if (entry.word == NULL) {
+        return T9_FAILURE;
+    }
+    memcpy(entry.word, word, length);
+    entry.word[length] = 0;
+    entry.count = count;
+    kv_init(entry.next);
+    kv_push(t9_dictionary_word_t, *words, entry);
+    memmove(&kv_A(*words, lower + 1), &kv_A(*words, lower),
+            (kv_size(*words) - lower - 1) * sizeof(t9_dictionary_word_t));
+    kv_A(*words, lower) = entry;
+    *index = lower;
+
+    return T9_SUCCESS;
+}
+
+int
+__t9_dictionary_compare_symbols(const t9_symbol_t *const word,
+                                const t9_symbol_t *const symbols,
+                                size_t length) {
+    size_t i;
+
+    // A zero terminated word that ends early is smaller, its terminator is smaller than any symbol.
+    for (i = 0; i < length; i++) {
+        if (word[i] != symbols[i]) {
+            return word[i] < symbols[i] ? -1 : 1;
+        }
+    }
+
+    return word[length] == 0 ? 0 : 1;
+}
+
+void
+__t9_dictionary_truncate(t9_dictionary_word_vector_t *const words,
+                         uint16_t number_words) {
+    t9_dictionary_word_vector_t rest;
+
+    qsort(words->a, kv_size(*words), sizeof(t9_dictionary_word_t), __t9_dictionary_compare_words);
+    if (kv_size(*words) <= number_words) {
+        return;
+    }
+
+    rest.a = &kv_A(*words, number_words);
+    rest.n = kv_size(*words) - number_words;
+    rest.m = rest.n;
+    __t9_dictionary_free_words(&rest);
+    kv_size(*words) = number_words;
+}
+
+void
+__t9_dictionary_free_words(t9_dictionary_word_vector_t *const words) {
+    size_t i;
+
+    for (i = 0; i < kv_size(*words); i++) {
+        free(kv_A(*words, i).word);
+        __t9_dictionary_free_words(&kv_A(*words, i).next);
+        kv_destroy(kv_A(*words, i).next);
+    }
+}
+
+void
+__t9_dictionary_node_measure(const t9_dictionary_node_t *const node,
+                             t9_dictionary_header_t *const header) {
+    const t9_dictionary_word_t *word;
+    size_t length;
+    size_t i;
+    size_t j;
+
+    if (node == NULL) {
+        return;
+    }
+
+    for (i = 0; i < kv_size(node->words); i++) {
+        word = &kv_A(node->words, i);
+        header->number_entries++;
+        length = strlen((const char *) word->word);
+        if (length > header->max_length) {
+            header->max_length = (uint32_t) length;
+        }
+        for (j = 0; j < kv_size(word->next); j++) {
+            length = strlen((const char *) kv_A(word->next, j).word);
+            if (length > header->max_length) {
+                header->max_length = (uint32_t) length;
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        __t9_dictionary_node_measure(node->children[i], header);
+    }
+}
+
+bool
+__t9_dictionary_node_write(const t9_dictionary_node_t *const node,
+                           FILE *const fp) {
+    const t9_dictionary_word_t *word;
+    size_t i;
+    size_t j;
+
+    if (node == NULL) {
+        return true;
+    }
+
+    for (i = 0; i < kv_size(node->words); i++) {
+        word = &kv_A(node->words, i);
+        if (__t9_dictionary_write_word(word, kv_size(word->next), fp) == false) {
+            return false;
+        }
+        for (j = 0; j < kv_size(word->next); j++) {
+            if (__t9_dictionary_write_word(&kv_A(word->next, j), 0, fp) == false) {
+                return false;
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        if (__t9_dictionary_node_write(node->children[i], fp) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+__t9_dictionary_write_word(const t9_dictionary_word_t *const word,
+                           size_t number_next,
+                           FILE *const fp) {
+    t9_dictionary_record_t record;
+
+    memset(&record, 0, sizeof(t9_dictionary_record_t));
+    record.count = word->count;
+    record.length = (uint32_t) strlen((const char *) word->word);
+    record.number_next = (uint32_t) number_next;
+
+    return fwrite(&record, sizeof(t9_dictionary_record_t), 1, fp) == 1
+           && fwrite(word->word, sizeof(t9_symbol_t), record.length, fp) == record.length;
+}
+
+bool
+__t9_dictionary_read_word(FILE *const fp,
+                          uint32_t max_length,
+                          t9_dictionary_record_t *const record,
+                          t9_symbol_t *const symbols) {
+    uint32_t i;
+
+    if (fread(record, sizeof(t9_dictionary_record_t), 1, fp) != 1
+        || record->length == 0 || record->length > max_length
+        || fread(symbols, sizeof(t9_symbol_t), record->length, fp) != record->length) {
+        return false;
+    }
+
+    for (i = 0; i < record->length; i++) {
+        if (__t9_dictionary_key(symbols[i]) == NUM_LEXICON_SYMBOLS) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+t9_dictionary_node_t *
+__t9_dictionary_node_create(void) {
+    t9_dictionary_node_t *node;
+
+    // Allocate memory.
+    node = (t9_dictionary_node_t *) malloc(sizeof(t9_dictionary_node_t));
+    if (node == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(node, 0, sizeof(t9_dictionary_node_t));
+    kv_init(node->words);
+    kv_init(node->completions);
+
+    return node;
+}
+
+void
+__t9_dictionary_node_destroy(t9_dictionary_node_t *const node) {
+    size_t i;
+
+    if (node == NULL) {
+        return;
+    }
+
+    // Recursively destroy all children.
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        __t9_dictionary_node_destroy(node->children[i]);
+    }
+
+    __t9_dictionary_free_words(&node->words);
+    kv_destroy(node->words);
+    kv_destroy(node->completions);
+
+    // Erase and free memory.
+    memset(node, 0, sizeof(t9_dictionary_node_t));
+    free(node);
+}
+
+void
+__t9_dictionary_node_finalize(t9_dictionary_node_t *const node,
+                              uint16_t number_words) {
+    const t9_dictionary_node_t *child;
+    size_t i;
+    size_t j;
+
+    if (node == NULL) {
+        return;
+    }
+
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        __t9_dictionary_node_finalize(node->children[i], number_words);
+    }
+
+    // Keep the most frequent words and the words most frequently following them.
+    __t9_dictionary_truncate(&node->words, number_words);
+    for (i = 0; i < kv_size(node->words); i++) {
+        __t9_dictionary_truncate(&kv_A(node->words, i).next, number_words);
+    }
+
+    // The most frequent words below a node are among the most frequent words of the node and its children.
+    kv_size(node->completions) = 0;
+    for (i = 0; i < kv_size(node->words); i++) {
+        kv_push(const t9_dictionary_word_t *, node->completions, &kv_A(node->words, i));
+    }
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        child = node->children[i];
+        if (child == NULL) {
+            continue;
+        }
+        for (j = 0; j < kv_size(child->completions); j++) {
+            kv_push(const t9_dictionary_word_t *, node->completions, kv_A(child->completions, j));
+        }
+    }
+    qsort(node->completions.a, kv_size(node->completions), sizeof(const t9_dictionary_word_t *),
+          __t9_dictionary_compare_completions);
+    if (kv_size(node->completions) > number_words) {
+        kv_size(node->completions) = number_words;
+    }
+}
+
+int
+__t9_dictionary_compare_words(const void *a,
+                              const void *b) {
+    const t9_dictionary_word_t *word_a;
+    const t9_dictionary_word_t *word_b;
+
+    word_a = (const t9_dictionary_word_t *) a;
+    word_b = (const t9_dictionary_word_t *) b;
+
+    // Words of equal frequency are ordered alphabetically, so that the order is deterministic.
+    if (word_a->count != word_b->count) {
+        return word_a->count > word_b->count ? -1 : 1;
+    }
+
+    return strcmp((const char *) word_a->word, (const char *) word_b->word);
+}
+
+int
+__t9_dictionary_compare_completions(const void *a,
+                                    const void *b) {
+    return __t9_dictionary_compare_words(*(const t9_dictionary_word_t *const *) a,
+                                         *(const t9_dictionary_word_t *const *) b);
+}
+
+size_t
+__t9_dictionary_key(t9_symbol_t symbol) {
+    t9_symbol_t key;
+
+    if (t9_corpus_ctol(symbol, &key) != T9_SUCCESS || strchr(T9_DICTIONARY_SEPARATORS, key) != NULL) {
+        return NUM_LEXICON_SYMBOLS;
+    }
+
+    return (size_t) (strchr(LEXICON_SYMBOLS, key) - LEXICON_SYMBOLS);
+}
@@ -45,3 +45,7 @@ t9_ln(float x) {
     return (float) log(tmp);
 }
 
+double
+t9_score_round(double score) {
+    return round(score / T9_SCORE_RESOLUTION) * T9_SCORE_RESOLUTION;
+}
@@ -0,0 +1,259 @@
+/*!
+  ******************************************************************************
+  * @file    metrics.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements lock-free decoding metrics.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/metrics.h"
+
+t9_metrics_t *
+t9_metrics_create(void) {
+    t9_metrics_t *metrics;
+    size_t i;
+    size_t j;
+
+    // Allocate memory.
+    metrics = (t9_metrics_t *) malloc(sizeof(t9_metrics_t));
+    if (metrics == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    for (i = 0; i < T9_METRICS_NUMBER_COUNTERS; i++) {
+        atomic_init(&metrics->counters[i], 0);
+    }
+    for (i = 0; i < T9_METRICS_NUMBER_HISTOGRAMS; i++) {
+        for (j = 0; j < T9_HISTOGRAM_BUCKETS; j++) {
+            atomic_init(&metrics->histograms[i].buckets[j], 0);
+        }
+        atomic_init(&metrics->histograms[i].count, 0);
+        atomic_init(&metrics->histograms[i].sum, 0);
+    }
+
+    return metrics;
+}
+
+void
+t9_metrics_destroy(t9_metrics_t *const metrics) {
+    if (metrics == NULL) {
+        return;
+    }
+
+    // Erase and free memory.
+    memset(metrics, 0, sizeof(t9_metrics_t));
+    free(metrics);
+}
+
+void
+t9_metrics_add(t9_metrics_t *const metrics,
+               size_t counter,
+               uint64_t value) {
+    if (metrics == NULL || counter >= T9_METRICS_NUMBER_COUNTERS) {
+        return;
+    }
+
+    __t9_metrics_increment(&metrics->counters[counter], value);
+}
+
+void
+t9_metrics_record(t9_metrics_t *const metrics,
+                  size_t histogram,
+                  uint64_t value) {
+    t9_histogram_t *target;
+
+    if (metrics == NULL || histogram >= T9_METRICS_NUMBER_HISTOGRAMS) {
+        return;
+    }
+
+    target = &metrics->histograms[histogram];
+    __t9_metrics_increment(&target->buckets[__t9_histogram_bucket(value)], 1);
+    __t9_metrics_increment(&target->count, 1);
+    __t9_metrics_increment(&target->sum, value);
+}
+
+void
+t9_metrics_merge(t9_metrics_t *const metrics,
+                 t9_metrics_t *const *const shards,
+                 size_t number_shards) {
+    const t9_histogram_t *histogram;
+    size_t i;
+    size_t j;
+    size_t k;
+
+    if (metrics == NULL || shards == NULL) {
+        return;
+    }
+
+    for (i = 0; i < number_shards; i++) {
+        for (j = 0; j < T9_METRICS_NUMBER_COUNTERS; j++) {
+            __t9_metrics_increment(&metrics->counters[j],
+                                   atomic_load_explicit(&shards[i]->counters[j], memory_order_relaxed));
+        }
+        for (j = 0; j < T9_METRICS_NUMBER_HISTOGRAMS; j++) {
+            histogram = &shards[i]->histograms[j];
+            for (k = 0; k < T9_HISTOGRAM_BUCKETS; k++) {
+                __t9_metrics_increment(&metrics->histograms[j].buckets[k],
+                                       atomic_load_explicit(&histogram->buckets[k], memory_order_relaxed));
+            }
+            __t9_metrics_increment(&metrics->histograms[j].count,
+                                   atomic_load_explicit(&histogram->count, memory_order_relaxed));
+            __t9_metrics_increment(&metrics->histograms[j].sum,
+                                   atomic_load_explicit(&histogram->sum, memory_order_relaxed));
+        }
+    }
+}
+
+uint64_t
+t9_histogram_quantile(const t9_histogram_t *const histogram,
+                      double quantile) {
+    uint64_t count;
+    uint64_t rank;
+    uint64_t seen;
+    size_t i;
+
+    if (histogram == NULL) {
+        return 0;
+    }
+
+    count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the value of the quantile, counting from 1.
+    rank = (uint64_t) (quantile * (double) count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    seen = 0;
+    for (i = 0; i < T9_HISTOGRAM_BUCKETS; i++) {
+        seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (seen >= rank) {
+            return __t9_histogram_bucket_limit(i);
+        }
+    }
+
+    // The buckets were updated while reading them.
+    return __t9_histogram_bucket_limit(T9_HISTOGRAM_BUCKETS - 1);
+}
+
+t9_error_t
+t9_metrics_write(t9_metrics_t *const *const shards,
+                 size_t number_shards,
+                 FILE *const stream) {
+    const char *const counter_names[T9_METRICS_NUMBER_COUNTERS] = T9_METRICS_COUNTER_NAMES;
+    const char *const histogram_names[T9_METRICS_NUMBER_HISTOGRAMS] = T9_METRICS_HISTOGRAM_NAMES;
+    const double quantiles[] = {0.5, 0.99, 0.999};
+    const t9_histogram_t *histogram;
+    t9_metrics_t *sum;
+    uint64_t value;
+    double scale;
+    size_t i;
+    size_t j;
+
+    if (shards == NULL || stream == NULL) {
+        return T9_FAILURE;
+    }
+
+    sum = t9_metrics_create();
+    if (sum == NULL) {
+        return T9_FAILURE;
+    }
+    t9_metrics_merge(sum, shards, number_shards);
+
+    for (i = 0; i < T9_METRICS_NUMBER_COUNTERS; i++) {
+        fprintf(stream, "# TYPE %s counter\n", counter_names[i]);
+        fprintf(stream, "%s %lu\n", counter_names[i],
+                (unsigned long) atomic_load_explicit(&sum->counters[i], memory_order_relaxed));
+    }
+
+    for (i = 0; i < T9_METRICS_NUMBER_HISTOGRAMS; i++) {
+        // Durations are recorded in nanoseconds.
+        scale = i == T9_METRICS_BEAM ? 1.0 : 1e-9;
+        histogram = &sum->histograms[i];
+
+        fprintf(stream, "# TYPE %s summary\n", histogram_names[i]);
+        for (j = 0; j < sizeof(quantiles) / sizeof(quantiles[0]); j++) {
+            value = t9_histogram_quantile(histogram, quantiles[j]);
+            fprintf(stream, "%s{quantile=\"%g\"} %g\n", histogram_names[i], quantiles[j], (double) value * scale);
+        }
+        fprintf(stream, "%s_sum %g\n", histogram_names[i],
+                (double) atomic_load_explicit(&histogram->sum, memory_order_relaxed) * scale);
+        fprintf(stream, "%s_count %lu\n", histogram_names[i],
+                (unsigned long) atomic_load_explicit(&histogram->count, memory_order_relaxed));
+    }
+
+    t9_metrics_destroy(sum);
+    return ferror(stream) == 0 ? T9_SUCCESS : T9_FAILURE;
+}
+
+size_t
+__t9_histogram_bucket(uint64_t value) {
+    size_t exponent;
+
+    // Small values have a bucket of their own.
+    if (value < T9_HISTOGRAM_SUB_BUCKETS) {
+        return (size_t) value;
+    }
+
+    exponent = 63 - (size_t) __builtin_clzll(value);
+    if (exponent >= T9_HISTOGRAM_MAX_EXPONENT) {
+        return T9_HISTOGRAM_BUCKETS - 1;
+    }
+
+    // The bits following the highest bit select the bucket within the power of two.
+    return (exponent - T9_HISTOGRAM_SUB_BITS + 1) * T9_HISTOGRAM_SUB_BUCKETS
+           + (size_t) ((value >> (exponent - T9_HISTOGRAM_SUB_BITS)) & (T9_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+uint64_t
+__t9_histogram_bucket_limit(size_t bucket) {
+    size_t exponent;
+    uint64_t sub;
+
+    if (bucket < T9_HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t) bucket;
+    }
+
+    exponent = bucket / T9_HISTOGRAM_SUB_BUCKETS + T9_HISTOGRAM_SUB_BITS - 1;
+    sub = (uint64_t) (bucket % T9_HISTOGRAM_SUB_BUCKETS);
+    return ((T9_HISTOGRAM_SUB_BUCKETS + sub + 1) << (exponent - T9_HISTOGRAM_SUB_BITS)) - 1;
+}
+
+void
+__t9_metrics_increment(atomic_uint_fast64_t *const counter,
+                       uint64_t value) {
+    // The owner is the only writer, so no read-modify-write instruction is needed.
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
@@ -47,38 +47,35 @@ t9_model_create(void) {
     // Erase memory.
     memset(model, 0, sizeof(t9_model_t));
 
-    // Initialize list of the best paths.
-    kv_init(model->paths);
-
     return model;
 }
 
 void
 t9_model_destroy(t9_model_t *const model) {
-    uint32_t i;
-
     if (model == NULL) {
         return;
     }
 
-    // Destroy single paths entries.
-    for (i = 0; i < kv_size(model->paths); i++) {
-        t9_path_destroy(kv_A(model->paths, i));
+    // Destroy the dictionary.
+    if (model->dictionary != NULL) {
+        t9_dictionary_destroy(model->dictionary);
+    }
+
+    // Destroy precomputed results.
+    if (model->table != NULL) {
+        t9_table_destroy(model->table);
     }
 
-    // Destroy the vector containing paths.
-    kv_destroy(model->paths);
+    // Destroy compiled context states.
+    if (model->viterbi != NULL) {
+        t9_viterbi_destroy(model->viterbi);
+    }
 
     // Destroy corpus tree.
     if (model->corpus_tree != NULL) {
         t9_corpus_tree_destroy(model->corpus_tree);
     }
 
-    // Destroy search tree.
-    if (model->search_tree != NULL) {
-        t9_search_tree_destroy(model->search_tree);
-    }
-
     // Unload corpus.
     t9_corpus_unload(&model->corpus);
 
@@ -87,133 +84,802 @@ t9_model_destroy(t9_model_t *const model) {
     free(model);
 }
 
-void
-t9_model_sort_paths(t9_model_t *const model) {
-    uint32_t i;
-    uint32_t j;
-    size_t length;
-    t9_path_t *tmp;
+t9_error_t
+t9_model_set_decoder(t9_model_t *const model,
+                     t9_decoder_t decoder) {
+    if (model == NULL) {
+        return T9_FAILURE;
+    }
 
+    switch (decoder) {
+        case T9_DECODER_BEAM:
+            break;
+        case T9_DECODER_VITERBI:
+        case T9_DECODER_ASTAR:
+            // Compile the context states, unless they are compiled for the current ngram length already.
+            if (model->viterbi != NULL && model->viterbi->ngram_length != model->ngram_length) {
+                t9_viterbi_destroy(model->viterbi);
+                model->viterbi = NULL;
+            }
+            if (model->viterbi == NULL) {
+                model->viterbi = t9_viterbi_compile(model->corpus_tree, model->ngram_length);
+                if (model->viterbi == NULL) {
+                    return T9_FAILURE;
+                }
+            }
+            break;
+        default:
+            return T9_FAILURE;
+    }
+
+    model->decoder = decoder;
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_model_set_table(t9_model_t *const model,
+                   t9_table_t *const table) {
     if (model == NULL) {
-        return;
+        return T9_FAILURE;
     }
 
-    if (kv_size(model->paths) == 0) {
-        return;
+    if (table != NULL && t9_table_matches(table, model) == false) {
+        return T9_FAILURE;
     }
 
-    length = kv_size(model->paths) - 1;
-    for (j = 0; j < length; j++) {
-        for (i = 0; i < length; i++) {
-            // Check if the next path is better.
-            if (kv_A(model->paths, i + 1)->probability < kv_A(model->paths, i)->probability) {
-                // The next path is better.
-                // Therefore swap paths from index (i) and (i + 1).
-                tmp = kv_A(model->paths, i);
-                kv_A(model->paths, i) = kv_A(model->paths, i + 1);
-                kv_A(model->paths, i + 1) = tmp;
-            }
+    if (model->table != NULL) {
+        t9_table_destroy(model->table);
+    }
+    model->table = table;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_model_save(const t9_model_t *const model,
+              const char *const path) {
+    t9_model_header_t header;
+    FILE *fp;
+    bool written;
+    bool table;
+
+    if (model == NULL || model->corpus_tree == NULL || path == NULL) {
+        return T9_FAILURE;
+    }
+
+    // A table built with other decoding parameters would be refused by t9_model_load.
+    table = model->table != NULL && t9_table_matches(model->table, model) == true;
+
+    memset(&header, 0, sizeof(t9_model_header_t));
+    memcpy(header.magic, T9_MODEL_MAGIC, sizeof(header.magic));
+    header.version = T9_MODEL_VERSION;
+    header.decoder = model->decoder;
+    header.ngram_length = model->ngram_length;
+    header.rescore_length = model->rescore_length;
+    header.tree_length = (uint8_t) model->corpus_tree->ngram_length;
+    header.sections = (uint8_t) ((model->dictionary != NULL ? T9_MODEL_SECTION_DICTIONARY : 0)
+                                 | (table == true ? T9_MODEL_SECTION_TABLE : 0));
+    header.number_paths = model->number_paths;
+    header.paths_per_context = model->paths_per_context;
+    header.rescore_paths = model->rescore_paths;
+    header.beam_threshold = model->beam_threshold;
+    header.number_nodes = __t9_model_count_nodes(model->corpus_tree->root);
+
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return T9_FAILURE;
+    }
+
+    written = fwrite(&header, sizeof(t9_model_header_t), 1, fp) == 1
+              && __t9_model_save_node(model->corpus_tree->root, fp) == true
+              && (model->dictionary == NULL || t9_dictionary_write(model->dictionary, fp) == T9_SUCCESS)
+              && (table == false || t9_table_write(model->table, fp) == T9_SUCCESS);
+
+    if (fclose(fp) != 0 || written == false) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_model_load(const char *const path,
+              t9_model_t **model) {
+    t9_model_header_t header;
+    t9_model_t *result;
+    t9_table_t *table;
+    uint64_t remaining;
+    FILE *fp;
+    bool valid;
+
+    if (path == NULL || model == NULL) {
+        return T9_FAILURE;
+    }
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return T9_FAILURE;
+    }
+
+    result = t9_model_create();
+    if (result == NULL) {
+        fclose(fp);
+        return T9_FAILURE;
+    }
+
+    table = NULL;
+    valid = fread(&header, sizeof(t9_model_header_t), 1, fp) == 1
+            && memcmp(header.magic, T9_MODEL_MAGIC, sizeof(header.magic)) == 0
+            && header.version == T9_MODEL_VERSION
+            && header.number_nodes > 0
+            && header.ngram_length > 0
+            && header.ngram_length <= header.tree_length
+            && header.rescore_length <= header.tree_length;
+
+    if (valid == true) {
+        result->ngram_length = header.ngram_length;
+        result->rescore_length = header.rescore_length;
+        result->number_paths = header.number_paths;
+        result->paths_per_context = header.paths_per_context;
+        result->rescore_paths = header.rescore_paths;
+        result->beam_threshold = header.beam_threshold;
+
+        // Every record has to be read, no more and no less.
+        remaining = header.number_nodes;
+        result->corpus_tree = t9_corpus_tree_create();
+        valid = result->corpus_tree != NULL
+                && __t9_model_load_node(result->corpus_tree->root, fp, &remaining, header.tree_length) == true
+                && remaining == 0;
+        if (valid == true) {
+            result->corpus_tree->ngram_length = header.tree_length;
+            t9_corpus_tree_fingerprint(result->corpus_tree);
         }
+        if (valid == true && (header.sections & T9_MODEL_SECTION_DICTIONARY) != 0) {
+            valid = t9_dictionary_read(fp, &result->dictionary) == T9_SUCCESS;
+        }
+        if (valid == true && (header.sections & T9_MODEL_SECTION_TABLE) != 0) {
+            valid = t9_table_read(fp, &table) == T9_SUCCESS;
+        }
+    }
+    fclose(fp);
+
+    if (valid == false || t9_model_set_decoder(result, header.decoder) != T9_SUCCESS) {
+        t9_table_destroy(table);
+        t9_model_destroy(result);
+        return T9_FAILURE;
+    }
+
+    // The table has to belong to the model it was written with.
+    if (table != NULL && t9_model_set_table(result, table) != T9_SUCCESS) {
+        t9_table_destroy(table);
+        t9_model_destroy(result);
+        return T9_FAILURE;
     }
+
+    *model = result;
+    return T9_SUCCESS;
 }
 
-t9_error_t t9_model_autocomplete(t9_model_t *const model,
+t9_error_t t9_model_autocomplete(const t9_model_t *const model,
                                  const t9_symbol_t *const lexicon_sequence,
                                  t9_symbol_t **suggestion) {
-    // Populate the search tree.
-    if (t9_search_tree_type(model, lexicon_sequence) == T9_FAILURE) {
+    t9_session_t *session;
+    t9_error_t error;
+
+    session = t9_session_create(model);
+    if (session == NULL) {
         return T9_FAILURE;
     }
 
-    // Extract the best suggested text from the model.
-    // Note: model->paths is a list of the completion suggestions with descending scores.
-    *suggestion = t9_path_flatten(kv_A(model->paths, 0));
-    if (*suggestion == NULL) {
+    // Decode the sequence and extract the best suggested text.
+    error = t9_session_type(session, lexicon_sequence);
+    if (error == T9_SUCCESS) {
+        error = t9_session_suggestion(session, suggestion);
+    }
+
+    t9_session_destroy(session);
+    return error;
+}
+
+t9_error_t
+t9_model_autocomplete_nbest(const t9_model_t *const model,
+                            t9_session_t *const session,
+                            const t9_symbol_t *const lexicon_sequence,
+                            t9_symbol_t *const suggestions,
+                            size_t stride,
+                            float *const scores,
+                            size_t capacity,
+                            size_t *const count) {
+    if (model == NULL || session == NULL || session->model != model) {
         return T9_FAILURE;
     }
 
-    return T9_SUCCESS;
+    if (t9_session_reset(session) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    if (t9_session_type(session, lexicon_sequence) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    return t9_session_nbest(session, suggestions, stride, scores, capacity, count);
 }
 
 t9_error_t
-t9_model_evaluate(t9_model_t *const model,
-                  double *const error) {
-    t9_symbol_t *lexicon_sequence;
-    t9_symbol_t *suggestion;
-    size_t diff;
-    size_t length;
+t9_model_autocomplete_batch(const t9_model_t *const model,
+                            const t9_symbol_t *const *const sequences,
+                            size_t count,
+                            t9_symbol_t **suggestions,
+                            t9_pool_t *const pool) {
+    t9_model_batch_t batch;
+
+    if (model == NULL || sequences == NULL || suggestions == NULL) {
+        return T9_FAILURE;
+    }
 
-    // Convert text into lexicon symbols.
-    if (t9_corpus_lexicon_from_corpus(model->corpus.test_buffer,
-                                      model->corpus.test_buffer_size,
-                                      &lexicon_sequence) == T9_FAILURE) {
+    memset(&batch, 0, sizeof(t9_model_batch_t));
+    batch.sequences = sequences;
+    batch.suggestions = suggestions;
+    batch.count = count;
+
+    return __t9_model_run_batch(model, &batch, count, __t9_model_autocomplete_batch_task, pool);
+}
+
+t9_error_t
+t9_model_autocomplete_shared(const t9_model_t *const model,
+                             const t9_symbol_t *const *const sequences,
+                             size_t count,
+                             t9_symbol_t **suggestions,
+                             t9_pool_t *const pool) {
+    t9_model_batch_t batch;
+    t9_error_t error;
+    size_t i;
+
+    if (model == NULL || sequences == NULL || suggestions == NULL) {
         return T9_FAILURE;
     }
 
-    // Limit lexicon sequence to the max. allowed length.
-    // If the lexicon text is smaller, use the lexicon text length.
-    length = strlen((const char *) lexicon_sequence);
+    memset(&batch, 0, sizeof(t9_model_batch_t));
+    batch.sequences = sequences;
+    batch.suggestions = suggestions;
+    batch.count = count;
 
-    if (t9_model_autocomplete(model, lexicon_sequence, &suggestion) == T9_FAILURE) {
+    // Sort the sequences, so that sequences sharing a prefix are neighbours.
+    batch.entries = (t9_model_batch_entry_t *) malloc((count > 0 ? count : 1) * sizeof(t9_model_batch_entry_t));
+    if (batch.entries == NULL) {
         return T9_FAILURE;
     }
+    for (i = 0; i < count; i++) {
+        batch.entries[i].sequence = sequences[i];
+        batch.entries[i].index = i;
+        suggestions[i] = NULL;
+        if (sequences[i] == NULL) {
+            free(batch.entries);
+            return T9_FAILURE;
+        }
+    }
+    qsort(batch.entries, count, sizeof(t9_model_batch_entry_t), __t9_model_compare_batch_entries);
 
-    // Calculate the deviation between the suggestion and the original.
-    diff = t9_corpus_sequence_diff(suggestion, model->corpus.test_buffer, length);
+    // Prefixes shared across chunks are decoded once per chunk, so there are only a few chunks per thread.
+    batch.number_chunks = pool != NULL ? (size_t) pool->number_threads * T9_BATCH_CHUNKS_PER_THREAD : 1;
+    if (batch.number_chunks > count) {
+        batch.number_chunks = count;
+    }
 
-    // Calculate the error.
-    *error = (double) diff / (double) length;
+    error = __t9_model_run_batch(model, &batch, batch.number_chunks, __t9_model_autocomplete_shared_task, pool);
 
-    printf("[Evaluation]: Suggestion: \"%s\"\n", suggestion);
+    free(batch.entries);
+    return error;
+}
 
-    free(lexicon_sequence);
-    free(suggestion);
+uint64_t
+__t9_model_count_nodes(const t9_corpus_node_t *const node) {
+    uint64_t count;
+    size_t i;
+
+    count = 1;
+    for (i = 0; i < kv_size(node->children); i++) {
+        count += __t9_model_count_nodes(kv_A(node->children, i));
+    }
+
+    return count;
+}
+
+bool
+__t9_model_save_node(const t9_corpus_node_t *const node,
+                     FILE *const fp) {
+    t9_model_node_t record;
+    size_t i;
+
+    memset(&record, 0, sizeof(t9_model_node_t));
+    record.count = node->count;
+    record.probability = node->probability;
+    record.number_children = (uint32_t) kv_size(node->children);
+    record.symbol = node->symbol;
+    if (fwrite(&record, sizeof(t9_model_node_t), 1, fp) != 1) {
+        return false;
+    }
+
+    for (i = 0; i < kv_size(node->children); i++) {
+        if (__t9_model_save_node(kv_A(node->children, i), fp) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+__t9_model_load_node(t9_corpus_node_t *const node,
+                     FILE *const fp,
+                     uint64_t *const remaining,
+                     uint16_t depth) {
+    t9_model_node_t record;
+    t9_corpus_node_t *child;
+    uint32_t i;
+
+    if (*remaining == 0 || fread(&record, sizeof(t9_model_node_t), 1, fp) != 1) {
+        return false;
+    }
+    (*remaining)--;
+
+    // A node can not have more children than records are left, nor any below the depth of the tree.
+    if (record.number_children > *remaining || (record.number_children > 0 && depth == 0)) {
+        return false;
+    }
+
+    node->count = record.count;
+    node->probability = record.probability;
+    node->symbol = record.symbol;
+    for (i = 0; i < record.number_children; i++) {
+        child = t9_corpus_node_create();
+        if (child == NULL) {
+            return false;
+        }
+        child->parent = node;
+        kv_push(t9_corpus_node_t *, node->children, child);
+        if (__t9_model_load_node(child, fp, remaining, depth - 1) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+t9_error_t
+__t9_model_run_batch(const t9_model_t *const model,
+                     t9_model_batch_t *const batch,
+                     size_t count,
+                     t9_pool_task_t task,
+                     t9_pool_t *const pool) {
+    t9_error_t error;
+    size_t number_workers;
+    size_t i;
+
+    number_workers = pool != NULL ? pool->number_threads : 1;
+
+    // Every worker holds its own reusable session.
+    batch->sessions = (t9_session_t **) calloc(number_workers, sizeof(t9_session_t *));
+    batch->errors = (t9_error_t *) calloc(number_workers, sizeof(t9_error_t));
+    if (batch->sessions == NULL || batch->errors == NULL) {
+        free(batch->sessions);
+        free(batch->errors);
+        return T9_FAILURE;
+    }
+
+    error = T9_SUCCESS;
+    for (i = 0; i < number_workers; i++) {
+        batch->errors[i] = T9_SUCCESS;
+        batch->sessions[i] = t9_session_create(model);
+        if (batch->sessions[i] == NULL) {
+            error = T9_FAILURE;
+        }
+    }
+
+    if (error == T9_SUCCESS) {
+        if (pool != NULL) {
+            error = t9_pool_run(pool, count, task, batch);
+        } else {
+            for (i = 0; i < count; i++) {
+                task(0, i, batch);
+            }
+        }
+    }
+
+    for (i = 0; i < number_workers; i++) {
+        if (batch->errors[i] != T9_SUCCESS) {
+            error = T9_FAILURE;
+        }
+        t9_session_destroy(batch->sessions[i]);
+    }
+    free(batch->sessions);
+    free(batch->errors);
+
+    return error;
+}
+
+void
+__t9_model_autocomplete_batch_task(size_t worker,
+                                   size_t index,
+                                   void *arg) {
+    t9_model_batch_t *batch;
+    t9_session_t *session;
+
+    batch = (t9_model_batch_t *) arg;
+    session = batch->sessions[worker];
+
+    batch->suggestions[index] = NULL;
+    if (t9_session_reset(session) != T9_SUCCESS
+        || t9_session_type(session, batch->sequences[index]) != T9_SUCCESS
+        || t9_session_suggestion(session, &batch->suggestions[index]) != T9_SUCCESS) {
+        batch->suggestions[index] = NULL;
+        batch->errors[worker] = T9_FAILURE;
+    }
+}
+
+void
+__t9_model_autocomplete_shared_task(size_t worker,
+                                    size_t index,
+                                    void *arg) {
+    t9_model_batch_t *batch;
+    t9_session_t *session;
+    size_t begin;
+    size_t end;
+
+    batch = (t9_model_batch_t *) arg;
+    session = batch->sessions[worker];
+
+    begin = index * batch->count / batch->number_chunks;
+    end = (index + 1) * batch->count / batch->number_chunks;
+
+    if (t9_session_reset(session) != T9_SUCCESS
+        || __t9_model_autocomplete_shared_range(batch, session, begin, end, 0) != T9_SUCCESS) {
+        batch->errors[worker] = T9_FAILURE;
+    }
+}
+
+t9_error_t
+__t9_model_autocomplete_shared_range(t9_model_batch_t *const batch,
+                                     t9_session_t *const session,
+                                     size_t begin,
+                                     size_t end,
+                                     size_t depth) {
+    t9_model_batch_entry_t *entry;
+    t9_session_t *fork;
+    t9_error_t error;
+    t9_symbol_t key;
+    size_t next;
+
+    error = T9_SUCCESS;
+    while (true) {
+        // Sequences ending with the prefix sort first.
+        while (begin < end && batch->entries[begin].sequence[depth] == 0) {
+            entry = &batch->entries[begin];
+            if (t9_session_suggestion(session, &batch->suggestions[entry->index]) != T9_SUCCESS) {
+                batch->suggestions[entry->index] = NULL;
+                error = T9_FAILURE;
+            }
+            begin++;
+        }
+
+        if (begin == end) {
+            return error;
+        }
+
+        // Find the group of sequences continuing with the same key.
+        key = batch->entries[begin].sequence[depth];
+        next = begin + 1;
+        while (next < end && batch->entries[next].sequence[depth] == key) {
+            next++;
+        }
+
+        if (next == end) {
+            // The last group continues on the session itself, without any copy.
+            if (t9_session_insert(session, key, 0.0, NULL) != T9_SUCCESS) {
+                return T9_FAILURE;
+            }
+            depth++;
+        } else {
+            // The session branches, so the group continues on a copy.
+            fork = t9_session_clone(session);
+            if (fork == NULL
+                || t9_session_insert(fork, key, 0.0, NULL) != T9_SUCCESS
+                || __t9_model_autocomplete_shared_range(batch, fork, begin, next, depth + 1) != T9_SUCCESS) {
+                error = T9_FAILURE;
+            }
+            t9_session_destroy(fork);
+            begin = next;
+        }
+    }
+}
+
+int
+__t9_model_compare_batch_entries(const void *a,
+                                 const void *b) {
+    const t9_model_batch_entry_t *entry_a;
+    const t9_model_batch_entry_t *entry_b;
+
+    entry_a = (const t9_model_batch_entry_t *) a;
+    entry_b = (const t9_model_batch_entry_t *) b;
+
+    return strcmp((const char *) entry_a->sequence, (const char *) entry_b->sequence);
+}
+
+t9_error_t
+t9_model_evaluate(const t9_model_t *const model,
+                  double *const error) {
+    t9_evaluation_t result;
+
+    if (error == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (t9_model_evaluate_windows(model, T9_EVALUATION_WINDOW_LENGTH, NULL, &result) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    *error = result.symbol_error_rate;
     return T9_SUCCESS;
 }
 
 t9_error_t
-t9_model_prune_path(t9_model_t *const model,
-                    t9_path_t *const path) {
-    ssize_t i;
-    t9_search_node_t *node;
+t9_model_evaluate_windows(const t9_model_t *const model,
+                          size_t window_length,
+                          t9_pool_t *const pool,
+                          t9_evaluation_t *const result) {
+    t9_evaluation_window_vector_t windows;
+    t9_evaluation_window_t *window;
+    t9_model_evaluation_job_t job;
+    t9_error_t error;
+    size_t number_workers;
+    size_t i;
+    double start;
+
+    if (model == NULL || result == NULL || window_length == 0) {
+        return T9_FAILURE;
+    }
+
+    memset(result, 0, sizeof(t9_evaluation_t));
+    start = t9_timer_now_ms();
+
+    // Split the test set into independent windows.
+    kv_init(windows);
+    __t9_model_evaluation_split(model->corpus.test_buffer, model->corpus.test_buffer_size, window_length, &windows);
+
+    // Every worker holds its own reusable session.
+    number_workers = pool != NULL ? pool->number_threads : 1;
+    job.model = model;
+    job.windows = windows.a;
+    job.sessions = (t9_session_t **) calloc(number_workers, sizeof(t9_session_t *));
+    if (job.sessions == NULL) {
+        kv_destroy(windows);
+        return T9_FAILURE;
+    }
 
-    if (model == NULL || path == NULL) {
+    error = T9_SUCCESS;
+    for (i = 0; i < number_workers; i++) {
+        job.sessions[i] = t9_session_create(model);
+        if (job.sessions[i] == NULL) {
+            error = T9_FAILURE;
+        }
+    }
+
+    // Decode all windows.
+    if (error == T9_SUCCESS) {
+        if (pool != NULL) {
+            error = t9_pool_run(pool, kv_size(windows), __t9_model_evaluation_task, &job);
+        } else {
+            for (i = 0; i < kv_size(windows); i++) {
+                __t9_model_evaluation_task(0, i, &job);
+            }
+        }
+    }
+
+    for (i = 0; i < number_workers; i++) {
+        t9_session_destroy(job.sessions[i]);
+    }
+    free(job.sessions);
+
+    // Aggregate the results of all windows.
+    for (i = 0; i < kv_size(windows); i++) {
+        window = &kv_A(windows, i);
+        if (window->error != T9_SUCCESS) {
+            error = T9_FAILURE;
+        }
+        result->windows++;
+        result->symbols += window->length;
+        result->symbol_errors += window->symbol_errors;
+        result->words += window->words;
+        result->word_errors += window->word_errors;
+        result->latency_ms += window->duration_ms;
+    }
+    kv_destroy(windows);
+
+    result->duration_ms = t9_timer_now_ms() - start;
+    if (result->symbols > 0) {
+        result->latency_ms /= (double) result->symbols;
+        result->symbol_error_rate = (double) result->symbol_errors / (double) result->symbols;
+    }
+    if (result->words > 0) {
+        result->word_error_rate = (double) result->word_errors / (double) result->words;
+    }
+    if (result->duration_ms > 0) {
+        result->keys_per_second = (double) result->symbols / (result->duration_ms / 1000.0);
+    }
+
+    return error;
+}
+
+t9_error_t
+t9_model_sweep(const t9_model_t *const model,
+               t9_sweep_setting_t *const settings,
+               size_t count,
+               size_t window_length,
+               t9_pool_t *const pool) {
+    t9_model_t view;
+    t9_error_t error;
+    size_t i;
+
+    if (model == NULL || settings == NULL) {
         return T9_FAILURE;
     }
 
-    // Prune all nodes contained in the path, starting at the end of the path.
-    if (kv_size(path->nodes) > 0) {
-        i = kv_size(path->nodes) - 1;
-        do {
-            // Get a node of the path.
-            node = kv_A(path->nodes, i);
-            // Prune this node.
-            __t9_model_prune_path_helper(model, node, (size_t) i);
-            i--;
-        } while (i >= 0);
+    // Validate all settings before spending time on the evaluation.
+    for (i = 0; i < count; i++) {
+        if (settings[i].ngram_length < 1 || settings[i].ngram_length > model->ngram_length
+            || settings[i].number_paths < 1) {
+            return T9_FAILURE;
+        }
     }
+
+    for (i = 0; i < count; i++) {
+        // A shallow copy of the model shares corpus and corpus tree, only the decoding parameters differ.
+        view = *model;
+        view.ngram_length = settings[i].ngram_length;
+        view.number_paths = settings[i].number_paths;
+
+        // The exact decoders need context states compiled for the ngram length of the setting.
+        if (view.decoder != T9_DECODER_BEAM && view.viterbi->ngram_length != view.ngram_length) {
+            view.viterbi = t9_viterbi_compile(view.corpus_tree, view.ngram_length);
+            if (view.viterbi == NULL) {
+                return T9_FAILURE;
+            }
+        }
+
+        error = t9_model_evaluate_windows(&view, window_length, pool, &settings[i].result);
+        if (view.viterbi != model->viterbi) {
+            t9_viterbi_destroy(view.viterbi);
+        }
+        if (error != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+
     return T9_SUCCESS;
 }
 
 void
-__t9_model_prune_path_helper(t9_model_t *const model,
-                             t9_search_node_t *const node,
-                             size_t depth) {
-    list_t *level_map;
-    list_node_t *list_node;
-
-    // We can only prune a node if it has no further children.
-    if (t9_search_node_is_leaf(node) == true) {
-        // Remove node from its parents children.
-        list_node = list_find(node->parent->children2, node);
-        list_remove(node->parent->children2, list_node);
-
-        // Remove node from the list of nodes for the tree level it resides on.
-        level_map = kv_A(model->search_tree->level_table2, depth);
-        list_node = list_find(level_map, node);
-        list_remove(level_map, list_node);
-
-        // Destroy the node itself.
-        t9_search_node_destroy(node);
+__t9_model_evaluation_split(const t9_symbol_t *const buffer,
+                            size_t buffer_size,
+                            size_t window_length,
+                            t9_evaluation_window_vector_t *const windows) {
+    t9_evaluation_window_t window;
+    t9_symbol_t key;
+    size_t offset;
+    size_t length;
+    size_t sentence_cut;
+    size_t word_cut;
+    size_t i;
+
+    memset(&window, 0, sizeof(t9_evaluation_window_t));
+
+    offset = 0;
+    while (offset < buffer_size) {
+        // Skip separating spaces and symbols that can not be typed.
+        if (buffer[offset] == ' ' || t9_corpus_ctol(buffer[offset], &key) != T9_SUCCESS) {
+            offset++;
+            continue;
+        }
+
+        // Extend the window until it is full or a symbol that can not be typed is hit.
+        length = 0;
+        while (length < window_length && offset + length < buffer_size
+               && t9_corpus_ctol(buffer[offset + length], &key) == T9_SUCCESS) {
+            length++;
+        }
+
+        // A full window that ends within a word is cut at the last sentence end or, if there is none, at the last
+        // word boundary.
+        if (length == window_length && offset + length < buffer_size && buffer[offset + length] != ' ') {
+            sentence_cut = 0;
+            word_cut = 0;
+            for (i = length - 1; i > 0; i--) {
+                if (buffer[offset + i] == ' ') {
+                    if (word_cut == 0) {
+                        word_cut = i;
+                    }
+                    if (buffer[offset + i - 1] == '.') {
+                        sentence_cut = i;
+                        break;
+                    }
+                }
+            }
+            if (sentence_cut > 0) {
+                length = sentence_cut;
+            } else if (word_cut > 0) {
+                length = word_cut;
+            }
+        }
+
+        window.offset = offset;
+        window.length = length;
+        kv_push(t9_evaluation_window_t, *windows, window);
+        offset += length;
+    }
+}
+
+void
+__t9_model_evaluation_task(size_t worker,
+                           size_t index,
+                           void *arg) {
+    t9_model_evaluation_job_t *job;
+    t9_evaluation_window_t *window;
+    t9_session_t *session;
+    const t9_symbol_t *truth;
+    t9_symbol_t *lexicon_sequence;
+    t9_symbol_t *suggestion;
+    bool in_word;
+    bool word_error;
+    size_t i;
+    double start;
+
+    job = (t9_model_evaluation_job_t *) arg;
+    window = &job->windows[index];
+    session = job->sessions[worker];
+    truth = &job->model->corpus.test_buffer[window->offset];
+
+    window->error = T9_FAILURE;
+
+    // Convert text into lexicon symbols.
+    if (t9_corpus_lexicon_from_corpus(truth, window->length, &lexicon_sequence) != T9_SUCCESS) {
+        return;
+    }
+
+    // Decode the window.
+    start = t9_timer_now_ms();
+    if (t9_session_reset(session) != T9_SUCCESS
+        || t9_session_type(session, lexicon_sequence) != T9_SUCCESS
+        || t9_session_suggestion(session, &suggestion) != T9_SUCCESS) {
+        free(lexicon_sequence);
+        return;
     }
+    window->duration_ms = t9_timer_now_ms() - start;
+
+    // Calculate the deviation between the suggestion and the original.
+    window->symbol_errors = t9_corpus_sequence_diff(suggestion, truth, window->length);
+
+    // A word counts as wrong, if any of its symbols is wrong.
+    in_word = false;
+    word_error = false;
+    for (i = 0; i <= window->length; i++) {
+        if (i == window->length || truth[i] == ' ') {
+            if (in_word == true) {
+                window->words++;
+                if (word_error == true) {
+                    window->word_errors++;
+                }
+            }
+            in_word = false;
+            word_error = false;
+        } else {
+            in_word = true;
+            if (suggestion[i] != truth[i]) {
+                word_error = true;
+            }
+        }
+    }
+
+    window->error = T9_SUCCESS;
+    free(lexicon_sequence);
+    free(suggestion);
 }
@@ -171,6 +171,25 @@ t9_corpus_node_add_child(t9_corpus_node_t *const node,
     kv_push(t9_corpus_node_t *, node->children, child);
 }
 
+t9_corpus_node_t *
+t9_corpus_node_descend(const t9_corpus_node_t *const node,
+                       const t9_symbol_t *const sequence,
+                       size_t length) {
+    const t9_corpus_node_t *current;
+    size_t i;
+
+    if (node == NULL || sequence == NULL) {
+        return NULL;
+    }
+
+    current = node;
+    for (i = 0; i < length && current != NULL; i++) {
+        current = t9_corpus_node_get_child(current, sequence[i]);
+    }
+
+    return (t9_corpus_node_t *) current;
+}
+
 /* ================================================================================== */
 
 /* === Search tree ================================================================== */
@@ -229,81 +248,61 @@ bool t9_search_node_is_leaf(const t9_search_node_t *const node) {
 }
 
 t9_error_t
-t9_search_node_insert(t9_search_node_t *const node,
+t9_search_node_expand(t9_search_node_t *const node,
                       t9_symbol_t t9_input,
-                      const t9_symbol_t *sequence,
-                      const uint32_t depth,
-                      t9_model_t *const model) {
-
-    list_iterator_t *iter;
-    list_node_t *list_node;
+                      size_t depth,
+                      t9_session_t *const session) {
     t9_search_node_t *child;
     const t9_symbol_t *symbol;
     float prob_t_b;
     float prob_b_bb;
-    size_t sequence_length;
-    t9_symbol_t *sequence_ptr;
-    t9_symbol_t word[model->ngram_length + sizeof(t9_symbol_t) + 1];
+    size_t context_length;
+    t9_symbol_t word[session->model->ngram_length + sizeof(t9_symbol_t) + 1];
 
-    if (node == NULL || sequence == NULL) {
+    if (node == NULL) {
         return T9_FAILURE;
     }
 
-    if (t9_search_node_is_leaf(node)) {
-        // Append a child for each corpus symbols to the leaf node.
-        symbol = (const t9_symbol_t *) CORPUS_SYMBOLS;
-        while (*symbol != 0) {
-            // Create a new child.
-            child = t9_search_node_create();
-            if (child == NULL) {
-                return T9_FAILURE;
-            }
+    // The probability of a symbol is conditioned on the last (ngram_length - 1) symbols leading to the leaf.
+    context_length = session->model->ngram_length > 1 ? (size_t) (session->model->ngram_length - 1) : 0;
+    context_length = t9_search_node_context(node, context_length, word);
+
+    // Append a child for each corpus symbols to the leaf node.
+    symbol = (const t9_symbol_t *) CORPUS_SYMBOLS;
+    while (*symbol != 0) {
+        // Create a new child, reusing a released node of the session.
+        child = __t9_session_node_new(session);
+        if (child == NULL) {
+            return T9_FAILURE;
+        }
 
-            sequence_length = strlen((const char *) sequence);
-            if (sequence_length >= (size_t) (model->ngram_length - 1)) {
-                sequence += (sequence_length - (model->ngram_length - 1));
-            }
-            if (snprintf((char *) word, sizeof(word), "%s%c", sequence, *symbol) < 0) {
-                t9_search_node_destroy(child);
-                return T9_FAILURE;
-            }
+        word[context_length] = *symbol;
+        word[context_length + 1] = 0;
 
-            // Calculate child probability.
-            prob_t_b = -t9_ln(t9_corpus_tree_button_for_letter(t9_input, *symbol));
-            prob_b_bb = -t9_ln(t9_corpus_tree_conditional_probability(model->corpus_tree, word));
-            child->probability = prob_t_b + prob_b_bb + node->probability;
+        // Calculate child probability.
+        prob_t_b = -t9_ln(t9_corpus_tree_button_for_letter(t9_input, *symbol));
+        prob_b_bb = -t9_ln(t9_corpus_tree_conditional_probability(session->model->corpus_tree, word));
+        child->probability = node->probability + t9_score_round((double) prob_t_b + (double) prob_b_bb);
 
-            // Set child symbol and parent.
-            child->symbol = *symbol;
-            child->parent = node;
+        // Set child symbol and parent.
+        child->symbol = *symbol;
+        child->parent = node;
 
-            // Add child to parent.
-            t9_search_node_add_child(node, child);
+        // Add child to parent.
+        list_rpush(node->children2, __t9_session_entry_new(session, child));
 
-            // Add the new child to the list of nodes that are on the same tree depth.
-            list_rpush(kv_A(model->search_tree->level_table2, depth), list_node_new(child));
+        // Add the new child to the list of nodes that are on the same tree depth.
+        child->level_entry = list_rpush(kv_A(session->search_tree->level_table2, depth),
+                                        __t9_session_entry_new(session, child));
 
-            symbol++;
-        }
-    } else {
-        // Descend the tree until a leaf node.
-        iter = list_iterator_new(node->children2, LIST_HEAD);
-        while ((list_node = list_iterator_next(iter)) != NULL) {
-            child = list_node_data(list_node);
-            if (asprintf((char **)&sequence_ptr, "%s%c", sequence, child->symbol) == -1) {
-                list_iterator_destroy(iter);
-                return T9_FAILURE;
-            }
-            if (t9_search_node_insert(child, t9_input, sequence_ptr, depth + 1, model) != T9_SUCCESS) {
-                free(sequence_ptr);
-                list_iterator_destroy(iter);
-                return T9_FAILURE;
-            }
-            free(sequence_ptr);
-            sequence_ptr = NULL;
-        }
-        list_iterator_destroy(iter);
+        symbol++;
     }
+
+    if (session->metrics != NULL) {
+        t9_metrics_add(session->metrics, T9_METRICS_NODES_EXPANDED,
+                       (uint64_t) (symbol - (const t9_symbol_t *) CORPUS_SYMBOLS));
+    }
+
     return T9_SUCCESS;
 }
 
@@ -315,18 +314,17 @@ t9_search_node_add_child(t9_search_node_t *const node,
 
 void
 t9_node_search_paths(t9_search_node_t *const node,
-                     t9_model_t *const model,
+                     t9_session_t *const session,
                      t9_path_t *tmp_path) {
     t9_search_node_t *child;
     t9_path_t *candidate;
 
-    list_iterator_t *iter;
     list_node_t *list_node;
 
-    if (kv_size(model->paths) > 0) {
-        if (kv_size(model->paths) >= model->number_paths) {
+    if (kv_size(session->paths) > 0) {
+        if (kv_size(session->paths) >= session->model->number_paths) {
             // Maximal number of paths to search was reached.
-            if (node->probability >= kv_last(model->paths)->probability) {
+            if (node->probability >= kv_last(session->paths)->probability) {
                 // Current path is not better than the worst path in the list of known best paths.
                 // Skip this path.
                 return;
@@ -337,38 +335,40 @@ t9_node_search_paths(t9_search_node_t *const node,
     if (t9_search_node_is_leaf(node)) {
         // Leaf node was hit, the taken path therefore spans the whole tree depth.
 
-        // Copy path.
-        candidate = t9_path_duplicate(tmp_path);
+        // Copy path into a released path of the session.
+        candidate = __t9_session_path_new(session);
+        if (candidate == NULL) {
+            return;
+        }
+        t9_path_copy(candidate, tmp_path);
         // Append path to the list of best paths.
-        kv_push(t9_path_t *, model->paths, candidate);
+        kv_push(t9_path_t *, session->paths, candidate);
         // Sort list of best paths.
-        t9_model_sort_paths(model);
+        t9_session_sort_paths(session);
 
-        // In case there are now more best paths than requested by the model delete the worst path.
-        if (kv_size(model->paths) > model->number_paths) {
-            candidate = kv_pop(model->paths);
-            t9_path_destroy(candidate);
+        // In case there are now more best paths than requested by the model release the worst path.
+        if (kv_size(session->paths) > session->model->number_paths) {
+            candidate = kv_pop(session->paths);
+            __t9_session_path_release(session, candidate);
         }
     } else {
         // Descend tree until a leaf node is hit.
-        iter = list_iterator_new(node->children2, LIST_HEAD);
-        while ((list_node = list_iterator_next(iter)) != NULL) {
+        for (list_node = node->children2->head; list_node != NULL; list_node = list_node->next) {
             child = list_node_data(list_node);
             // Descend down separate a path for each child.
             t9_path_push(tmp_path, child);
-            t9_node_search_paths(child, model, tmp_path);
+            t9_node_search_paths(child, session, tmp_path);
             t9_path_pop(tmp_path);
         }
-        list_iterator_destroy(iter);
     }
 }
 
 void
 t9_search_node_prune(t9_search_node_t *const node,
-                     t9_model_t *const model,
+                     t9_session_t *const session,
                      t9_path_t *const path) {
-    list_iterator_t *iter;
     list_node_t *list_node;
+    list_node_t *next;
     t9_search_node_t *child;
     t9_path_t *best_path;
     size_t i;
@@ -378,8 +378,8 @@ t9_search_node_prune(t9_search_node_t *const node,
         // End of tree was reached.
         // Check if the path that was taken to reach this node is one of the best known paths.
         found = false;
-        for (i = 0; i < kv_size(model->paths); i++) {
-            best_path = kv_A(model->paths, i);
+        for (i = 0; i < kv_size(session->paths); i++) {
+            best_path = kv_A(session->paths, i);
             if (t9_path_is_equal(path, best_path) == true) {
                 // Taken path is one of the best paths. (No pruning)
                 found = true;
@@ -389,19 +389,21 @@ t9_search_node_prune(t9_search_node_t *const node,
         if (found == false) {
             // Path is not known to be one of the bst paths.
             // Prune this path.
-            t9_model_prune_path(model, path);
+            t9_session_prune_path(session, path);
         }
     } else {
-        // Iterate all children of the node.
-        iter = list_iterator_new(node->children2, LIST_HEAD);
-        while ((list_node = list_iterator_next(iter)) != NULL) {
+        // Iterate all children of the node. Pruning a child releases its entry, so the next entry is fetched
+        // beforehand.
+        list_node = node->children2->head;
+        while (list_node != NULL) {
+            next = list_node->next;
             child = list_node_data(list_node);
             // Descend down a path for each child.
             t9_path_push(path, child);
-            t9_search_node_prune(child, model, path);
+            t9_search_node_prune(child, session, path);
             t9_path_pop(path);
+            list_node = next;
         }
-        list_iterator_destroy(iter);
     }
 }
 
@@ -449,4 +451,44 @@ t9_search_node_descend(const t9_search_node_t *const node,
     return t9_search_node_descend(child, sequence + 1);
 }
 
+float
+t9_search_node_cost(const t9_search_node_t *const node,
+                    const t9_corpus_tree_t *const tree,
+                    uint8_t ngram_length) {
+    t9_symbol_t word[ngram_length + sizeof(t9_symbol_t) + 1];
+    size_t length;
+
+    // The symbol is conditioned on the last (ngram_length - 1) symbols before it.
+    length = t9_search_node_context(node->parent, ngram_length > 1 ? (size_t) (ngram_length - 1) : 0, word);
+    word[length] = node->symbol;
+    word[length + 1] = 0;
+
+    return -t9_ln(t9_corpus_tree_conditional_probability(tree, word));
+}
+
+size_t
+t9_search_node_context(const t9_search_node_t *const node,
+                       size_t length,
+                       t9_symbol_t *const context) {
+    const t9_search_node_t *current;
+    size_t count;
+
+    // Count the available symbols, the root node does not have a parent and is not part of the context.
+    count = 0;
+    current = node;
+    while (count < length && current != NULL && current->parent != NULL) {
+        count++;
+        current = current->parent;
+    }
+
+    // Fill the context backwards.
+    current = node;
+    for (length = count; length > 0; length--) {
+        context[length - 1] = current->symbol;
+        current = current->parent;
+    }
+
+    return count;
+}
+
 /* ================================================================================== */
@@ -80,6 +80,16 @@ t9_path_pop(t9_path_t *const path) {
     return kv_pop(path->nodes);
 }
 
+t9_search_node_t *
+t9_path_shift(t9_path_t *const path) {
+    t9_search_node_t *node;
+
+    node = kv_A(path->nodes, 0);
+    memmove(path->nodes.a, path->nodes.a + 1, (kv_size(path->nodes) - 1) * sizeof(t9_search_node_t *));
+    kv_size(path->nodes)--;
+    return node;
+}
+
 t9_path_t *
 t9_path_duplicate(const t9_path_t *const path) {
     uint32_t i;
@@ -103,11 +113,22 @@ t9_path_duplicate(const t9_path_t *const path) {
     return clone;
 }
 
+void
+t9_path_copy(t9_path_t *const path,
+             const t9_path_t *const source) {
+    size_t i;
+
+    path->probability = source->probability;
+    kv_size(path->nodes) = 0;
+    for (i = 0; i < kv_size(source->nodes); i++) {
+        kv_push(t9_search_node_t *, path->nodes, kv_A(source->nodes, i));
+    }
+}
+
 t9_symbol_t *
 t9_path_flatten(const t9_path_t *const path) {
     t9_symbol_t *nodes_str;
     size_t length;
-    uint32_t i;
 
     if (path == NULL) {
         return NULL;
@@ -123,12 +144,27 @@ t9_path_flatten(const t9_path_t *const path) {
         return NULL;
     }
 
+    t9_path_write(path, nodes_str, kv_size(path->nodes) + 1);
+
+    return nodes_str;
+}
+
+t9_error_t
+t9_path_write(const t9_path_t *const path,
+              t9_symbol_t *const buffer,
+              size_t size) {
+    size_t i;
+
+    if (path == NULL || buffer == NULL || size < kv_size(path->nodes) + 1) {
+        return T9_FAILURE;
+    }
+
     for (i = 0; i < kv_size(path->nodes); ++i) {
-        nodes_str[i] = kv_A(path->nodes, i)->symbol;
+        buffer[i] = kv_A(path->nodes, i)->symbol;
     }
-    nodes_str[kv_size(path->nodes)] = 0;
+    buffer[kv_size(path->nodes)] = 0;
 
-    return nodes_str;
+    return T9_SUCCESS;
 }
 
 char *
@@ -0,0 +1,251 @@
+/*!
+  ******************************************************************************
+  * @file    pool.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements a pool of worker threads with work stealing.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/pool.h"
+
+bool
+__t9_pool_next(t9_pool_t *const pool,
+               size_t worker,
+               size_t *const index) {
+    t9_pool_queue_t *own;
+    t9_pool_queue_t *victim;
+    size_t begin;
+    size_t end;
+    size_t i;
+
+    // Take work from the front of the own range.
+    own = &pool->queues[worker];
+    pthread_mutex_lock(&own->lock);
+    if (own->begin < own->end) {
+        *index = own->begin++;
+        pthread_mutex_unlock(&own->lock);
+        return true;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // Steal half of the remaining work from the back of another workers range.
+    for (i = 1; i < pool->number_threads; i++) {
+        victim = &pool->queues[(worker + i) % pool->number_threads];
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->begin >= victim->end) {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        end = victim->end;
+        begin = end - (end - victim->begin + 1) / 2;
+        victim->end = begin;
+        pthread_mutex_unlock(&victim->lock);
+
+        // The stolen range is private until it is published as the own range.
+        pthread_mutex_lock(&own->lock);
+        own->begin = begin + 1;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+
+        *index = begin;
+        return true;
+    }
+
+    // No work left.
+    return false;
+}
+
+void *
+__t9_pool_worker(void *arg) {
+    t9_pool_queue_t *queue;
+    t9_pool_t *pool;
+    uint64_t generation;
+    size_t worker;
+    size_t index;
+
+    queue = (t9_pool_queue_t *) arg;
+    pool = queue->pool;
+    worker = (size_t) (queue - pool->queues);
+    generation = 0;
+
+    while (true) {
+        // Wait for a new job.
+        pthread_mutex_lock(&pool->lock);
+        while (pool->shutdown == false && pool->generation == generation) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown == true) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Process job items until there are none left.
+        while (__t9_pool_next(pool, worker, &index) == true) {
+            pool->task(worker, index, pool->arg);
+        }
+
+        // Report that this worker is done.
+        pthread_mutex_lock(&pool->lock);
+        pool->active--;
+        if (pool->active == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+t9_pool_t *
+t9_pool_create(uint16_t number_threads) {
+    t9_pool_t *pool;
+    long online;
+    uint16_t i;
+
+    if (number_threads == 0) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        number_threads = (uint16_t) (online < 1 ? 1 : (online > UINT16_MAX ? UINT16_MAX : online));
+    }
+
+    // Allocate memory.
+    pool = (t9_pool_t *) malloc(sizeof(t9_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(pool, 0, sizeof(t9_pool_t));
+
+    pool->threads = (pthread_t *) calloc(number_threads, sizeof(pthread_t));
+    pool->queues = (t9_pool_queue_t *) calloc(number_threads, sizeof(t9_pool_queue_t));
+    if (pool->threads == NULL || pool->queues == NULL) {
+        free(pool->threads);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Start the workers.
+    for (i = 0; i < number_threads; i++) {
+        pool->queues[i].pool = pool;
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+        if (pthread_create(&pool->threads[i], NULL, __t9_pool_worker, &pool->queues[i]) != 0) {
+            pthread_mutex_destroy(&pool->queues[i].lock);
+            break;
+        }
+        pool->number_threads++;
+    }
+
+    if (pool->number_threads != number_threads) {
+        t9_pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void
+t9_pool_destroy(t9_pool_t *const pool) {
+    uint16_t i;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    // Stop and join all workers.
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->number_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+
+    // Erase and free memory.
+    free(pool->threads);
+    free(pool->queues);
+    memset(pool, 0, sizeof(t9_pool_t));
+    free(pool);
+}
+
+t9_error_t
+t9_pool_run(t9_pool_t *const pool,
+            size_t count,
+            t9_pool_task_t task,
+            void *arg) {
+    size_t chunk;
+    size_t offset;
+    uint16_t i;
+
+    if (pool == NULL || task == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (count == 0) {
+        return T9_SUCCESS;
+    }
+
+    // Split the job items evenly between the workers.
+    offset = 0;
+    for (i = 0; i < pool->number_threads; i++) {
+        chunk = count / pool->number_threads + (i < count % pool->number_threads ? 1 : 0);
+        pthread_mutex_lock(&pool->queues[i].lock);
+        pool->queues[i].begin = offset;
+        pool->queues[i].end = offset + chunk;
+        pthread_mutex_unlock(&pool->queues[i].lock);
+        offset += chunk;
+    }
+
+    // Wake the workers and wait until all of them ran out of work.
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->active = pool->number_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return T9_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*!
+  ******************************************************************************
+  * @file    profile.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Hierarchical profiling zones.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include <string.h>
+
+#include "t9/profile.h"
+
+t9_profile_t t9_profile = {
+        .zones = {{.name = "root", .parent = T9_PROFILE_ROOT, .depth = 0}},
+        .number_zones = 1,
+        .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+_Thread_local t9_profile_stack_t t9_profile_stack;
+
+void
+t9_profile_begin(const char *const name) {
+    t9_profile_stack_t *stack;
+    uint32_t parent;
+    uint32_t zone;
+
+    stack = &t9_profile_stack;
+
+    // Once a zone is dropped, all zones nested into it are dropped as well.
+    if (stack->dropped > 0 || stack->depth == T9_PROFILE_MAX_DEPTH) {
+        stack->dropped++;
+        return;
+    }
+
+    parent = stack->depth > 0 ? stack->zones[stack->depth - 1] : T9_PROFILE_ROOT;
+    zone = __t9_profile_find(parent, name);
+    if (zone == T9_PROFILE_MAX_ZONES) {
+        stack->dropped++;
+        return;
+    }
+
+    stack->zones[stack->depth] = zone;
+    stack->starts[stack->depth] = t9_timer_cycles();
+    stack->depth++;
+}
+
+void
+t9_profile_end(void) {
+    t9_profile_stack_t *stack;
+    t9_profile_zone_t *zone;
+    uint64_t elapsed;
+    uint64_t max;
+
+    elapsed = t9_timer_cycles();
+    stack = &t9_profile_stack;
+    if (stack->dropped > 0) {
+        stack->dropped--;
+        return;
+    }
+    if (stack->depth == 0) {
+        return;
+    }
+
+    stack->depth--;
+    elapsed -= stack->starts[stack->depth];
+    zone = &t9_profile.zones[stack->zones[stack->depth]];
+
+    atomic_fetch_add_explicit(&zone->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&zone->total, elapsed, memory_order_relaxed);
+    max = atomic_load_explicit(&zone->max, memory_order_relaxed);
+    while (elapsed > max
+           && !atomic_compare_exchange_weak_explicit(&zone->max, &max, elapsed, memory_order_relaxed,
+                                                     memory_order_relaxed)) {
+    }
+}
+
+void
+t9_profile_reset(void) {
+    uint32_t number_zones;
+    uint32_t i;
+
+    number_zones = (uint32_t) atomic_load_explicit(&t9_profile.number_zones, memory_order_acquire);
+    for (i = 0; i < number_zones; i++) {
+        atomic_store_explicit(&t9_profile.zones[i].count, 0, memory_order_relaxed);
+        atomic_store_explicit(&t9_profile.zones[i].total, 0, memory_order_relaxed);
+        atomic_store_explicit(&t9_profile.zones[i].max, 0, memory_order_relaxed);
+    }
+}
+
+void
+t9_profile_write(FILE *const fp) {
+    uint32_t number_zones;
+    uint32_t i;
+    double cycles_per_ns;
+
+    if (fp == NULL) {
+        return;
+    }
+
+    number_zones = (uint32_t) atomic_load_explicit(&t9_profile.number_zones, memory_order_acquire);
+    if (number_zones <= 1) {
+        return;
+    }
+
+    cycles_per_ns = t9_timer_cycles_per_ns();
+    fprintf(fp, "%-40s %12s %12s %12s %12s %8s\n", "zone", "count", "total_ms", "mean_us", "max_us", "parent");
+    for (i = 1; i < number_zones; i++) {
+        if (t9_profile.zones[i].parent == T9_PROFILE_ROOT) {
+            __t9_profile_write_zone(fp, i, number_zones, cycles_per_ns);
+        }
+    }
+}
+
+uint32_t
+__t9_profile_find(uint32_t parent,
+                  const char *const name) {
+    t9_profile_zone_t *zone;
+    uint32_t number_zones;
+    uint32_t i;
+
+    // Names are literals, so comparing the pointers finds the zone of the same call site quickly.
+    number_zones = (uint32_t) atomic_load_explicit(&t9_profile.number_zones, memory_order_acquire);
+    for (i = 1; i < number_zones; i++) {
+        zone = &t9_profile.zones[i];
+        if (zone->parent == parent && (zone->name == name || strcmp(zone->name, name) == 0)) {
+            return i;
+        }
+    }
+
+    // Look again while holding the lock, another thread may have added the zone in the meantime.
+    pthread_mutex_lock(&t9_profile.lock);
+    number_zones = (uint32_t) atomic_load_explicit(&t9_profile.number_zones, memory_order_acquire);
+    for (; i < number_zones; i++) {
+        zone = &t9_profile.zones[i];
+        if (zone->parent == parent && strcmp(zone->name, name) == 0) {
+            pthread_mutex_unlock(&t9_profile.lock);
+            return i;
+        }
+    }
+    if (number_zones < T9_PROFILE_MAX_ZONES) {
+        zone = &t9_profile.zones[number_zones];
+        zone->name = name;
+        zone->parent = parent;
+        zone->depth = t9_profile.zones[parent].depth + 1;
+        atomic_store_explicit(&t9_profile.number_zones, number_zones + 1, memory_order_release);
+        i = number_zones;
+    } else {
+        i = T9_PROFILE_MAX_ZONES;
+    }
+    pthread_mutex_unlock(&t9_profile.lock);
+
+    return i;
+}
+
+void
+__t9_profile_write_zone(FILE *const fp,
+                        uint32_t index,
+                        uint32_t number_zones,
+                        double cycles_per_ns) {
+    const t9_profile_zone_t *zone;
+    uint64_t parent_total;
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+    uint32_t i;
+
+    zone = &t9_profile.zones[index];
+    count = atomic_load_explicit(&zone->count, memory_order_relaxed);
+    total = atomic_load_explicit(&zone->total, memory_order_relaxed);
+    max = atomic_load_explicit(&zone->max, memory_order_relaxed);
+    parent_total = atomic_load_explicit(&t9_profile.zones[zone->parent].total, memory_order_relaxed);
+
+    // The share of the parent is left empty for outermost zones.
+    fprintf(fp, "%*s%-*s %12lu %12.3f %12.3f %12.3f ", (int) (2 * (zone->depth - 1)), "",
+            (int) (40 - 2 * (zone->depth - 1)), zone->name, (unsigned long) count,
+            (double) total / cycles_per_ns / 1000000.0,
+            count > 0 ? (double) total / (double) count / cycles_per_ns / 1000.0 : 0.0,
+            (double) max / cycles_per_ns / 1000.0);
+    if (zone->parent != T9_PROFILE_ROOT && parent_total > 0) {
+        fprintf(fp, "%7.1f%%\n", 100.0 * (double) total / (double) parent_total);
+    } else {
+        fprintf(fp, "%8s\n", "");
+    }
+
+    for (i = index + 1; i < number_zones; i++) {
+        if (t9_profile.zones[i].parent == index) {
+            __t9_profile_write_zone(fp, i, number_zones, cycles_per_ns);
+        }
+    }
+}
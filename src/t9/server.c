@@ -0,0 +1,895 @@
+/*!
+  ******************************************************************************
+  * @file    server.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements a completion server on a Unix domain socket.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/server.h"
+
+t9_server_t *
+t9_server_create(const t9_model_t *const model,
+                 const char *const path,
+                 uint16_t number_threads,
+                 uint8_t number_suggestions,
+                 uint8_t number_completions) {
+    t9_server_t *server;
+    struct epoll_event event;
+    size_t i;
+
+    if (model == NULL || path == NULL || number_suggestions == 0) {
+        return NULL;
+    }
+
+    // Words can only be completed with a dictionary.
+    if (number_completions > 0 && model->dictionary == NULL) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    server = (t9_server_t *) malloc(sizeof(t9_server_t));
+    if (server == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(server, 0, sizeof(t9_server_t));
+    server->model = model;
+    server->number_suggestions = number_suggestions;
+    server->number_completions = number_completions;
+    server->listener = -1;
+    server->metrics_listener = -1;
+    server->epoll = -1;
+    server->wake = -1;
+    kv_init(server->connections);
+    kv_init(server->ready);
+
+    server->path = strdup(path);
+    server->pool = t9_pool_create(number_threads);
+    if (server->path == NULL || server->pool == NULL) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+
+    // Every worker records its metrics in a shard of its own.
+    server->metrics = (t9_metrics_t **) calloc(server->pool->number_threads, sizeof(t9_metrics_t *));
+    if (server->metrics == NULL) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+    for (i = 0; i < server->pool->number_threads; i++) {
+        server->metrics[i] = t9_metrics_create();
+        if (server->metrics[i] == NULL) {
+            t9_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    server->listener = __t9_server_listen(path);
+    if (server->listener < 0) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+
+    // The listening socket and the wake up event are told apart from connections by the address of their descriptor.
+    server->epoll = epoll_create1(EPOLL_CLOEXEC);
+    server->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->epoll < 0 || server->wake < 0) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = EPOLLIN;
+    event.data.ptr = &server->listener;
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event) != 0) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+
+    event.data.ptr = &server->wake;
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->wake, &event) != 0) {
+        t9_server_destroy(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+void
+t9_server_destroy(t9_server_t *const server) {
+    size_t i;
+
+    if (server == NULL) {
+        return;
+    }
+
+    while (kv_size(server->connections) > 0) {
+        __t9_server_connection_destroy(server, kv_last(server->connections));
+    }
+    kv_destroy(server->connections);
+    kv_destroy(server->ready);
+
+    if (server->listener >= 0) {
+        close(server->listener);
+        unlink(server->path);
+    }
+    if (server->metrics_listener >= 0) {
+        close(server->metrics_listener);
+        unlink(server->metrics_path);
+    }
+    if (server->epoll >= 0) {
+        close(server->epoll);
+    }
+    if (server->wake >= 0) {
+        close(server->wake);
+    }
+
+    if (server->metrics != NULL) {
+        for (i = 0; i < server->pool->number_threads; i++) {
+            t9_metrics_destroy(server->metrics[i]);
+        }
+        free(server->metrics);
+    }
+
+    t9_cache_destroy(server->cache);
+    t9_pool_destroy(server->pool);
+    free(server->path);
+    free(server->metrics_path);
+
+    // Erase and free memory.
+    memset(server, 0, sizeof(t9_server_t));
+    free(server);
+}
+
+t9_error_t
+t9_server_set_metrics(t9_server_t *const server,
+                      const char *const path) {
+    struct epoll_event event;
+
+    if (server == NULL || path == NULL || server->metrics_listener >= 0) {
+        return T9_FAILURE;
+    }
+
+    server->metrics_path = strdup(path);
+    if (server->metrics_path == NULL) {
+        return T9_FAILURE;
+    }
+
+    server->metrics_listener = __t9_server_listen(path);
+    if (server->metrics_listener < 0) {
+        return T9_FAILURE;
+    }
+
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = EPOLLIN;
+    event.data.ptr = &server->metrics_listener;
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->metrics_listener, &event) != 0) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_server_set_cache(t9_server_t *const server,
+                    size_t capacity) {
+    if (server == NULL || server->cache != NULL || server->number_speculated > 0 || capacity == 0) {
+        return T9_FAILURE;
+    }
+
+    server->cache = t9_cache_create(capacity);
+    if (server->cache == NULL) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_server_set_speculation(t9_server_t *const server,
+                          uint8_t number_keys) {
+    // Connections that exist already have no speculator.
+    if (server == NULL || server->cache != NULL || kv_size(server->connections) > 0 || number_keys == 0
+        || number_keys > NUM_LEXICON_SYMBOLS) {
+        return T9_FAILURE;
+    }
+
+    server->number_speculated = number_keys;
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_server_run(t9_server_t *const server) {
+    struct epoll_event events[T9_SERVER_MAX_EVENTS];
+    t9_server_connection_t *connection;
+    uint64_t value;
+    ssize_t received;
+    int number_events;
+    int i;
+    size_t j;
+    size_t k;
+
+    if (server == NULL) {
+        return T9_FAILURE;
+    }
+
+    server->running = true;
+    while (server->running) {
+        number_events = epoll_wait(server->epoll, events, T9_SERVER_MAX_EVENTS, -1);
+        if (number_events < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return T9_FAILURE;
+        }
+
+        // Collect the connections that received complete requests.
+        kv_size(server->ready) = 0;
+        for (i = 0; i < number_events; i++) {
+            if (events[i].data.ptr == &server->listener) {
+                if (__t9_server_accept(server) != T9_SUCCESS) {
+                    return T9_FAILURE;
+                }
+                continue;
+            }
+
+            if (events[i].data.ptr == &server->metrics_listener) {
+                __t9_server_report(server);
+                continue;
+            }
+
+            if (events[i].data.ptr == &server->wake) {
+                received = read(server->wake, &value, sizeof(uint64_t));
+                (void) received;
+                server->running = false;
+                continue;
+            }
+
+            connection = (t9_server_connection_t *) events[i].data.ptr;
+            if ((events[i].events & EPOLLOUT) != 0 && __t9_server_send(connection) != T9_SUCCESS) {
+                __t9_server_connection_destroy(server, connection);
+                continue;
+            }
+
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0
+                && __t9_server_receive(connection) != T9_SUCCESS) {
+                __t9_server_connection_destroy(server, connection);
+                continue;
+            }
+
+            // Requests held back by unsent responses are answered once the client received enough of them.
+            if (__t9_server_is_pending(connection) == true) {
+                kv_push(t9_server_connection_t *, server->ready, connection);
+            } else if (__t9_server_watch(server, connection) != T9_SUCCESS) {
+                __t9_server_connection_destroy(server, connection);
+            }
+        }
+
+        while (kv_size(server->ready) > 0) {
+            // Decode the requests, a single connection is not worth waking up the pool.
+            if (kv_size(server->ready) == 1) {
+                __t9_server_task(0, 0, server);
+            } else if (t9_pool_run(server->pool, kv_size(server->ready), __t9_server_task, server) != T9_SUCCESS) {
+                return T9_FAILURE;
+            }
+
+            // Send the responses. Connections that still hold requests after the client received them are decoded
+            // again, the others wait for the event loop.
+            k = 0;
+            for (j = 0; j < kv_size(server->ready); j++) {
+                connection = kv_A(server->ready, j);
+                server->number_requests += connection->handled;
+                if (__t9_server_send(connection) != T9_SUCCESS) {
+                    __t9_server_connection_destroy(server, connection);
+                    continue;
+                }
+                if (__t9_server_is_pending(connection) == true) {
+                    kv_A(server->ready, k++) = connection;
+                    continue;
+                }
+                if (__t9_server_watch(server, connection) != T9_SUCCESS) {
+                    __t9_server_connection_destroy(server, connection);
+                }
+            }
+            kv_size(server->ready) = k;
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+void
+t9_server_stop(t9_server_t *const server) {
+    uint64_t value;
+    ssize_t written;
+
+    if (server == NULL) {
+        return;
+    }
+
+    // Only write is used here, which is async-signal-safe.
+    value = 1;
+    written = write(server->wake, &value, sizeof(uint64_t));
+    (void) written;
+}
+
+int
+__t9_server_listen(const char *const path) {
+    struct sockaddr_un address;
+    int listener;
+
+    if (strlen(path) == 0 || strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+
+    // Replace the socket file of an earlier server.
+    memset(&address, 0, sizeof(struct sockaddr_un));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, strlen(path));
+    unlink(path);
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        return -1;
+    }
+
+    if (bind(listener, (const struct sockaddr *) &address, sizeof(struct sockaddr_un)) != 0
+        || listen(listener, T9_SERVER_BACKLOG) != 0) {
+        close(listener);
+        return -1;
+    }
+
+    return listener;
+}
+
+void
+__t9_server_report(const t9_server_t *const server) {
+    const t9_server_connection_t *connection;
+    const t9_session_t *session;
+    t9_cache_stats_t cache_stats;
+    size_t tree_bytes;
+    size_t path_bytes;
+    size_t buffer_bytes;
+    size_t i;
+    size_t j;
+    FILE *stream;
+    int client;
+
+    // The workers are idle while the event loop runs, so the sessions can be inspected.
+    tree_bytes = 0;
+    path_bytes = 0;
+    buffer_bytes = 0;
+    for (i = 0; i < kv_size(server->connections); i++) {
+        connection = kv_A(server->connections, i);
+        session = connection->session;
+        for (j = 0; j < kv_size(session->search_tree->level_table2); j++) {
+            tree_bytes += list_size(kv_A(session->search_tree->level_table2, j))
+                          * (sizeof(t9_search_node_t) + 2 * sizeof(list_node_t));
+        }
+        for (j = 0; j < kv_size(session->paths); j++) {
+            path_bytes += sizeof(t9_path_t) + kv_max(kv_A(session->paths, j)->nodes) * sizeof(t9_search_node_t *);
+        }
+        buffer_bytes += kv_max(connection->input) + kv_max(connection->output) + kv_max(connection->suggestions)
+                        + kv_max(connection->keys) + kv_max(connection->word);
+    }
+
+    // The workers count the hits and misses of the cache in their shards, the cache itself holds the rest.
+    memset(&cache_stats, 0, sizeof(t9_cache_stats_t));
+    t9_cache_stats(server->cache, &cache_stats);
+
+    for (;;) {
+        client = accept4(server->metrics_listener, NULL, NULL, SOCK_CLOEXEC);
+        if (client < 0) {
+            return;
+        }
+
+        stream = fdopen(client, "w");
+        if (stream == NULL) {
+            close(client);
+            continue;
+        }
+
+        t9_metrics_write(server->metrics, server->pool->number_threads, stream);
+        fprintf(stream, "# TYPE t9_server_connections gauge\nt9_server_connections %zu\n",
+                kv_size(server->connections));
+        fprintf(stream, "# TYPE t9_server_requests_total counter\nt9_server_requests_total %lu\n",
+                (unsigned long) server->number_requests);
+        fprintf(stream, "# TYPE t9_memory_bytes gauge\n");
+        fprintf(stream, "t9_memory_bytes{structure=\"search_tree\"} %zu\n", tree_bytes);
+        fprintf(stream, "t9_memory_bytes{structure=\"paths\"} %zu\n", path_bytes);
+        fprintf(stream, "t9_memory_bytes{structure=\"buffers\"} %zu\n", buffer_bytes);
+        fprintf(stream, "t9_memory_bytes{structure=\"cache\"} %zu\n", cache_stats.memory);
+        fprintf(stream, "# TYPE t9_cache_entries gauge\nt9_cache_entries %zu\n", cache_stats.number_entries);
+        fprintf(stream, "# TYPE t9_cache_evictions_total counter\nt9_cache_evictions_total %lu\n",
+                (unsigned long) cache_stats.evictions);
+        fclose(stream);
+    }
+}
+
+t9_error_t
+__t9_server_accept(t9_server_t *const server) {
+    int client;
+
+    for (;;) {
+        client = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // No more pending connections, or the connection is not acceptable right now.
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EMFILE
+                || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                return T9_SUCCESS;
+            }
+            return T9_FAILURE;
+        }
+
+        // A connection that can not be created is closed again.
+        __t9_server_connection_create(server, client);
+    }
+}
+
+t9_error_t
+__t9_server_receive(t9_server_connection_t *const connection) {
+    ssize_t received;
+    uint32_t size;
+
+    // Bytes beyond the limit stay in the socket until the buffered requests are answered.
+    while (kv_size(connection->input) < T9_SERVER_MAX_BUFFERED) {
+        if (kv_max(connection->input) - kv_size(connection->input) < T9_SERVER_READ_SIZE) {
+            kv_resize(uint8_t, connection->input, kv_size(connection->input) * 2 + T9_SERVER_READ_SIZE);
+            if (connection->input.a == NULL) {
+                return T9_FAILURE;
+            }
+        }
+
+        received = read(connection->socket,
+                        &connection->input.a[kv_size(connection->input)],
+                        kv_max(connection->input) - kv_size(connection->input));
+        if (received > 0) {
+            kv_size(connection->input) += (size_t) received;
+            continue;
+        }
+        if (received == 0) {
+            // The client sent its last request, the buffered ones are still answered.
+            connection->closing = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return T9_FAILURE;
+    }
+
+    // Reject requests that are too large.
+    if (kv_size(connection->input) >= sizeof(uint32_t)) {
+        memcpy(&size, connection->input.a, sizeof(uint32_t));
+        if (size > T9_SERVER_MAX_REQUEST) {
+            return T9_FAILURE;
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_server_send(t9_server_connection_t *const connection) {
+    ssize_t sent;
+
+    while (connection->written < kv_size(connection->output)) {
+        sent = send(connection->socket,
+                    &connection->output.a[connection->written],
+                    kv_size(connection->output) - connection->written,
+                    MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->written += (size_t) sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Continue once the socket accepts more bytes.
+            return T9_SUCCESS;
+        }
+        return T9_FAILURE;
+    }
+
+    kv_size(connection->output) = 0;
+    connection->written = 0;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_server_watch(t9_server_t *const server,
+                  t9_server_connection_t *const connection) {
+    struct epoll_event event;
+    uint32_t events;
+
+    // A closing connection is finished once all answers are sent.
+    if (connection->closing == true && connection->written == kv_size(connection->output)) {
+        return T9_FAILURE;
+    }
+
+    events = 0;
+    if (connection->closing == false && kv_size(connection->input) < T9_SERVER_MAX_BUFFERED
+        && kv_size(connection->output) - connection->written < T9_SERVER_MAX_BUFFERED) {
+        events |= EPOLLIN;
+    }
+    if (connection->written < kv_size(connection->output)) {
+        events |= EPOLLOUT;
+    }
+
+    if (events != connection->events) {
+        memset(&event, 0, sizeof(struct epoll_event));
+        event.events = events;
+        event.data.ptr = connection;
+        if (epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->socket, &event) != 0) {
+            return T9_FAILURE;
+        }
+        connection->events = events;
+    }
+
+    return T9_SUCCESS;
+}
+
+bool
+__t9_server_is_pending(const t9_server_connection_t *const connection) {
+    uint32_t size;
+
+    if (kv_size(connection->input) < sizeof(uint32_t)
+        || kv_size(connection->output) - connection->written >= T9_SERVER_MAX_BUFFERED) {
+        return false;
+    }
+
+    memcpy(&size, connection->input.a, sizeof(uint32_t));
+    return size <= T9_SERVER_MAX_REQUEST && kv_size(connection->input) - sizeof(uint32_t) >= size;
+}
+
+void
+__t9_server_task(size_t worker,
+                 size_t index,
+                 void *arg) {
+    const t9_server_t *server;
+    t9_server_connection_t *connection;
+    size_t offset;
+    uint32_t size;
+
+    server = (const t9_server_t *) arg;
+    connection = kv_A(server->ready, index);
+    t9_session_set_metrics(connection->session, server->metrics[worker]);
+
+    // Move the unsent responses to the front, so the output does not grow while the client reads slowly.
+    memmove(connection->output.a, &connection->output.a[connection->written],
+            kv_size(connection->output) - connection->written);
+    kv_size(connection->output) -= connection->written;
+    connection->written = 0;
+
+    // Answer the complete requests in order.
+    connection->handled = 0;
+    offset = 0;
+    while (kv_size(connection->input) - offset >= sizeof(uint32_t)
+           && kv_size(connection->output) < T9_SERVER_MAX_BUFFERED) {
+        memcpy(&size, &connection->input.a[offset], sizeof(uint32_t));
+        if (size > T9_SERVER_MAX_REQUEST || kv_size(connection->input) - offset - sizeof(uint32_t) < size) {
+            break;
+        }
+
+        __t9_server_handle(server, connection, &connection->input.a[offset + sizeof(uint32_t)], size);
+        offset += sizeof(uint32_t) + size;
+        connection->handled++;
+    }
+
+    // Keep the beginning of the next request.
+    memmove(connection->input.a, &connection->input.a[offset], kv_size(connection->input) - offset);
+    kv_size(connection->input) -= offset;
+}
+
+t9_error_t
+__t9_server_handle(const t9_server_t *const server,
+                   t9_server_connection_t *const connection,
+                   const uint8_t *const request,
+                   uint32_t size) {
+    t9_symbol_t sequence[T9_SERVER_MAX_REQUEST];
+    size_t number_keys;
+    size_t typed;
+    size_t stride;
+    size_t count;
+
+    connection->number_completions = 0;
+    if (size == 0) {
+        return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+    }
+
+    switch (request[0]) {
+        case T9_SERVER_RESET:
+            if (__t9_server_reset(connection) != T9_SUCCESS) {
+                return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+            }
+            return __t9_server_respond(connection, T9_SERVER_OK, 0);
+
+        case T9_SERVER_TYPE:
+            // Validate the keys before anything is typed.
+            number_keys = size - 1;
+            memcpy(sequence, &request[1], number_keys);
+            sequence[number_keys] = 0;
+            if (number_keys == 0 || kv_size(connection->keys) + number_keys > UINT16_MAX
+                || strlen((const char *) sequence) != number_keys
+                || t9_corpus_validate_lexicon_symbols(sequence) == false) {
+                return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+            }
+
+            // A session that failed to decode may be inconsistent, so it starts over.
+            typed = kv_size(connection->keys);
+            __t9_server_append(&connection->keys, sequence, number_keys + 1);
+            kv_size(connection->keys)--;
+            if (__t9_server_type(server, connection, sequence, typed) != T9_SUCCESS) {
+                __t9_server_reset(connection);
+                return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+            }
+            if (__t9_server_complete(server, connection, sequence) != T9_SUCCESS) {
+                return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+            }
+
+            stride = kv_size(connection->keys) + 1;
+            if (kv_max(connection->suggestions) < server->number_suggestions * stride) {
+                kv_resize(uint8_t, connection->suggestions, server->number_suggestions * stride);
+                if (connection->suggestions.a == NULL) {
+                    return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+                }
+            }
+            if (connection->speculator != NULL) {
+                if (t9_speculator_nbest(connection->speculator, connection->suggestions.a, stride, connection->scores,
+                                        server->number_suggestions, &count) != T9_SUCCESS) {
+                    return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+                }
+            } else if (t9_session_nbest(connection->session, connection->suggestions.a, stride, connection->scores,
+                                        server->number_suggestions, &count) != T9_SUCCESS) {
+                return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+            }
+            return __t9_server_respond(connection, T9_SERVER_OK, count);
+
+        default:
+            return __t9_server_respond(connection, T9_SERVER_ERROR, 0);
+    }
+}
+
+t9_error_t
+__t9_server_type(const t9_server_t *const server,
+                 t9_server_connection_t *const connection,
+                 const t9_symbol_t *const sequence,
+                 size_t typed) {
+    const t9_symbol_t *key;
+
+    // The whole sequence typed since the last reset is the key of the cached states.
+    if (server->cache != NULL) {
+        return t9_cache_type(server->cache, connection->session, connection->keys.a, typed);
+    }
+
+    if (connection->speculator == NULL) {
+        return t9_session_type(connection->session, sequence);
+    }
+
+    // Keys that were speculated on are adopted instead of decoded.
+    for (key = sequence; *key != 0; key++) {
+        if (t9_speculator_insert(connection->speculator, *key, 0.0, NULL) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_server_reset(t9_server_connection_t *const connection) {
+    kv_size(connection->keys) = 0;
+    kv_size(connection->word) = 0;
+
+    if (connection->speculator != NULL) {
+        return t9_speculator_reset(connection->speculator);
+    }
+
+    return t9_session_reset(connection->session);
+}
+
+t9_error_t
+__t9_server_complete(const t9_server_t *const server,
+                     t9_server_connection_t *const connection,
+                     const t9_symbol_t *const sequence) {
+    const t9_symbol_t *key;
+
+    if (server->number_completions == 0) {
+        return T9_SUCCESS;
+    }
+
+    // The word starts over after every separator.
+    for (key = sequence; *key != 0; key++) {
+        if (strchr(T9_DICTIONARY_SEPARATORS, *key) != NULL) {
+            kv_size(connection->word) = 0;
+        } else {
+            kv_push(uint8_t, connection->word, *key);
+        }
+    }
+    kv_push(uint8_t, connection->word, 0);
+    kv_size(connection->word)--;
+
+    // Nothing is completed before the first key of a word.
+    if (kv_size(connection->word) == 0) {
+        return T9_SUCCESS;
+    }
+
+    if (t9_dictionary_complete(server->model->dictionary, connection->word.a, &connection->completions,
+                               &connection->number_completions) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+    if (connection->number_completions > server->number_completions) {
+        connection->number_completions = server->number_completions;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+__t9_server_respond(t9_server_connection_t *const connection,
+                    uint8_t status,
+                    size_t count) {
+    uint32_t size;
+    uint16_t length;
+    uint16_t word_length;
+    uint8_t number;
+    size_t i;
+
+    length = (uint16_t) kv_size(connection->keys);
+    number = (uint8_t) count;
+    size = (uint32_t) (3 * sizeof(uint8_t) + count * (sizeof(float) + sizeof(uint16_t) + length));
+    for (i = 0; i < connection->number_completions; i++) {
+        size += (uint32_t) (sizeof(uint16_t) + (uint16_t) strlen((const char *) connection->completions[i]->word));
+    }
+
+    __t9_server_append(&connection->output, &size, sizeof(uint32_t));
+    __t9_server_append(&connection->output, &status, sizeof(uint8_t));
+    __t9_server_append(&connection->output, &number, sizeof(uint8_t));
+    for (i = 0; i < count; i++) {
+        __t9_server_append(&connection->output, &connection->scores[i], sizeof(float));
+        __t9_server_append(&connection->output, &length, sizeof(uint16_t));
+        __t9_server_append(&connection->output, &connection->suggestions.a[i * (length + 1)], length);
+    }
+
+    number = (uint8_t) connection->number_completions;
+    __t9_server_append(&connection->output, &number, sizeof(uint8_t));
+    for (i = 0; i < connection->number_completions; i++) {
+        word_length = (uint16_t) strlen((const char *) connection->completions[i]->word);
+        __t9_server_append(&connection->output, &word_length, sizeof(uint16_t));
+        __t9_server_append(&connection->output, connection->completions[i]->word, word_length);
+    }
+
+    return status == T9_SERVER_OK ? T9_SUCCESS : T9_FAILURE;
+}
+
+void
+__t9_server_append(t9_server_buffer_t *const buffer,
+                   const void *const data,
+                   size_t size) {
+    if (kv_size(*buffer) + size > kv_max(*buffer)) {
+        kv_resize(uint8_t, *buffer, kv_size(*buffer) * 2 + size);
+    }
+
+    memcpy(&buffer->a[kv_size(*buffer)], data, size);
+    kv_size(*buffer) += size;
+}
+
+t9_server_connection_t *
+__t9_server_connection_create(t9_server_t *const server,
+                              int socket) {
+    t9_server_connection_t *connection;
+    struct epoll_event event;
+
+    // Allocate memory.
+    connection = (t9_server_connection_t *) malloc(sizeof(t9_server_connection_t));
+    if (connection == NULL) {
+        close(socket);
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(connection, 0, sizeof(t9_server_connection_t));
+    connection->socket = socket;
+    kv_init(connection->input);
+    kv_init(connection->output);
+    kv_init(connection->suggestions);
+    kv_init(connection->keys);
+    kv_init(connection->word);
+
+    // From here on the connection is destroyed as a whole on failure.
+    connection->index = kv_size(server->connections);
+    kv_push(t9_server_connection_t *, server->connections, connection);
+
+    connection->session = t9_session_create(server->model);
+    connection->scores = (float *) malloc(sizeof(float) * server->number_suggestions);
+    if (connection->session == NULL || connection->scores == NULL) {
+        __t9_server_connection_destroy(server, connection);
+        return NULL;
+    }
+
+    if (server->number_speculated > 0) {
+        connection->speculator = t9_speculator_create(connection->session, server->number_speculated);
+        if (connection->speculator == NULL) {
+            __t9_server_connection_destroy(server, connection);
+            return NULL;
+        }
+    }
+
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+        __t9_server_connection_destroy(server, connection);
+        return NULL;
+    }
+    connection->events = EPOLLIN;
+
+    return connection;
+}
+
+void
+__t9_server_connection_destroy(t9_server_t *const server,
+                               t9_server_connection_t *const connection) {
+    t9_server_connection_t *last;
+
+    if (connection == NULL) {
+        return;
+    }
+
+    // Move the last connection into the place of the connection.
+    last = kv_last(server->connections);
+    kv_A(server->connections, connection->index) = last;
+    last->index = connection->index;
+    kv_size(server->connections)--;
+
+    // Closing the socket also removes it from the event loop. The speculator is joined before its session is gone.
+    close(connection->socket);
+    t9_speculator_destroy(connection->speculator);
+    t9_session_destroy(connection->session);
+    kv_destroy(connection->input);
+    kv_destroy(connection->output);
+    kv_destroy(connection->suggestions);
+    kv_destroy(connection->keys);
+    kv_destroy(connection->word);
+    free(connection->scores);
+
+    // Erase and free memory.
+    memset(connection, 0, sizeof(t9_server_connection_t));
+    free(connection);
+}
@@ -0,0 +1,1044 @@
+/*!
+  ******************************************************************************
+  * @file    session.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements decoding sessions on top of a shared T9 model.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/session.h"
+
+t9_session_t *
+t9_session_create(const t9_model_t *const model) {
+    t9_session_t *session;
+
+    if (model == NULL || model->corpus_tree == NULL) {
+        return NULL;
+    }
+
+    // The corpus tree has to hold the ngrams of both passes.
+    if (model->ngram_length > model->corpus_tree->ngram_length
+        || model->rescore_length > model->corpus_tree->ngram_length) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    session = (t9_session_t *) malloc(sizeof(t9_session_t));
+    if (session == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(session, 0, sizeof(t9_session_t));
+    session->model = model;
+
+    // Initialize list of the best paths.
+    kv_init(session->paths);
+
+    // Initialize the released structures and the scratch buffers.
+    kv_init(session->free_nodes);
+    kv_init(session->free_levels);
+    kv_init(session->free_paths);
+    kv_init(session->leaves);
+    kv_init(session->scratch);
+
+    // Initialize the search tree.
+    session->search_tree = t9_search_tree_create();
+    if (session->search_tree == NULL) {
+        t9_session_destroy(session);
+        return NULL;
+    }
+
+    // Initialize the lattice of the Viterbi decoder.
+    if (model->decoder == T9_DECODER_VITERBI) {
+        session->lattice = t9_viterbi_lattice_create(model->viterbi);
+        if (session->lattice == NULL) {
+            t9_session_destroy(session);
+            return NULL;
+        }
+    }
+
+    // Initialize the A* decoder.
+    if (model->decoder == T9_DECODER_ASTAR) {
+        session->astar = t9_astar_create(model->viterbi);
+        if (session->astar == NULL) {
+            t9_session_destroy(session);
+            return NULL;
+        }
+    }
+
+    return session;
+}
+
+void
+t9_session_destroy(t9_session_t *const session) {
+    list_node_t *entry;
+    uint32_t i;
+
+    if (session == NULL) {
+        return;
+    }
+
+    // Destroy single paths entries.
+    for (i = 0; i < kv_size(session->paths); i++) {
+        t9_path_destroy(kv_A(session->paths, i));
+    }
+
+    // Destroy the vector containing paths.
+    kv_destroy(session->paths);
+
+    // Destroy search tree.
+    if (session->search_tree != NULL) {
+        t9_search_tree_destroy(session->search_tree);
+    }
+
+    // Destroy lattice.
+    if (session->lattice != NULL) {
+        t9_viterbi_lattice_destroy(session->lattice);
+    }
+
+    // Destroy A* decoder.
+    if (session->astar != NULL) {
+        t9_astar_destroy(session->astar);
+    }
+
+    // Destroy the released structures and the scratch buffers.
+    for (i = 0; i < kv_size(session->free_nodes); i++) {
+        t9_search_node_destroy(kv_A(session->free_nodes, i));
+    }
+    kv_destroy(session->free_nodes);
+    while (session->free_entries != NULL) {
+        entry = session->free_entries;
+        session->free_entries = entry->next;
+        free(entry);
+    }
+    for (i = 0; i < kv_size(session->free_levels); i++) {
+        list_destroy(kv_A(session->free_levels, i));
+    }
+    kv_destroy(session->free_levels);
+    for (i = 0; i < kv_size(session->free_paths); i++) {
+        t9_path_destroy(kv_A(session->free_paths, i));
+    }
+    kv_destroy(session->free_paths);
+    kv_destroy(session->leaves);
+    kv_destroy(session->scratch);
+
+    // Erase and free the memory.
+    memset(session, 0, sizeof(t9_session_t));
+    free(session);
+}
+
+t9_session_t *
+t9_session_clone(const t9_session_t *const session) {
+    t9_session_t *clone;
+    t9_search_node_t *node;
+    t9_path_t *path;
+    uint32_t i;
+    uint32_t j;
+
+    if (session == NULL) {
+        return NULL;
+    }
+
+    clone = t9_session_create(session->model);
+    if (clone == NULL) {
+        return NULL;
+    }
+    clone->output = session->output;
+    clone->output_arg = session->output_arg;
+    clone->committed = session->committed;
+
+    // Replace the state of the decoder in use by a copy.
+    if (session->lattice != NULL) {
+        t9_viterbi_lattice_destroy(clone->lattice);
+        clone->lattice = t9_viterbi_lattice_clone(session->lattice);
+        if (clone->lattice == NULL) {
+            t9_session_destroy(clone);
+            return NULL;
+        }
+    }
+
+    if (session->astar != NULL) {
+        t9_astar_destroy(clone->astar);
+        clone->astar = t9_astar_clone(session->astar);
+        if (clone->astar == NULL) {
+            t9_session_destroy(clone);
+            return NULL;
+        }
+    }
+
+    t9_search_tree_destroy(clone->search_tree);
+    clone->search_tree = t9_search_tree_clone(session->search_tree);
+    if (clone->search_tree == NULL) {
+        t9_session_destroy(clone);
+        return NULL;
+    }
+
+    // Siblings never share a symbol, so the nodes of a path are found in the copied tree by their symbols.
+    for (i = 0; i < kv_size(session->paths); i++) {
+        path = t9_path_create();
+        if (path == NULL) {
+            t9_session_destroy(clone);
+            return NULL;
+        }
+        path->probability = kv_A(session->paths, i)->probability;
+        kv_push(t9_path_t *, clone->paths, path);
+
+        node = clone->search_tree->root;
+        for (j = 0; j < kv_size(kv_A(session->paths, i)->nodes) && node != NULL; j++) {
+            node = t9_search_node_get_child(node, kv_A(kv_A(session->paths, i)->nodes, j)->symbol);
+            t9_path_push(path, node);
+        }
+        if (node == NULL) {
+            t9_session_destroy(clone);
+            return NULL;
+        }
+    }
+
+    return clone;
+}
+
+t9_error_t
+t9_session_serialize(const t9_session_t *const session,
+                     uint8_t **state,
+                     size_t *const size) {
+    t9_session_state_t header;
+    t9_session_state_node_t *nodes;
+    t9_session_state_path_t *paths;
+    uint32_t number;
+    size_t i;
+
+    if (session == NULL || state == NULL || size == NULL) {
+        return T9_FAILURE;
+    }
+
+    memset(&header, 0, sizeof(t9_session_state_t));
+    header.decoder = session->model->decoder;
+    header.committed = session->committed;
+
+    // The lattice is stored as its entries.
+    if (session->lattice != NULL) {
+        header.number_entries = (uint32_t) kv_size(session->lattice->entries);
+        header.column = session->lattice->column;
+        header.length = session->lattice->length;
+
+        *size = sizeof(t9_session_state_t) + header.number_entries * sizeof(t9_viterbi_entry_t);
+        *state = (uint8_t *) malloc(*size);
+        if (*state == NULL) {
+            return T9_FAILURE;
+        }
+        memcpy(*state, &header, sizeof(t9_session_state_t));
+        memcpy(*state + sizeof(t9_session_state_t), session->lattice->entries.a,
+               header.number_entries * sizeof(t9_viterbi_entry_t));
+        return T9_SUCCESS;
+    }
+
+    // The A* decoder is stored as its nodes followed by its keys.
+    if (session->astar != NULL) {
+        header.number_entries = (uint32_t) kv_size(session->astar->nodes);
+        header.number_keys = (uint32_t) kv_size(session->astar->keys);
+        header.length = session->astar->expanded;
+        header.best = session->astar->best;
+
+        *size = sizeof(t9_session_state_t) + header.number_entries * sizeof(t9_astar_node_t) + header.number_keys;
+        *state = (uint8_t *) malloc(*size);
+        if (*state == NULL) {
+            return T9_FAILURE;
+        }
+        memcpy(*state, &header, sizeof(t9_session_state_t));
+        memcpy(*state + sizeof(t9_session_state_t), session->astar->nodes.a,
+               header.number_entries * sizeof(t9_astar_node_t));
+        memcpy(*state + sizeof(t9_session_state_t) + header.number_entries * sizeof(t9_astar_node_t),
+               session->astar->keys.a, header.number_keys);
+        return T9_SUCCESS;
+    }
+
+    // The search tree is stored as its nodes, every node but the root is registered on a level.
+    header.number_levels = (uint32_t) kv_size(session->search_tree->level_table2);
+    header.number_nodes = 1;
+    for (i = 0; i < kv_size(session->search_tree->level_table2); i++) {
+        header.number_nodes += kv_A(session->search_tree->level_table2, i)->len;
+    }
+    header.number_paths = (uint32_t) kv_size(session->paths);
+
+    *size = sizeof(t9_session_state_t)
+            + header.number_nodes * sizeof(t9_session_state_node_t)
+            + header.number_paths * sizeof(t9_session_state_path_t);
+    *state = (uint8_t *) malloc(*size);
+    if (*state == NULL) {
+        return T9_FAILURE;
+    }
+    memcpy(*state, &header, sizeof(t9_session_state_t));
+    nodes = (t9_session_state_node_t *) (*state + sizeof(t9_session_state_t));
+    paths = (t9_session_state_path_t *) (nodes + header.number_nodes);
+
+    // Paths are stored by their leaves, which are found while the tree is serialized.
+    for (i = 0; i < header.number_paths; i++) {
+        paths[i].probability = kv_A(session->paths, i)->probability;
+        paths[i].leaf = T9_SESSION_NO_NODE;
+    }
+
+    number = 0;
+    __t9_session_serialize_node(session, session->search_tree->root, T9_SESSION_NO_NODE, 0, nodes, paths, &number);
+
+    for (i = 0; i < header.number_paths; i++) {
+        if (paths[i].leaf == T9_SESSION_NO_NODE) {
+            free(*state);
+            *state = NULL;
+            return T9_FAILURE;
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_deserialize(t9_session_t *const session,
+                       const uint8_t *const state,
+                       size_t size) {
+    t9_session_state_t header;
+    const uint8_t *records;
+    t9_viterbi_entry_t *entry;
+    t9_astar_node_t *node;
+    uint32_t *depths;
+    t9_error_t error;
+    size_t i;
+
+    if (session == NULL || state == NULL || size < sizeof(t9_session_state_t)) {
+        return T9_FAILURE;
+    }
+
+    if (t9_session_reset(session) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    memcpy(&header, state, sizeof(t9_session_state_t));
+    if (header.decoder != session->model->decoder) {
+        return T9_FAILURE;
+    }
+    records = state + sizeof(t9_session_state_t);
+
+    if (session->lattice != NULL) {
+        if (size != sizeof(t9_session_state_t) + header.number_entries * sizeof(t9_viterbi_entry_t)
+            || header.number_entries == 0 || header.column >= header.number_entries) {
+            return T9_FAILURE;
+        }
+
+        kv_resize(t9_viterbi_entry_t, session->lattice->entries, header.number_entries);
+        memcpy(session->lattice->entries.a, records, header.number_entries * sizeof(t9_viterbi_entry_t));
+        kv_size(session->lattice->entries) = header.number_entries;
+
+        depths = (uint32_t *) malloc(header.number_entries * sizeof(uint32_t));
+        if (depths == NULL) {
+            t9_session_reset(session);
+            return T9_FAILURE;
+        }
+
+        // Entries must not refer to states or entries that do not exist. Only the first entry starts a hypothesis and
+        // every hypothesis of the last key is as long as the sequence, so tracing it back stays within the entries.
+        for (i = 0; i < header.number_entries; i++) {
+            entry = &kv_A(session->lattice->entries, i);
+            if (entry->state >= session->lattice->viterbi->number_states
+                || (i == 0) != (entry->previous == T9_VITERBI_NO_ENTRY)
+                || (i > 0 && entry->previous >= i)) {
+                free(depths);
+                t9_session_reset(session);
+                return T9_FAILURE;
+            }
+            depths[i] = i == 0 ? 0 : depths[entry->previous] + 1;
+            if (depths[i] > header.length || (i >= header.column) != (depths[i] == header.length)) {
+                free(depths);
+                t9_session_reset(session);
+                return T9_FAILURE;
+            }
+        }
+        free(depths);
+        session->lattice->column = (size_t) header.column;
+        session->lattice->length = (size_t) header.length;
+        session->committed = (size_t) header.committed;
+        return T9_SUCCESS;
+    }
+
+    if (session->astar != NULL) {
+        if (size != sizeof(t9_session_state_t) + header.number_entries * sizeof(t9_astar_node_t) + header.number_keys
+            || (header.best != T9_VITERBI_NO_ENTRY && header.best >= header.number_entries)) {
+            return T9_FAILURE;
+        }
+
+        kv_resize(t9_astar_node_t, session->astar->nodes, header.number_entries);
+        memcpy(session->astar->nodes.a, records, header.number_entries * sizeof(t9_astar_node_t));
+        kv_size(session->astar->nodes) = header.number_entries;
+        kv_resize(t9_symbol_t, session->astar->keys, header.number_keys);
+        memcpy(session->astar->keys.a, records + header.number_entries * sizeof(t9_astar_node_t), header.number_keys);
+        kv_size(session->astar->keys) = header.number_keys;
+
+        // Nodes must not refer to nodes that do not exist and keys must be lexicon indices.
+        for (i = 0; i < header.number_entries; i++) {
+            node = &kv_A(session->astar->nodes, i);
+            if (node->previous != T9_VITERBI_NO_ENTRY && node->previous >= i) {
+                t9_session_reset(session);
+                return T9_FAILURE;
+            }
+        }
+        for (i = 0; i < header.number_keys; i++) {
+            if (kv_A(session->astar->keys, i) >= NUM_LEXICON_SYMBOLS) {
+                t9_session_reset(session);
+                return T9_FAILURE;
+            }
+        }
+        session->astar->expanded = (size_t) header.length;
+        session->astar->best = (uint32_t) header.best;
+        session->committed = (size_t) header.committed;
+        return T9_SUCCESS;
+    }
+
+    if (size != sizeof(t9_session_state_t)
+                + header.number_nodes * sizeof(t9_session_state_node_t)
+                + header.number_paths * sizeof(t9_session_state_path_t)
+        || header.number_nodes == 0) {
+        return T9_FAILURE;
+    }
+
+    error = __t9_session_deserialize_tree(session, &header, records);
+    if (error != T9_SUCCESS) {
+        t9_session_reset(session);
+        return T9_FAILURE;
+    }
+    session->committed = (size_t) header.committed;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_reset(t9_session_t *const session) {
+    t9_search_tree_t *tree;
+    t9_search_node_t *child;
+    uint32_t i;
+
+    if (session == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Release existing paths.
+    for (i = 0; i < kv_size(session->paths); i++) {
+        __t9_session_path_release(session, kv_A(session->paths, i));
+    }
+    kv_size(session->paths) = 0;
+
+    session->committed = 0;
+
+    // Empty the search tree, its nodes and levels are reused by the next sequence.
+    tree = session->search_tree;
+    if (tree == NULL) {
+        session->search_tree = t9_search_tree_create();
+        return session->search_tree != NULL ? T9_SUCCESS : T9_FAILURE;
+    }
+    while (tree->root->children2->head != NULL) {
+        child = list_node_data(tree->root->children2->head);
+        __t9_session_entry_release(session, tree->root->children2, tree->root->children2->head);
+        __t9_session_node_release(session, child);
+    }
+    while (kv_size(tree->level_table2) > 0) {
+        __t9_session_level_release(session, kv_pop(tree->level_table2));
+    }
+    tree->root->symbol = ' ';
+    tree->root->probability = 0.0f;
+    tree->root->rescored = 0.0f;
+    tree->root->is_rescored = false;
+
+    // Start a new sequence of the A* decoder.
+    if (session->astar != NULL) {
+        t9_astar_reset(session->astar);
+    }
+
+    // Start a new lattice.
+    if (session->lattice != NULL) {
+        return t9_viterbi_lattice_reset(session->lattice);
+    }
+
+    return T9_SUCCESS;
+}
+
+void
+t9_session_set_metrics(t9_session_t *const session,
+                       t9_metrics_t *const metrics) {
+    if (session == NULL) {
+        return;
+    }
+
+    session->metrics = metrics;
+}
+
+void
+t9_session_set_output(t9_session_t *const session,
+                      t9_session_output_t output,
+                      void *arg) {
+    if (session == NULL) {
+        return;
+    }
+
+    session->output = output;
+    session->output_arg = arg;
+}
+
+t9_error_t
+t9_session_flush(t9_session_t *const session) {
+    t9_symbol_t *suggestion;
+
+    if (session == NULL || session->output == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Pass the rest of the best path to the output, if anything was typed since the last commit.
+    if (t9_session_suggestion(session, &suggestion) == T9_SUCCESS) {
+        session->output(suggestion, strlen((const char *) suggestion), session->output_arg);
+        free(suggestion);
+    }
+
+    return t9_session_reset(session);
+}
+
+t9_error_t
+t9_session_type(t9_session_t *const session,
+                const t9_symbol_t *const sequence) {
+    const t9_symbol_t *symbol;
+    size_t restored;
+
+    if (session == NULL || sequence == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (session->astar != NULL) {
+        return t9_astar_type(session->astar, sequence);
+    }
+
+    if (session->lattice == NULL) {
+        // The first keys of a new sequence are taken from the precomputed table of the model.
+        restored = 0;
+        if (session->model->table != NULL && session->output == NULL && session->committed == 0
+            && kv_size(session->search_tree->level_table2) == 0
+            && t9_table_matches(session->model->table, session->model) == true
+            && t9_table_resume(session->model->table, session, sequence, &restored) != T9_SUCCESS) {
+            restored = 0;
+            t9_session_reset(session);
+        }
+
+        // Populate the search tree.
+        return t9_search_tree_type(session, sequence + restored);
+    }
+
+    // Validate that the sequence to be inserted only contains valid lexicon symbols.
+    if (t9_corpus_validate_lexicon_symbols(sequence) == false) {
+        return T9_FAILURE;
+    }
+
+    for (symbol = sequence; *symbol != 0; symbol++) {
+        if (t9_viterbi_lattice_insert(session->lattice, *symbol) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_insert(t9_session_t *const session,
+                  t9_symbol_t symbol,
+                  double budget_ms,
+                  bool *const truncated) {
+    t9_symbol_t sequence[2];
+
+    if (truncated != NULL) {
+        *truncated = false;
+    }
+
+    if (session == NULL || t9_corpus_validate_lexicon_symbol(symbol) == false) {
+        return T9_FAILURE;
+    }
+
+    if (session->lattice != NULL) {
+        return t9_viterbi_lattice_insert(session->lattice, symbol);
+    }
+
+    if (session->astar != NULL) {
+        sequence[0] = symbol;
+        sequence[1] = 0;
+        return t9_astar_type(session->astar, sequence);
+    }
+
+    // Add a new search tree table entry for the new level.
+    if (__t9_session_level_push(session) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    return t9_search_tree_insert(session, symbol, budget_ms, truncated);
+}
+
+void
+t9_session_sort_paths(t9_session_t *const session) {
+    uint32_t i;
+    uint32_t j;
+    size_t length;
+    t9_path_t *tmp;
+
+    if (session == NULL) {
+        return;
+    }
+
+    if (kv_size(session->paths) == 0) {
+        return;
+    }
+
+    length = kv_size(session->paths) - 1;
+    for (j = 0; j < length; j++) {
+        for (i = 0; i < length; i++) {
+            // Check if the next path is better.
+            if (kv_A(session->paths, i + 1)->probability < kv_A(session->paths, i)->probability) {
+                // The next path is better.
+                // Therefore swap paths from index (i) and (i + 1).
+                tmp = kv_A(session->paths, i);
+                kv_A(session->paths, i) = kv_A(session->paths, i + 1);
+                kv_A(session->paths, i + 1) = tmp;
+            }
+        }
+    }
+}
+
+t9_error_t
+t9_session_suggestion(const t9_session_t *const session,
+                      t9_symbol_t **suggestion) {
+    if (session == NULL || suggestion == NULL) {
+        return T9_FAILURE;
+    }
+
+    // The exact decoders trace their best hypothesis back to the start of the sequence.
+    if (session->lattice != NULL) {
+        return t9_viterbi_lattice_suggestion(session->lattice, suggestion);
+    }
+
+    if (session->astar != NULL) {
+        return t9_astar_suggestion(session->astar, suggestion);
+    }
+
+    // Nothing was typed yet.
+    if (kv_size(session->paths) == 0) {
+        return T9_FAILURE;
+    }
+
+    // Note: session->paths is a list of the completion suggestions with descending scores.
+    *suggestion = t9_path_flatten(kv_A(session->paths, 0));
+    if (*suggestion == NULL) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_nbest(t9_session_t *const session,
+                 t9_symbol_t *const suggestions,
+                 size_t stride,
+                 float *const scores,
+                 size_t capacity,
+                 size_t *const count) {
+    size_t i;
+
+    if (session == NULL || suggestions == NULL || scores == NULL || count == NULL) {
+        return T9_FAILURE;
+    }
+
+    if (session->lattice != NULL) {
+        return t9_viterbi_lattice_nbest(session->lattice, suggestions, stride, scores, capacity, count);
+    }
+
+    if (session->astar != NULL) {
+        return t9_astar_nbest(session->astar, suggestions, stride, scores, capacity, count);
+    }
+
+    // Nothing was typed yet.
+    if (kv_size(session->paths) == 0) {
+        return T9_FAILURE;
+    }
+
+    // Note: session->paths is sorted, the best path first.
+    *count = 0;
+    for (i = 0; i < kv_size(session->paths) && i < capacity; i++) {
+        if (t9_path_write(kv_A(session->paths, i), &suggestions[i * stride], stride) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+        scores[i] = (float) kv_A(session->paths, i)->probability;
+        (*count)++;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_prune_path(t9_session_t *const session,
+                      t9_path_t *const path) {
+    ssize_t i;
+    t9_search_node_t *node;
+
+    if (session == NULL || path == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Prune all nodes contained in the path, starting at the end of the path.
+    if (kv_size(path->nodes) > 0) {
+        i = kv_size(path->nodes) - 1;
+        do {
+            // Get a node of the path.
+            node = kv_A(path->nodes, i);
+            // Prune this node.
+            __t9_session_prune_path_helper(session, node, (size_t) i);
+            i--;
+        } while (i >= 0);
+    }
+    return T9_SUCCESS;
+}
+
+void
+t9_session_prune_leaf(t9_session_t *const session,
+                      t9_search_node_t *const node,
+                      size_t depth) {
+    t9_search_node_t *current;
+    t9_search_node_t *parent;
+
+    // Remove nodes bottom up, until a node with further children or the root node is reached.
+    current = node;
+    while (current != NULL && current->parent != NULL && t9_search_node_is_leaf(current) == true) {
+        parent = current->parent;
+        __t9_session_prune_path_helper(session, current, depth);
+        current = parent;
+        if (depth == 0) {
+            break;
+        }
+        depth--;
+    }
+}
+
+void
+__t9_session_prune_path_helper(t9_session_t *const session,
+                               t9_search_node_t *const node,
+                               size_t depth) {
+    list_t *level_map;
+    list_node_t *list_node;
+
+    // We can only prune a node if it has no further children.
+    if (t9_search_node_is_leaf(node) == true) {
+        // Remove node from its parents children.
+        list_node = node->parent->children2->head;
+        while (list_node_data(list_node) != node) {
+            list_node = list_node->next;
+        }
+        __t9_session_entry_release(session, node->parent->children2, list_node);
+
+        // Remove node from the list of nodes for the tree level it resides on.
+        level_map = kv_A(session->search_tree->level_table2, depth);
+        list_node = node->level_entry != NULL ? node->level_entry : list_find(level_map, node);
+        __t9_session_entry_release(session, level_map, list_node);
+
+        // Release the node itself.
+        __t9_session_node_release(session, node);
+        if (session->metrics != NULL) {
+            t9_metrics_add(session->metrics, T9_METRICS_NODES_PRUNED, 1);
+        }
+    }
+}
+
+t9_search_node_t *
+__t9_session_node_new(t9_session_t *const session) {
+    t9_search_node_t *node;
+    list_t *children;
+
+    if (kv_size(session->free_nodes) == 0) {
+        return t9_search_node_create();
+    }
+
+    // Keep the empty list of children.
+    node = kv_pop(session->free_nodes);
+    children = node->children2;
+    memset(node, 0, sizeof(t9_search_node_t));
+    node->children2 = children;
+
+    return node;
+}
+
+void
+__t9_session_node_release(t9_session_t *const session,
+                          t9_search_node_t *const node) {
+    t9_search_node_t *child;
+
+    // The entries of the descendants on their levels are released with the levels.
+    while (node->children2->head != NULL) {
+        child = list_node_data(node->children2->head);
+        __t9_session_entry_release(session, node->children2, node->children2->head);
+        __t9_session_node_release(session, child);
+    }
+
+    kv_push(t9_search_node_t *, session->free_nodes, node);
+}
+
+list_node_t *
+__t9_session_entry_new(t9_session_t *const session,
+                       void *value) {
+    list_node_t *entry;
+
+    if (session->free_entries == NULL) {
+        return list_node_new(value);
+    }
+
+    entry = session->free_entries;
+    session->free_entries = entry->next;
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->val = value;
+
+    return entry;
+}
+
+void
+__t9_session_entry_release(t9_session_t *const session,
+                           list_t *const list,
+                           list_node_t *const entry) {
+    // Unlink the entry like list_remove does, without freeing it.
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        list->head = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        list->tail = entry->prev;
+    }
+    list->len--;
+
+    entry->next = session->free_entries;
+    session->free_entries = entry;
+}
+
+t9_error_t
+__t9_session_level_push(t9_session_t *const session) {
+    list_t *level;
+
+    if (kv_size(session->free_levels) > 0) {
+        level = kv_pop(session->free_levels);
+    } else {
+        level = list_new();
+        if (level == NULL) {
+            return T9_FAILURE;
+        }
+    }
+    kv_push(list_t *, session->search_tree->level_table2, level);
+
+    return T9_SUCCESS;
+}
+
+void
+__t9_session_level_release(t9_session_t *const session,
+                           list_t *const level) {
+    // The entries are chained already, so they are released at once.
+    if (level->head != NULL) {
+        level->tail->next = session->free_entries;
+        session->free_entries = level->head;
+    }
+    level->head = NULL;
+    level->tail = NULL;
+    level->len = 0;
+
+    kv_push(list_t *, session->free_levels, level);
+}
+
+t9_path_t *
+__t9_session_path_new(t9_session_t *const session) {
+    t9_path_t *path;
+
+    if (kv_size(session->free_paths) == 0) {
+        return t9_path_create();
+    }
+
+    // Keep the memory of the nodes.
+    path = kv_pop(session->free_paths);
+    path->probability = 0.0f;
+    kv_size(path->nodes) = 0;
+
+    return path;
+}
+
+void
+__t9_session_path_release(t9_session_t *const session,
+                          t9_path_t *const path) {
+    kv_push(t9_path_t *, session->free_paths, path);
+}
+
+void
+__t9_session_serialize_node(const t9_session_t *const session,
+                            const t9_search_node_t *const node,
+                            uint32_t parent,
+                            uint32_t level,
+                            t9_session_state_node_t *const nodes,
+                            t9_session_state_path_t *const paths,
+                            uint32_t *const number) {
+    t9_session_state_node_t *record;
+    list_node_t *list_node;
+    uint32_t index;
+    size_t i;
+
+    index = (*number)++;
+    record = &nodes[index];
+    memset(record, 0, sizeof(t9_session_state_node_t));
+    record->parent = parent;
+    record->level = level;
+    record->probability = node->probability;
+    record->rescored = node->rescored;
+    record->symbol = node->symbol;
+    record->is_rescored = node->is_rescored;
+
+    if (t9_search_node_is_leaf(node) == true) {
+        // Register the leaf with all paths ending in it.
+        for (i = 0; i < kv_size(session->paths); i++) {
+            if (kv_size(kv_A(session->paths, i)->nodes) > 0 && kv_last(kv_A(session->paths, i)->nodes) == node) {
+                paths[i].leaf = index;
+            }
+        }
+        return;
+    }
+
+    // The children of the root node reside on the first level.
+    level = parent == T9_SESSION_NO_NODE ? 0 : level + 1;
+    for (list_node = node->children2->head; list_node != NULL; list_node = list_node->next) {
+        __t9_session_serialize_node(session, list_node_data(list_node), index, level, nodes, paths, number);
+    }
+}
+
+t9_error_t
+__t9_session_deserialize_tree(t9_session_t *const session,
+                              const t9_session_state_t *const header,
+                              const uint8_t *const records) {
+    const uint8_t *paths;
+    t9_session_state_node_t record;
+    t9_session_state_node_t parent;
+    t9_session_state_path_t path_record;
+    t9_search_node_t **nodes;
+    t9_search_node_t *node;
+    t9_path_t *path;
+    size_t count;
+    uint32_t i;
+
+    // Every level holds at least one node.
+    if (header->number_levels > header->number_nodes) {
+        return T9_FAILURE;
+    }
+
+    // Add all levels.
+    for (i = 0; i < header->number_levels; i++) {
+        if (__t9_session_level_push(session) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+
+    // The nodes are looked up by the index of their record in the scratch buffer of the leaves.
+    if (kv_max(session->leaves) < header->number_nodes) {
+        nodes = (t9_search_node_t **) realloc(session->leaves.a, header->number_nodes * sizeof(t9_search_node_t *));
+        if (nodes == NULL) {
+            return T9_FAILURE;
+        }
+        session->leaves.a = nodes;
+        kv_max(session->leaves) = header->number_nodes;
+    }
+    nodes = session->leaves.a;
+
+    // Restore the root node.
+    memcpy(&record, records, sizeof(t9_session_state_node_t));
+    if (record.parent != T9_SESSION_NO_NODE) {
+        return T9_FAILURE;
+    }
+    nodes[0] = session->search_tree->root;
+    nodes[0]->symbol = record.symbol;
+    nodes[0]->probability = record.probability;
+    nodes[0]->rescored = record.rescored;
+    nodes[0]->is_rescored = record.is_rescored;
+
+    // Restore all other nodes, their parents precede them.
+    for (i = 1; i < header->number_nodes; i++) {
+        memcpy(&record, records + i * sizeof(t9_session_state_node_t), sizeof(t9_session_state_node_t));
+        if (record.parent >= i || record.level >= header->number_levels) {
+            return T9_FAILURE;
+        }
+        memcpy(&parent, records + record.parent * sizeof(t9_session_state_node_t), sizeof(t9_session_state_node_t));
+        if (record.level != (record.parent == 0 ? 0 : parent.level + 1)) {
+            return T9_FAILURE;
+        }
+
+        node = __t9_session_node_new(session);
+        if (node == NULL) {
+            return T9_FAILURE;
+        }
+        node->symbol = record.symbol;
+        node->probability = record.probability;
+        node->rescored = record.rescored;
+        node->is_rescored = record.is_rescored;
+        node->parent = nodes[record.parent];
+        list_rpush(node->parent->children2, __t9_session_entry_new(session, node));
+        node->level_entry = list_rpush(kv_A(session->search_tree->level_table2, record.level),
+                                       __t9_session_entry_new(session, node));
+        nodes[i] = node;
+    }
+
+    // Restore the paths from their leaves up to the root node.
+    paths = records + header->number_nodes * sizeof(t9_session_state_node_t);
+    for (i = 0; i < header->number_paths; i++) {
+        memcpy(&path_record, paths + i * sizeof(t9_session_state_path_t), sizeof(t9_session_state_path_t));
+        if (path_record.leaf == 0 || path_record.leaf >= header->number_nodes) {
+            return T9_FAILURE;
+        }
+
+        path = __t9_session_path_new(session);
+        if (path == NULL) {
+            return T9_FAILURE;
+        }
+        path->probability = path_record.probability;
+        kv_push(t9_path_t *, session->paths, path);
+
+        count = 0;
+        for (node = nodes[path_record.leaf]; node->parent != NULL; node = node->parent) {
+            count++;
+        }
+        if (kv_max(path->nodes) < count) {
+            kv_resize(t9_search_node_t *, path->nodes, count);
+        }
+        kv_size(path->nodes) = count;
+        for (node = nodes[path_record.leaf]; node->parent != NULL; node = node->parent) {
+            kv_A(path->nodes, --count) = node;
+        }
+    }
+
+    return T9_SUCCESS;
+}
@@ -0,0 +1,445 @@
+/*!
+  ******************************************************************************
+  * @file    speculator.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements speculative decoding of the next key on a background thread.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/speculator.h"
+
+t9_speculator_t *
+t9_speculator_create(t9_session_t *const session,
+                     uint8_t number_keys) {
+    t9_speculator_t *speculator;
+
+    if (session == NULL || number_keys == 0 || number_keys > NUM_LEXICON_SYMBOLS) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    speculator = (t9_speculator_t *) malloc(sizeof(t9_speculator_t));
+    if (speculator == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(speculator, 0, sizeof(t9_speculator_t));
+    speculator->session = session;
+    speculator->number_keys = number_keys;
+    speculator->current = T9_SPECULATOR_NO_KEY;
+    kv_init(speculator->discarded);
+
+    pthread_mutex_init(&speculator->lock, NULL);
+    pthread_cond_init(&speculator->wake, NULL);
+    pthread_cond_init(&speculator->done, NULL);
+
+    // Start the background thread.
+    if (pthread_create(&speculator->thread, NULL, __t9_speculator_worker, speculator) != 0) {
+        pthread_cond_destroy(&speculator->done);
+        pthread_cond_destroy(&speculator->wake);
+        pthread_mutex_destroy(&speculator->lock);
+        kv_destroy(speculator->discarded);
+        free(speculator);
+        return NULL;
+    }
+
+    // Speculate on the first key.
+    __t9_speculator_start(speculator);
+
+    return speculator;
+}
+
+void
+t9_speculator_destroy(t9_speculator_t *const speculator) {
+    if (speculator == NULL) {
+        return;
+    }
+
+    // Let the background thread finish its speculation and terminate.
+    pthread_mutex_lock(&speculator->lock);
+    speculator->shutdown = true;
+    pthread_cond_broadcast(&speculator->wake);
+    pthread_mutex_unlock(&speculator->lock);
+    pthread_join(speculator->thread, NULL);
+
+    // Destroy all remaining speculations.
+    __t9_speculator_discard(speculator, __t9_speculator_stop(speculator, 0));
+    while (kv_size(speculator->discarded) > 0) {
+        __t9_speculation_destroy(kv_pop(speculator->discarded));
+    }
+    kv_destroy(speculator->discarded);
+
+    pthread_cond_destroy(&speculator->done);
+    pthread_cond_destroy(&speculator->wake);
+    pthread_mutex_destroy(&speculator->lock);
+
+    // Erase and free memory.
+    memset(speculator, 0, sizeof(t9_speculator_t));
+    free(speculator);
+}
+
+t9_error_t
+t9_speculator_insert(t9_speculator_t *const speculator,
+                     t9_symbol_t symbol,
+                     double budget_ms,
+                     bool *const truncated) {
+    t9_speculation_t *speculation;
+    t9_session_t *session;
+    t9_session_t adopted;
+    t9_error_t error;
+
+    if (truncated != NULL) {
+        *truncated = false;
+    }
+
+    if (speculator == NULL || t9_corpus_validate_lexicon_symbol(symbol) == false) {
+        return T9_FAILURE;
+    }
+
+    session = speculator->session;
+    speculation = __t9_speculator_stop(speculator, symbol);
+    if (speculation != NULL) {
+        speculator->hits++;
+
+        // Swap the state of the session with the one of the speculation, but keep the output and the metrics of the
+        // session.
+        memcpy(&adopted, speculation->session, sizeof(t9_session_t));
+        memcpy(speculation->session, session, sizeof(t9_session_t));
+        memcpy(session, &adopted, sizeof(t9_session_t));
+        session->output = speculation->session->output;
+        session->output_arg = speculation->session->output_arg;
+        session->metrics = speculation->session->metrics;
+
+        // Pass the symbols the speculation held back.
+        if (session->output != NULL && kv_size(speculation->output) > 0) {
+            session->output(speculation->output.a, kv_size(speculation->output), session->output_arg);
+        }
+        error = T9_SUCCESS;
+    } else {
+        speculator->misses++;
+        error = t9_session_insert(session, symbol, budget_ms, truncated);
+    }
+
+    // Speculate on the next key and let the background thread release the replaced state.
+    __t9_speculator_start(speculator);
+    __t9_speculator_discard(speculator, speculation);
+
+    return error;
+}
+
+t9_error_t
+t9_speculator_nbest(t9_speculator_t *const speculator,
+                    t9_symbol_t *const suggestions,
+                    size_t stride,
+                    float *const scores,
+                    size_t capacity,
+                    size_t *const count) {
+    t9_error_t error;
+
+    if (speculator == NULL) {
+        return T9_FAILURE;
+    }
+
+    // The background thread copies the session only while it holds the lock.
+    pthread_mutex_lock(&speculator->lock);
+    error = t9_session_nbest(speculator->session, suggestions, stride, scores, capacity, count);
+    pthread_mutex_unlock(&speculator->lock);
+
+    return error;
+}
+
+t9_error_t
+t9_speculator_reset(t9_speculator_t *const speculator) {
+    t9_error_t error;
+
+    if (speculator == NULL) {
+        return T9_FAILURE;
+    }
+
+    __t9_speculator_discard(speculator, __t9_speculator_stop(speculator, 0));
+    error = t9_session_reset(speculator->session);
+    __t9_speculator_start(speculator);
+
+    return error;
+}
+
+t9_error_t
+t9_speculator_flush(t9_speculator_t *const speculator) {
+    t9_error_t error;
+
+    if (speculator == NULL) {
+        return T9_FAILURE;
+    }
+
+    __t9_speculator_discard(speculator, __t9_speculator_stop(speculator, 0));
+    error = t9_session_flush(speculator->session);
+    __t9_speculator_start(speculator);
+
+    return error;
+}
+
+t9_speculation_t *
+__t9_speculator_stop(t9_speculator_t *const speculator,
+                     t9_symbol_t symbol) {
+    t9_speculation_t *taken;
+    uint8_t index;
+    uint8_t i;
+
+    pthread_mutex_lock(&speculator->lock);
+
+    // Find the speculation on the symbol.
+    index = T9_SPECULATOR_NO_KEY;
+    for (i = 0; i < speculator->queued; i++) {
+        if (speculator->keys[i] == symbol) {
+            index = i;
+        }
+    }
+
+    // A running speculation on the symbol is finished sooner than the symbol can be decoded again.
+    while (index != T9_SPECULATOR_NO_KEY && speculator->current == index &&
+           speculator->working == speculator->generation) {
+        pthread_cond_wait(&speculator->done, &speculator->lock);
+    }
+
+    // Take all speculations. Running ones are discarded by the background thread, once they are finished.
+    taken = NULL;
+    for (i = 0; i < speculator->queued; i++) {
+        if (i == index) {
+            taken = speculator->speculations[i];
+        } else if (speculator->speculations[i] != NULL) {
+            kv_push(t9_speculation_t *, speculator->discarded, speculator->speculations[i]);
+        }
+        speculator->speculations[i] = NULL;
+    }
+    speculator->queued = 0;
+    speculator->next = 0;
+    speculator->generation++;
+    pthread_cond_signal(&speculator->wake);
+
+    pthread_mutex_unlock(&speculator->lock);
+
+    return taken;
+}
+
+void
+__t9_speculator_discard(t9_speculator_t *const speculator,
+                        t9_speculation_t *const speculation) {
+    if (speculation == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&speculator->lock);
+    kv_push(t9_speculation_t *, speculator->discarded, speculation);
+    pthread_cond_signal(&speculator->wake);
+    pthread_mutex_unlock(&speculator->lock);
+}
+
+void
+__t9_speculator_start(t9_speculator_t *const speculator) {
+    const t9_model_t *model;
+    const t9_corpus_node_t *context;
+    const t9_corpus_node_t *child;
+    const char *key;
+    double probabilities[NUM_LEXICON_SYMBOLS];
+    t9_symbol_t keys[NUM_LEXICON_SYMBOLS];
+    t9_symbol_t *suggestion;
+    t9_symbol_t symbol;
+    double probability;
+    size_t length;
+    size_t offset;
+    size_t i;
+    size_t j;
+
+    model = speculator->session->model;
+
+    // The next key is predicted from the end of the best suggestion.
+    context = model->corpus_tree->root;
+    if (t9_session_suggestion(speculator->session, &suggestion) == T9_SUCCESS) {
+        length = strlen((const char *) suggestion);
+        offset = length > (size_t) (model->ngram_length - 1) ? length - (model->ngram_length - 1) : 0;
+
+        // Back off to shorter contexts, until a context is known to the model.
+        for (context = NULL; context == NULL; offset++) {
+            context = t9_corpus_node_descend(model->corpus_tree->root, suggestion + offset, length - offset);
+        }
+        free(suggestion);
+    }
+
+    // The probability of a key is the one of all symbols assigned to it.
+    memset(probabilities, 0, sizeof(probabilities));
+    for (i = 0; i < kv_size(context->children); i++) {
+        child = kv_A(context->children, i);
+        if (t9_corpus_ctol(child->symbol, &symbol) == T9_SUCCESS) {
+            key = strchr(LEXICON_SYMBOLS, symbol);
+            probabilities[key - LEXICON_SYMBOLS] += child->probability;
+        }
+    }
+
+    // Rank the keys by their probability.
+    memcpy(keys, LEXICON_SYMBOLS, NUM_LEXICON_SYMBOLS);
+    for (i = 0; i < speculator->number_keys; i++) {
+        for (j = i + 1; j < NUM_LEXICON_SYMBOLS; j++) {
+            if (probabilities[j] > probabilities[i]) {
+                probability = probabilities[i];
+                probabilities[i] = probabilities[j];
+                probabilities[j] = probability;
+                symbol = keys[i];
+                keys[i] = keys[j];
+                keys[j] = symbol;
+            }
+        }
+    }
+
+    // Pass the most likely keys to the background thread.
+    pthread_mutex_lock(&speculator->lock);
+    memcpy(speculator->keys, keys, speculator->number_keys);
+    speculator->queued = speculator->number_keys;
+    speculator->next = 0;
+    pthread_cond_signal(&speculator->wake);
+    pthread_mutex_unlock(&speculator->lock);
+}
+
+void *
+__t9_speculator_worker(void *arg) {
+    t9_speculator_t *speculator;
+    t9_speculation_t *speculation;
+    t9_symbol_t key;
+    uint64_t generation;
+    uint8_t index;
+
+    speculator = (t9_speculator_t *) arg;
+
+    pthread_mutex_lock(&speculator->lock);
+    while (true) {
+        // Wait for keys to speculate on or speculations to be destroyed.
+        while (speculator->shutdown == false && speculator->next >= speculator->queued &&
+               kv_size(speculator->discarded) == 0) {
+            pthread_cond_wait(&speculator->wake, &speculator->lock);
+        }
+        if (speculator->shutdown == true) {
+            break;
+        }
+
+        // Speculations are destroyed, once there is no key left to speculate on.
+        if (speculator->next >= speculator->queued) {
+            speculation = kv_pop(speculator->discarded);
+            pthread_mutex_unlock(&speculator->lock);
+            __t9_speculation_destroy(speculation);
+            pthread_mutex_lock(&speculator->lock);
+            continue;
+        }
+
+        index = speculator->next++;
+        key = speculator->keys[index];
+        generation = speculator->generation;
+
+        // The session is copied while the lock is held, so that it is not modified meanwhile.
+        speculation = __t9_speculation_create(speculator->session);
+        speculator->current = index;
+        speculator->working = generation;
+        pthread_mutex_unlock(&speculator->lock);
+
+        // Type the key into the copy.
+        if (speculation != NULL && t9_session_insert(speculation->session, key, 0.0, NULL) != T9_SUCCESS) {
+            __t9_speculation_destroy(speculation);
+            speculation = NULL;
+        }
+
+        pthread_mutex_lock(&speculator->lock);
+        speculator->current = T9_SPECULATOR_NO_KEY;
+        if (generation == speculator->generation) {
+            speculator->speculations[index] = speculation;
+        } else if (speculation != NULL) {
+            // The key was typed or the session was reset in the meantime.
+            kv_push(t9_speculation_t *, speculator->discarded, speculation);
+        }
+        pthread_cond_broadcast(&speculator->done);
+    }
+    pthread_mutex_unlock(&speculator->lock);
+
+    return NULL;
+}
+
+void
+__t9_speculation_output(const t9_symbol_t *symbols,
+                        size_t length,
+                        void *arg) {
+    t9_speculation_t *speculation;
+    size_t i;
+
+    speculation = (t9_speculation_t *) arg;
+    for (i = 0; i < length; i++) {
+        kv_push(t9_symbol_t, speculation->output, symbols[i]);
+    }
+}
+
+t9_speculation_t *
+__t9_speculation_create(const t9_session_t *const session) {
+    t9_speculation_t *speculation;
+
+    // Allocate memory.
+    speculation = (t9_speculation_t *) malloc(sizeof(t9_speculation_t));
+    if (speculation == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(speculation, 0, sizeof(t9_speculation_t));
+    kv_init(speculation->output);
+
+    speculation->session = t9_session_clone(session);
+    if (speculation->session == NULL) {
+        __t9_speculation_destroy(speculation);
+        return NULL;
+    }
+
+    // Hold back the symbols committed by the copy.
+    if (speculation->session->output != NULL) {
+        t9_session_set_output(speculation->session, __t9_speculation_output, speculation);
+    }
+
+    return speculation;
+}
+
+void
+__t9_speculation_destroy(t9_speculation_t *const speculation) {
+    if (speculation == NULL) {
+        return;
+    }
+
+    if (speculation->session != NULL) {
+        t9_session_destroy(speculation->session);
+    }
+    kv_destroy(speculation->output);
+
+    // Erase and free memory.
+    memset(speculation, 0, sizeof(t9_speculation_t));
+    free(speculation);
+}
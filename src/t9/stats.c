@@ -0,0 +1,225 @@
+/*!
+  ******************************************************************************
+  * @file    stats.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   Memory accounting and introspection of models and sessions.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include <string.h>
+
+#include "t9/stats.h"
+
+t9_error_t
+t9_model_stats(const t9_model_t *const model,
+               t9_model_stats_t *const stats) {
+    if (model == NULL || stats == NULL) {
+        return T9_FAILURE;
+    }
+
+    memset(stats, 0, sizeof(t9_model_stats_t));
+    stats->model_bytes = sizeof(t9_model_t);
+    stats->corpus_bytes = model->corpus.train_buffer_size + model->corpus.test_buffer_size;
+
+    if (model->corpus_tree != NULL && model->corpus_tree->root != NULL) {
+        stats->corpus_node_bytes += sizeof(t9_corpus_tree_t);
+        __t9_stats_corpus_node(model->corpus_tree->root, 0, stats);
+    }
+
+    // The compiled decoders hold a transition and a cost for every state and corpus symbol.
+    if (model->viterbi != NULL) {
+        stats->viterbi_bytes = sizeof(t9_viterbi_t)
+                               + model->viterbi->number_states * NUM_CORPUS_SYMBOLS * (sizeof(uint32_t) + sizeof(float));
+    }
+
+    if (model->table != NULL) {
+        stats->table_bytes = sizeof(t9_table_t) + (size_t) (model->table->header.number_entries + 1) * sizeof(uint64_t)
+                             + (size_t) model->table->header.size;
+    }
+
+    stats->total_bytes = stats->model_bytes + stats->corpus_bytes + stats->corpus_node_bytes
+                         + stats->corpus_children_bytes + stats->corpus_slack_bytes + stats->viterbi_bytes
+                         + stats->table_bytes;
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_session_stats(const t9_session_t *const session,
+                 t9_session_stats_t *const stats) {
+    const t9_path_t *path;
+    const list_t *level;
+    const list_node_t *entry;
+    size_t i;
+
+    if (session == NULL || stats == NULL) {
+        return T9_FAILURE;
+    }
+
+    memset(stats, 0, sizeof(t9_session_stats_t));
+    stats->session_bytes = sizeof(t9_session_t);
+
+    if (session->search_tree != NULL) {
+        stats->search_node_bytes += sizeof(t9_search_tree_t);
+        if (session->search_tree->root != NULL) {
+            __t9_stats_search_node(session->search_tree->root, stats);
+        }
+
+        // Every level lists the search nodes on it.
+        stats->level_table_bytes = kv_size(session->search_tree->level_table2) * sizeof(list_t *);
+        stats->level_table_slack_bytes = (kv_max(session->search_tree->level_table2)
+                                          - kv_size(session->search_tree->level_table2)) * sizeof(list_t *);
+        for (i = 0; i < kv_size(session->search_tree->level_table2); i++) {
+            level = kv_A(session->search_tree->level_table2, i);
+            stats->lists++;
+            stats->list_nodes += level->len;
+        }
+    }
+    stats->list_bytes = stats->lists * sizeof(list_t);
+    stats->list_node_bytes = stats->list_nodes * sizeof(list_node_t);
+
+    stats->paths = kv_size(session->paths);
+    stats->path_slack_bytes = (kv_max(session->paths) - kv_size(session->paths)) * sizeof(t9_path_t *);
+    stats->path_bytes = kv_size(session->paths) * sizeof(t9_path_t *);
+    for (i = 0; i < kv_size(session->paths); i++) {
+        path = kv_A(session->paths, i);
+        stats->path_bytes += sizeof(t9_path_t) + kv_size(path->nodes) * sizeof(t9_search_node_t *);
+        stats->path_slack_bytes += (kv_max(path->nodes) - kv_size(path->nodes)) * sizeof(t9_search_node_t *);
+    }
+
+    // Released nodes keep their empty list of children.
+    stats->reuse_bytes = kv_max(session->free_nodes) * sizeof(t9_search_node_t *)
+                         + kv_size(session->free_nodes) * (sizeof(t9_search_node_t) + sizeof(list_t))
+                         + kv_max(session->free_levels) * sizeof(list_t *)
+                         + kv_size(session->free_levels) * sizeof(list_t)
+                         + kv_max(session->free_paths) * sizeof(t9_path_t *)
+                         + kv_max(session->leaves) * sizeof(t9_search_node_t *)
+                         + kv_max(session->scratch);
+    for (entry = session->free_entries; entry != NULL; entry = entry->next) {
+        stats->reuse_bytes += sizeof(list_node_t);
+    }
+    for (i = 0; i < kv_size(session->free_paths); i++) {
+        path = kv_A(session->free_paths, i);
+        stats->reuse_bytes += sizeof(t9_path_t) + kv_max(path->nodes) * sizeof(t9_search_node_t *);
+    }
+
+    if (session->lattice != NULL) {
+        stats->decoder_bytes += sizeof(t9_viterbi_lattice_t)
+                                + kv_max(session->lattice->entries) * sizeof(t9_viterbi_entry_t)
+                                + session->lattice->viterbi->number_states * sizeof(uint32_t);
+    }
+    if (session->astar != NULL) {
+        stats->decoder_bytes += sizeof(t9_astar_t)
+                                + kv_max(session->astar->keys) * sizeof(t9_symbol_t)
+                                + kv_max(session->astar->prefix) * sizeof(double)
+                                + kv_max(session->astar->nodes) * sizeof(t9_astar_node_t)
+                                + kv_max(session->astar->heap) * sizeof(t9_astar_item_t)
+                                + kv_max(session->astar->finals) * sizeof(uint32_t)
+                                + session->astar->number_slots * sizeof(t9_astar_slot_t);
+    }
+
+    stats->total_bytes = stats->session_bytes + stats->search_node_bytes + stats->list_bytes + stats->list_node_bytes
+                         + stats->level_table_bytes + stats->level_table_slack_bytes + stats->path_bytes
+                         + stats->path_slack_bytes + stats->decoder_bytes + stats->reuse_bytes;
+    return T9_SUCCESS;
+}
+
+void
+t9_model_stats_write(const t9_model_stats_t *const stats,
+                     FILE *const fp) {
+    size_t depth;
+    size_t i;
+
+    if (stats == NULL || fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "%-24s %14s\n", "structure", "bytes");
+    fprintf(fp, "%-24s %14zu\n", "model", stats->model_bytes);
+    fprintf(fp, "%-24s %14zu\n", "corpus buffers", stats->corpus_bytes);
+    fprintf(fp, "%-24s %14zu\n", "corpus nodes", stats->corpus_node_bytes);
+    fprintf(fp, "%-24s %14zu\n", "corpus children", stats->corpus_children_bytes);
+    fprintf(fp, "%-24s %14zu\n", "corpus children slack", stats->corpus_slack_bytes);
+    fprintf(fp, "%-24s %14zu\n", "viterbi states", stats->viterbi_bytes);
+    fprintf(fp, "%-24s %14zu\n", "table", stats->table_bytes);
+    fprintf(fp, "%-24s %14zu\n", "total", stats->total_bytes);
+
+    fprintf(fp, "\n%-24s %14s\n", "depth", "nodes");
+    depth = stats->depth < T9_STATS_MAX_DEPTH ? stats->depth : T9_STATS_MAX_DEPTH - 1;
+    for (i = 0; i <= depth && stats->corpus_nodes > 0; i++) {
+        fprintf(fp, "%-24zu %14zu\n", i, stats->nodes_per_depth[i]);
+    }
+
+    fprintf(fp, "\n%-24s %14s\n", "children", "nodes");
+    for (i = 0; i <= NUM_CORPUS_SYMBOLS; i++) {
+        if (stats->children_distribution[i] > 0) {
+            fprintf(fp, "%-24zu %14zu\n", i, stats->children_distribution[i]);
+        }
+    }
+}
+
+void
+__t9_stats_corpus_node(const t9_corpus_node_t *const node,
+                       size_t depth,
+                       t9_model_stats_t *const stats) {
+    size_t children;
+    size_t i;
+
+    children = kv_size(node->children);
+    stats->corpus_nodes++;
+    stats->corpus_node_bytes += sizeof(t9_corpus_node_t);
+    stats->corpus_children_bytes += children * sizeof(t9_corpus_node_t *);
+    stats->corpus_slack_bytes += (kv_max(node->children) - children) * sizeof(t9_corpus_node_t *);
+    stats->nodes_per_depth[depth < T9_STATS_MAX_DEPTH ? depth : T9_STATS_MAX_DEPTH - 1]++;
+    stats->children_distribution[children <= NUM_CORPUS_SYMBOLS ? children : NUM_CORPUS_SYMBOLS]++;
+    if (depth > stats->depth) {
+        stats->depth = depth;
+    }
+
+    for (i = 0; i < children; i++) {
+        __t9_stats_corpus_node(kv_A(node->children, i), depth + 1, stats);
+    }
+}
+
+void
+__t9_stats_search_node(const t9_search_node_t *const node,
+                       t9_session_stats_t *const stats) {
+    const list_node_t *child;
+
+    stats->search_nodes++;
+    stats->search_node_bytes += sizeof(t9_search_node_t);
+    if (node->children2 == NULL) {
+        return;
+    }
+
+    stats->lists++;
+    stats->list_nodes += node->children2->len;
+    for (child = node->children2->head; child != NULL; child = child->next) {
+        __t9_stats_search_node((const t9_search_node_t *) child->val, stats);
+    }
+}
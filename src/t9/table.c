@@ -0,0 +1,433 @@
+/*!
+  ******************************************************************************
+  * @file    table.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements precomputed decoding results of short key sequences.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/table.h"
+
+t9_error_t
+t9_table_build(const t9_model_t *const model,
+               uint8_t length,
+               t9_pool_t *const pool,
+               t9_table_t **table) {
+    t9_table_build_t build;
+    t9_table_t *result;
+    t9_error_t error;
+    uint64_t number_entries;
+    uint64_t size;
+    uint64_t i;
+    size_t k;
+
+    if (model == NULL || model->corpus_tree == NULL || table == NULL || model->decoder != T9_DECODER_BEAM
+        || length == 0 || length > T9_TABLE_MAX_LENGTH) {
+        return T9_FAILURE;
+    }
+
+    number_entries = __t9_table_number_entries(length);
+    build.model = model;
+    build.length = length;
+    build.entries = (uint8_t **) calloc(number_entries, sizeof(uint8_t *));
+    build.sizes = (size_t *) calloc(number_entries, sizeof(size_t));
+    if (build.entries == NULL || build.sizes == NULL) {
+        free(build.entries);
+        free(build.sizes);
+        return T9_FAILURE;
+    }
+
+    // Decode the subtrees of all first keys.
+    error = T9_SUCCESS;
+    if (pool != NULL) {
+        error = t9_pool_run(pool, NUM_LEXICON_SYMBOLS, __t9_table_build_task, &build);
+    } else {
+        for (k = 0; k < NUM_LEXICON_SYMBOLS; k++) {
+            __t9_table_build_task(0, k, &build);
+        }
+    }
+
+    // Allocate memory.
+    result = (t9_table_t *) malloc(sizeof(t9_table_t));
+    if (result != NULL) {
+        // Erase memory.
+        memset(result, 0, sizeof(t9_table_t));
+        result->offsets = (uint64_t *) malloc((number_entries + 1) * sizeof(uint64_t));
+    }
+    if (result == NULL || result->offsets == NULL) {
+        error = T9_FAILURE;
+    }
+
+    // Concatenate the entries.
+    size = 0;
+    for (i = 0; i < number_entries && error == T9_SUCCESS; i++) {
+        if (build.entries[i] == NULL) {
+            error = T9_FAILURE;
+        }
+        result->offsets[i] = size;
+        size += build.sizes[i];
+    }
+    if (error == T9_SUCCESS) {
+        result->offsets[number_entries] = size;
+        result->data = (uint8_t *) malloc(size > 0 ? size : 1);
+        if (result->data == NULL) {
+            error = T9_FAILURE;
+        }
+    }
+    for (i = 0; i < number_entries; i++) {
+        if (error == T9_SUCCESS) {
+            memcpy(result->data + result->offsets[i], build.entries[i], build.sizes[i]);
+        }
+        free(build.entries[i]);
+    }
+    free(build.entries);
+    free(build.sizes);
+
+    if (error != T9_SUCCESS) {
+        t9_table_destroy(result);
+        return T9_FAILURE;
+    }
+
+    // Record the decoding parameters.
+    memcpy(result->header.magic, T9_TABLE_MAGIC, sizeof(result->header.magic));
+    result->header.version = T9_TABLE_VERSION;
+    result->header.length = length;
+    result->header.decoder = model->decoder;
+    result->header.ngram_length = model->ngram_length;
+    result->header.rescore_length = model->rescore_length;
+    result->header.number_paths = model->number_paths;
+    result->header.paths_per_context = model->paths_per_context;
+    result->header.rescore_paths = model->rescore_paths;
+    result->header.beam_threshold = model->beam_threshold;
+    result->header.number_nodes = model->corpus_tree->number_nodes;
+    result->header.checksum = model->corpus_tree->checksum;
+    result->header.number_entries = number_entries;
+    result->header.size = size;
+
+    *table = result;
+    return T9_SUCCESS;
+}
+
+void
+t9_table_destroy(t9_table_t *const table) {
+    if (table == NULL) {
+        return;
+    }
+
+    free(table->offsets);
+    free(table->data);
+
+    // Erase and free memory.
+    memset(table, 0, sizeof(t9_table_t));
+    free(table);
+}
+
+t9_error_t
+t9_table_write(const t9_table_t *const table,
+               FILE *const fp) {
+    size_t number_offsets;
+
+    if (table == NULL || fp == NULL) {
+        return T9_FAILURE;
+    }
+
+    number_offsets = (size_t) table->header.number_entries + 1;
+    if (fwrite(&table->header, sizeof(t9_table_header_t), 1, fp) != 1
+        || fwrite(table->offsets, sizeof(uint64_t), number_offsets, fp) != number_offsets
+        || fwrite(table->data, 1, (size_t) table->header.size, fp) != table->header.size) {
+        return T9_FAILURE;
+    }
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_table_read(FILE *const fp,
+              t9_table_t **table) {
+    t9_table_t *result;
+    size_t number_offsets;
+    uint64_t i;
+    bool valid;
+
+    if (fp == NULL || table == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Allocate memory.
+    result = (t9_table_t *) malloc(sizeof(t9_table_t));
+    if (result == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Erase memory.
+    memset(result, 0, sizeof(t9_table_t));
+
+    valid = fread(&result->header, sizeof(t9_table_header_t), 1, fp) == 1
+            && memcmp(result->header.magic, T9_TABLE_MAGIC, sizeof(result->header.magic)) == 0
+            && result->header.version == T9_TABLE_VERSION
+            && result->header.length > 0 && result->header.length <= T9_TABLE_MAX_LENGTH
+            && result->header.number_entries == __t9_table_number_entries(result->header.length);
+
+    if (valid == true) {
+        number_offsets = (size_t) result->header.number_entries + 1;
+        result->offsets = (uint64_t *) malloc(number_offsets * sizeof(uint64_t));
+        result->data = (uint8_t *) malloc(result->header.size > 0 ? (size_t) result->header.size : 1);
+        valid = result->offsets != NULL && result->data != NULL
+                && fread(result->offsets, sizeof(uint64_t), number_offsets, fp) == number_offsets
+                && fread(result->data, 1, (size_t) result->header.size, fp) == result->header.size;
+    }
+
+    // Entries must lie within the data.
+    for (i = 0; valid == true && i < result->header.number_entries; i++) {
+        valid = result->offsets[i] <= result->offsets[i + 1];
+    }
+    if (valid == false || result->offsets[result->header.number_entries] != result->header.size) {
+        t9_table_destroy(result);
+        return T9_FAILURE;
+    }
+
+    *table = result;
+    return T9_SUCCESS;
+}
+
+bool
+t9_table_matches(const t9_table_t *const table,
+                 const t9_model_t *const model) {
+    if (table == NULL || model == NULL) {
+        return false;
+    }
+
+    return table->header.decoder == model->decoder
+           && table->header.ngram_length == model->ngram_length
+           && table->header.rescore_length == model->rescore_length
+           && table->header.number_paths == model->number_paths
+           && table->header.paths_per_context == model->paths_per_context
+           && table->header.rescore_paths == model->rescore_paths
+           && table->header.beam_threshold == model->beam_threshold
+           && model->corpus_tree != NULL
+           && table->header.number_nodes == model->corpus_tree->number_nodes
+           && table->header.checksum == model->corpus_tree->checksum;
+}
+
+t9_error_t
+t9_table_lookup(const t9_table_t *const table,
+                const t9_symbol_t *const sequence,
+                size_t length,
+                t9_table_entry_t *const entry) {
+    const uint8_t *data;
+    uint32_t number_suggestions;
+    size_t index;
+    size_t size;
+    size_t i;
+
+    if (table == NULL || sequence == NULL || entry == NULL || length == 0 || length > table->header.length) {
+        return T9_FAILURE;
+    }
+
+    for (i = 0; i < length; i++) {
+        if (t9_corpus_validate_lexicon_symbol(sequence[i]) == false) {
+            return T9_FAILURE;
+        }
+    }
+
+    index = __t9_table_index(sequence, length);
+    data = table->data + table->offsets[index];
+    size = (size_t) (table->offsets[index + 1] - table->offsets[index]);
+
+    if (size < sizeof(uint32_t)) {
+        return T9_FAILURE;
+    }
+    memcpy(&number_suggestions, data, sizeof(uint32_t));
+    if (size < sizeof(uint32_t) + number_suggestions * length) {
+        return T9_FAILURE;
+    }
+
+    entry->number_suggestions = number_suggestions;
+    entry->length = length;
+    entry->suggestions = data + sizeof(uint32_t);
+    entry->state = entry->suggestions + number_suggestions * length;
+    entry->size = size - sizeof(uint32_t) - number_suggestions * length;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_table_resume(const t9_table_t *const table,
+                t9_session_t *const session,
+                const t9_symbol_t *const sequence,
+                size_t *const restored) {
+    t9_table_entry_t entry;
+    size_t length;
+
+    if (table == NULL || session == NULL || sequence == NULL || restored == NULL) {
+        return T9_FAILURE;
+    }
+
+    *restored = 0;
+    length = 0;
+    while (length < table->header.length && sequence[length] != 0) {
+        length++;
+    }
+    if (length == 0) {
+        return T9_SUCCESS;
+    }
+
+    if (t9_table_lookup(table, sequence, length, &entry) != T9_SUCCESS
+        || t9_session_deserialize(session, entry.state, entry.size) != T9_SUCCESS) {
+        return T9_FAILURE;
+    }
+
+    *restored = length;
+    return T9_SUCCESS;
+}
+
+size_t
+__t9_table_index(const t9_symbol_t *const sequence,
+                 size_t length) {
+    size_t offset;
+    size_t index;
+    size_t count;
+    size_t i;
+
+    // The sequences of length k follow all 12 + ... + 12^(k - 1) shorter ones.
+    offset = 0;
+    index = 0;
+    count = 1;
+    for (i = 0; i < length; i++) {
+        offset += count;
+        count *= NUM_LEXICON_SYMBOLS;
+        index = index * NUM_LEXICON_SYMBOLS + (size_t) (strchr(LEXICON_SYMBOLS, sequence[i]) - LEXICON_SYMBOLS);
+    }
+
+    return offset - 1 + index;
+}
+
+uint64_t
+__t9_table_number_entries(uint8_t length) {
+    uint64_t number_entries;
+    uint64_t count;
+    uint8_t i;
+
+    // There are 12^k sequences of length k.
+    number_entries = 0;
+    count = 1;
+    for (i = 0; i < length; i++) {
+        count *= NUM_LEXICON_SYMBOLS;
+        number_entries += count;
+    }
+
+    return number_entries;
+}
+
+void
+__t9_table_build_task(size_t worker,
+                      size_t index,
+                      void *arg) {
+    t9_table_build_t *build;
+    t9_session_t *session;
+    t9_symbol_t sequence[T9_TABLE_MAX_LENGTH];
+
+    (void) worker;
+    build = (t9_table_build_t *) arg;
+
+    session = t9_session_create(build->model);
+    if (session == NULL) {
+        return;
+    }
+
+    sequence[0] = (t9_symbol_t) LEXICON_SYMBOLS[index];
+    if (t9_session_insert(session, sequence[0], 0.0, NULL) == T9_SUCCESS) {
+        __t9_table_build_node(build, session, sequence, 1);
+    }
+
+    t9_session_destroy(session);
+}
+
+void
+__t9_table_build_node(t9_table_build_t *const build,
+                      t9_session_t *const session,
+                      t9_symbol_t *const sequence,
+                      size_t depth) {
+    t9_session_t *fork;
+    t9_symbol_t *suggestion;
+    uint8_t *state;
+    uint8_t *entry;
+    uint32_t number_suggestions;
+    size_t size;
+    size_t index;
+    size_t i;
+
+    // Store the suggestions and the state of the sequence.
+    if (t9_session_serialize(session, &state, &size) != T9_SUCCESS) {
+        return;
+    }
+    number_suggestions = (uint32_t) kv_size(session->paths);
+    index = __t9_table_index(sequence, depth);
+
+    entry = (uint8_t *) malloc(sizeof(uint32_t) + number_suggestions * depth + size);
+    if (entry == NULL) {
+        free(state);
+        return;
+    }
+    memcpy(entry, &number_suggestions, sizeof(uint32_t));
+    for (i = 0; i < number_suggestions; i++) {
+        suggestion = t9_path_flatten(kv_A(session->paths, i));
+        if (suggestion == NULL || strlen((const char *) suggestion) != depth) {
+            free(suggestion);
+            free(entry);
+            free(state);
+            return;
+        }
+        memcpy(entry + sizeof(uint32_t) + i * depth, suggestion, depth);
+        free(suggestion);
+    }
+    memcpy(entry + sizeof(uint32_t) + number_suggestions * depth, state, size);
+    free(state);
+
+    build->entries[index] = entry;
+    build->sizes[index] = sizeof(uint32_t) + number_suggestions * depth + size;
+
+    if (depth == build->length) {
+        return;
+    }
+
+    // Every key but the last one continues on a copy of the session.
+    for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+        sequence[depth] = (t9_symbol_t) LEXICON_SYMBOLS[i];
+        if (i + 1 < NUM_LEXICON_SYMBOLS) {
+            fork = t9_session_clone(session);
+            if (fork != NULL && t9_session_insert(fork, sequence[depth], 0.0, NULL) == T9_SUCCESS) {
+                __t9_table_build_node(build, fork, sequence, depth + 1);
+            }
+            t9_session_destroy(fork);
+        } else if (t9_session_insert(session, sequence[depth], 0.0, NULL) == T9_SUCCESS) {
+            __t9_table_build_node(build, session, sequence, depth + 1);
+        }
+    }
+}
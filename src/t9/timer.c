@@ -40,7 +40,7 @@ t9_timer_start(t9_timer_t *const timer) {
         return;
     }
 
-    timer->start = clock();
+    timer->start = t9_timer_now_ns();
 }
 
 void
@@ -49,7 +49,7 @@ t9_timer_stop(t9_timer_t *const timer) {
         return;
     }
 
-    timer->end = clock();
+    timer->end = t9_timer_now_ns();
 }
 
 void
@@ -71,6 +71,54 @@ t9_timer_duration_ms(t9_timer_t *const timer) {
     }
 
     t9_timer_stop(timer);
-    return ((double) (timer->end - timer->start) / CLOCKS_PER_SEC) * 1000.0;
+    return (double) (timer->end - timer->start) / 1000000.0;
 }
 
+double
+t9_timer_now_ms(void) {
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return 0;
+    }
+
+    return (double) now.tv_sec * 1000.0 + (double) now.tv_nsec / 1000000.0;
+}
+
+uint64_t
+t9_timer_now_ns(void) {
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return 0;
+    }
+
+    return (uint64_t) now.tv_sec * UINT64_C(1000000000) + (uint64_t) now.tv_nsec;
+}
+
+uint64_t
+t9_timer_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return t9_timer_now_ns();
+#endif
+}
+
+double
+t9_timer_cycles_per_ns(void) {
+    uint64_t start_ns;
+    uint64_t start_cycles;
+    uint64_t end_ns;
+    uint64_t end_cycles;
+
+    // Spin on both clocks, so that the calibration does not depend on the wake up latency of the scheduler.
+    start_ns = t9_timer_now_ns();
+    start_cycles = t9_timer_cycles();
+    do {
+        end_ns = t9_timer_now_ns();
+        end_cycles = t9_timer_cycles();
+    } while (end_ns - start_ns < (uint64_t) T9_TIMER_CALIBRATION_MS * 1000000);
+
+    return (double) (end_cycles - start_cycles) / (double) (end_ns - start_ns);
+}
@@ -125,6 +125,7 @@ t9_corpus_tree_insert_ngrams(t9_corpus_tree_t *const tree,
     memset(ngram_buffer, 0, ngram_length + 1);
     ngram = ngram_buffer;
 
+    T9_PROFILE_BEGIN("insert_ngrams");
     offset = 0;
     // Create the first ngram.
     t9_corpus_ngram(corpus, ngram, ngram_length, &offset);
@@ -134,6 +135,12 @@ t9_corpus_tree_insert_ngrams(t9_corpus_tree_t *const tree,
         // Create a new ngram.
         t9_corpus_ngram(corpus, ngram, ngram_length, &offset);
     } while (offset != corpus->train_buffer_size);
+    T9_PROFILE_END();
+
+    // Remember the depth of the tree.
+    if (ngram_length > tree->ngram_length) {
+        tree->ngram_length = ngram_length;
+    }
 
     free(ngram_buffer);
     return T9_SUCCESS;
@@ -164,7 +171,45 @@ t9_corpus_tree_finalize(t9_corpus_tree_t *const tree) {
     root->probability = 0.0;
 
     // Recursively calculate node probabilities through the tree.
+    T9_PROFILE_BEGIN("finalize");
     t9_corpus_node_finalize(root);
+    T9_PROFILE_END();
+
+    t9_corpus_tree_fingerprint(tree);
+}
+
+void
+t9_corpus_tree_fingerprint(t9_corpus_tree_t *const tree) {
+    if (tree == NULL) {
+        return;
+    }
+
+    tree->number_nodes = 0;
+    tree->checksum = T9_CORPUS_TREE_HASH_OFFSET;
+    if (tree->root != NULL) {
+        __t9_corpus_tree_fingerprint_node(tree->root, tree);
+    }
+}
+
+void
+__t9_corpus_tree_fingerprint_node(const t9_corpus_node_t *const node,
+                                  t9_corpus_tree_t *const tree) {
+    uint64_t values[3];
+    const uint8_t *bytes;
+    size_t i;
+
+    values[0] = node->symbol;
+    values[1] = node->count;
+    values[2] = kv_size(node->children);
+    bytes = (const uint8_t *) values;
+    for (i = 0; i < sizeof(values); i++) {
+        tree->checksum = (tree->checksum ^ bytes[i]) * T9_CORPUS_TREE_HASH_PRIME;
+    }
+    tree->number_nodes++;
+
+    for (i = 0; i < kv_size(node->children); i++) {
+        __t9_corpus_tree_fingerprint_node(kv_A(node->children, i), tree);
+    }
 }
 
 /* ================================================================================== */
@@ -221,19 +266,64 @@ t9_search_tree_destroy(t9_search_tree_t *const tree) {
     free(tree);
 }
 
+t9_search_tree_t *
+t9_search_tree_clone(const t9_search_tree_t *const tree) {
+    t9_search_tree_t *clone;
+    list_iterator_t *iter;
+    list_node_t *list_node;
+    list_t *level_map_entry;
+    size_t i;
+
+    if (tree == NULL) {
+        return NULL;
+    }
+
+    clone = t9_search_tree_create();
+    if (clone == NULL) {
+        return NULL;
+    }
+
+    // Add the same levels, so that every copied node can be registered on its level.
+    for (i = 0; i < kv_size(tree->level_table2); i++) {
+        level_map_entry = list_new();
+        if (level_map_entry == NULL) {
+            t9_search_tree_destroy(clone);
+            return NULL;
+        }
+        kv_push(list_t *, clone->level_table2, level_map_entry);
+    }
+
+    // Copy the root node and all of its descendants.
+    clone->root->symbol = tree->root->symbol;
+    clone->root->probability = tree->root->probability;
+    clone->root->rescored = tree->root->rescored;
+    clone->root->is_rescored = tree->root->is_rescored;
+
+    iter = list_iterator_new(tree->root->children2, LIST_HEAD);
+    while ((list_node = list_iterator_next(iter)) != NULL) {
+        if (__t9_search_tree_clone_node(clone, clone->root, list_node_data(list_node), 0) != T9_SUCCESS) {
+            list_iterator_destroy(iter);
+            t9_search_tree_destroy(clone);
+            return NULL;
+        }
+    }
+    list_iterator_destroy(iter);
+
+    return clone;
+}
+
 t9_error_t
-t9_search_tree_type(t9_model_t *const model,
+t9_search_tree_type(t9_session_t *const session,
                     const t9_symbol_t *const sequence) {
     size_t i;
 
     const t9_symbol_t *symbol;
-    list_t *level_map_entry;
 
-    if (model == NULL) {
+    if (session == NULL) {
         return T9_FAILURE;
     }
 
-    if (model->search_tree == NULL || sequence == NULL) {
+    if (session->search_tree == NULL || sequence == NULL) {
         return T9_FAILURE;
     }
 
@@ -246,10 +336,11 @@ t9_search_tree_type(t9_model_t *const model,
     i = 0;
     while (*symbol != 0) {
         // Add a new search tree table entry for the new level.
-        level_map_entry = list_new();
-        kv_push(list_t *, model->search_tree->level_table2, level_map_entry);
+        if (__t9_session_level_push(session) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
         // Type symbol.
-        if (t9_search_tree_insert(model, *symbol) != T9_SUCCESS) {
+        if (t9_search_tree_insert(session, *symbol, 0.0, NULL) != T9_SUCCESS) {
             return T9_FAILURE;
         }
         symbol++;
@@ -259,57 +350,558 @@ t9_search_tree_type(t9_model_t *const model,
 }
 
 t9_error_t
-t9_search_tree_insert(t9_model_t *const model,
-                      t9_symbol_t symbol) {
+t9_search_tree_insert(t9_session_t *const session,
+                      t9_symbol_t symbol,
+                      double budget_ms,
+                      bool *const truncated) {
     t9_error_t error;
+    uint64_t start;
 
-    error = t9_search_node_insert(model->search_tree->root, symbol, (const t9_symbol_t *const) "", 0, model);
-    if (error != T9_SUCCESS) {
-        return T9_FAILURE;
+    T9_PROFILE_BEGIN("search_tree_insert");
+    if (session->metrics == NULL) {
+        error = __t9_search_tree_insert(session, symbol, budget_ms, truncated);
+        T9_PROFILE_END();
+        return error;
+    }
+
+    start = t9_timer_now_ns();
+    error = __t9_search_tree_insert(session, symbol, budget_ms, truncated);
+    t9_metrics_record(session->metrics, T9_METRICS_INSERT, t9_timer_now_ns() - start);
+    if (kv_size(session->search_tree->level_table2) > 0) {
+        t9_metrics_record(session->metrics, T9_METRICS_BEAM, list_size(kv_last(session->search_tree->level_table2)));
+    }
+    t9_metrics_add(session->metrics, T9_METRICS_KEYS, 1);
+
+    T9_PROFILE_END();
+    return error;
+}
+
+t9_error_t
+__t9_search_tree_insert(t9_session_t *const session,
+                        t9_symbol_t symbol,
+                        double budget_ms,
+                        bool *const truncated) {
+    t9_search_node_t **leaves;
+    list_node_t *list_node;
+    size_t count;
+    size_t depth;
+    size_t i;
+    double deadline;
+
+    if (truncated != NULL) {
+        *truncated = false;
+    }
+
+    // The new leaves are placed on the last level, the leaves to be expanded are on the level above it.
+    depth = kv_size(session->search_tree->level_table2) - 1;
+    if (depth == 0) {
+        // The first key expands the root.
+        if (t9_search_node_expand(session->search_tree->root, symbol, 0, session) != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+        return t9_search_tree_update(session);
+    }
+
+    // The leaves are collected in a buffer of the session, expanding them appends to the level below.
+    kv_size(session->leaves) = 0;
+    for (list_node = kv_A(session->search_tree->level_table2, depth - 1)->head; list_node != NULL;
+         list_node = list_node->next) {
+        kv_push(t9_search_node_t *, session->leaves, list_node_data(list_node));
+    }
+    leaves = session->leaves.a;
+    count = kv_size(session->leaves);
+
+    // With a time budget the most promising leaves are expanded first. Half of the budget is left for pruning the
+    // remaining leaves and searching the best paths.
+    deadline = 0.0;
+    if (budget_ms > 0.0) {
+        deadline = t9_timer_now_ms() + budget_ms * T9_SEARCH_TREE_EXPANSION_BUDGET;
+        qsort(leaves, count, sizeof(t9_search_node_t *), __t9_search_tree_compare_nodes);
+    }
+
+    T9_PROFILE_BEGIN("expand");
+    for (i = 0; i < count; i++) {
+        if (i > 0 && budget_ms > 0.0 && t9_timer_now_ms() > deadline) {
+            break;
+        }
+        if (t9_search_node_expand(leaves[i], symbol, depth, session) != T9_SUCCESS) {
+            T9_PROFILE_END();
+            return T9_FAILURE;
+        }
+    }
+    T9_PROFILE_END();
+
+    // Leaves that were not expanded in time can not be continued.
+    if (i < count && truncated != NULL) {
+        *truncated = true;
+    }
+    for (; i < count; i++) {
+        t9_session_prune_leaf(session, leaves[i], depth - 1);
+    }
+
+    return t9_search_tree_update(session);
+}
+
+t9_error_t
+t9_search_tree_update(t9_session_t *const session) {
+    t9_error_t error;
+
+    if (session->model->paths_per_context > 0) {
+        T9_PROFILE_BEGIN("recombine");
+        error = t9_search_tree_recombine(session);
+        T9_PROFILE_END();
+        if (error != T9_SUCCESS) {
+            return T9_FAILURE;
+        }
+    }
+    if (session->model->beam_threshold > 0.0f) {
+        T9_PROFILE_BEGIN("threshold");
+        t9_search_tree_threshold(session);
+        T9_PROFILE_END();
+    }
+    T9_PROFILE_BEGIN("search_paths");
+    t9_search_tree_search_paths(session);
+    T9_PROFILE_END();
+    if (session->model->rescore_length > 0) {
+        T9_PROFILE_BEGIN("rescore");
+        t9_search_tree_rescore(session);
+        T9_PROFILE_END();
+    }
+    T9_PROFILE_BEGIN("prune");
+    t9_search_tree_prune(session);
+    T9_PROFILE_END();
+    if (session->output != NULL) {
+        T9_PROFILE_BEGIN("commit");
+        t9_search_tree_commit(session);
+        T9_PROFILE_END();
     }
-    t9_search_tree_search_paths(model);
-    t9_search_tree_prune(model);
 
     return T9_SUCCESS;
 }
 
+int
+__t9_search_tree_compare_nodes(const void *a,
+                               const void *b) {
+    const t9_search_node_t *node_a;
+    const t9_search_node_t *node_b;
+
+    node_a = *(const t9_search_node_t *const *) a;
+    node_b = *(const t9_search_node_t *const *) b;
+    if (node_a->probability < node_b->probability) {
+        return -1;
+    }
+    if (node_a->probability > node_b->probability) {
+        return 1;
+    }
+    return 0;
+}
+
 void
-t9_search_tree_prune(t9_model_t *const model) {
+t9_search_tree_prune(t9_session_t *const session) {
     t9_path_t *path;
     size_t tree_depth;
+    uint64_t start;
 
-    if (model->ngram_length < 1) {
+    if (session->model->ngram_length < 1) {
         // No need for pruning.
         return;
     }
 
-    tree_depth = kv_size(model->search_tree->level_table2);
-    if (tree_depth < model->ngram_length) {
+    tree_depth = kv_size(session->search_tree->level_table2);
+    if (tree_depth < session->model->ngram_length) {
         // Wait until the tree is as deep as the ngram length before pruning.
         return;
     }
 
-    path = t9_path_create();
+    start = session->metrics != NULL ? t9_timer_now_ns() : 0;
+
+    path = __t9_session_path_new(session);
+    if (path == NULL) {
+        return;
+    }
     // Prune the tree starting at the root node.
-    t9_search_node_prune(model->search_tree->root, model, path);
-    t9_path_destroy(path);
+    t9_search_node_prune(session->search_tree->root, session, path);
+    __t9_session_path_release(session, path);
+
+    if (session->metrics != NULL) {
+        t9_metrics_record(session->metrics, T9_METRICS_PRUNE, t9_timer_now_ns() - start);
+    }
+}
+
+t9_error_t
+t9_search_tree_recombine(t9_session_t *const session) {
+    t9_search_tree_hypothesis_t *hypotheses;
+    t9_symbol_t *contexts;
+    size_t *groups;
+    uint8_t *scratch;
+    list_t *leaves;
+    list_node_t *list_node;
+    size_t context_length;
+    size_t number_groups;
+    size_t count;
+    size_t depth;
+    size_t size;
+    size_t hash;
+    size_t slot;
+    size_t i;
+    size_t j;
+
+    if (kv_size(session->search_tree->level_table2) == 0) {
+        return T9_SUCCESS;
+    }
+
+    // The leaves are the nodes on the deepest level.
+    depth = kv_size(session->search_tree->level_table2) - 1;
+    leaves = kv_A(session->search_tree->level_table2, depth);
+    count = list_size(leaves);
+
+    // As long as the tree is not deeper than the context, every leaf has a context of its own.
+    context_length = session->model->ngram_length;
+    if (session->model->rescore_length > context_length) {
+        context_length = session->model->rescore_length;
+    }
+    context_length = context_length > 1 ? context_length - 1 : 0;
+    if (count <= session->model->paths_per_context || depth < context_length) {
+        return T9_SUCCESS;
+    }
+
+    // Open addressing table of group heads with at least twice as many slots as leaves.
+    number_groups = 1;
+    while (number_groups < 2 * count) {
+        number_groups <<= 1;
+    }
+
+    // The hypotheses, the group heads and the contexts share the scratch buffer of the session.
+    size = count * sizeof(t9_search_tree_hypothesis_t) + number_groups * sizeof(size_t) + count * context_length + 1;
+    if (kv_max(session->scratch) < size) {
+        scratch = (uint8_t *) realloc(session->scratch.a, size);
+        if (scratch == NULL) {
+            return T9_FAILURE;
+        }
+        session->scratch.a = scratch;
+        kv_max(session->scratch) = size;
+    }
+    hypotheses = (t9_search_tree_hypothesis_t *) session->scratch.a;
+    groups = (size_t *) &hypotheses[count];
+    contexts = (t9_symbol_t *) &groups[number_groups];
+    memset(groups, 0xff, number_groups * sizeof(size_t));
+
+    // Group leaves by their context.
+    i = 0;
+    for (list_node = leaves->head; list_node != NULL; list_node = list_node->next) {
+        hypotheses[i].node = list_node_data(list_node);
+        hypotheses[i].context = &contexts[i * context_length];
+        hypotheses[i].length = t9_search_node_context(hypotheses[i].node, context_length,
+                                                      &contexts[i * context_length]);
+        hypotheses[i].next = SIZE_MAX;
+        hypotheses[i].kept = false;
+
+        // FNV-1a hash of the context.
+        hash = 2166136261u;
+        for (j = 0; j < hypotheses[i].length; j++) {
+            hash = (hash ^ hypotheses[i].context[j]) * 16777619u;
+        }
+
+        // Find the group of the context or start a new one.
+        slot = hash & (number_groups - 1);
+        while (groups[slot] != SIZE_MAX
+               && (hypotheses[groups[slot]].length != hypotheses[i].length
+                   || memcmp(hypotheses[groups[slot]].context, hypotheses[i].context, hypotheses[i].length) != 0)) {
+            slot = (slot + 1) & (number_groups - 1);
+        }
+        hypotheses[i].next = groups[slot];
+        groups[slot] = i;
+        i++;
+    }
+
+    // Select the best leaves of every group.
+    for (slot = 0; slot < number_groups; slot++) {
+        if (groups[slot] != SIZE_MAX) {
+            __t9_search_tree_recombine_group(session, hypotheses, groups[slot]);
+        }
+    }
+
+    // Prune all other leaves. Pruning in tree order keeps the memory access pattern sequential.
+    for (i = 0; i < count; i++) {
+        if (hypotheses[i].kept == false) {
+            t9_session_prune_leaf(session, hypotheses[i].node, depth);
+        }
+    }
+
+    return T9_SUCCESS;
+}
+
+void
+t9_search_tree_rescore(t9_session_t *const session) {
+    t9_search_node_t *leaf;
+    t9_path_t *path;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < kv_size(session->paths); i++) {
+        path = kv_A(session->paths, i);
+        if (kv_size(path->nodes) == 0) {
+            continue;
+        }
+
+        leaf = kv_last(path->nodes);
+        __t9_search_tree_rescore_node(session, leaf);
+        path->probability = leaf->rescored;
+    }
+
+    // Sort the paths by their rescored score, the best path first.
+    for (i = 1; i < kv_size(session->paths); i++) {
+        path = kv_A(session->paths, i);
+        for (j = i; j > 0 && kv_A(session->paths, j - 1)->probability > path->probability; j--) {
+            kv_A(session->paths, j) = kv_A(session->paths, j - 1);
+        }
+        kv_A(session->paths, j) = path;
+    }
+
+    // Only the best rescored paths survive.
+    while (session->model->rescore_paths > 0 && kv_size(session->paths) > session->model->rescore_paths) {
+        __t9_session_path_release(session, kv_pop(session->paths));
+    }
+}
+
+void
+__t9_search_tree_rescore_node(const t9_session_t *const session,
+                              t9_search_node_t *const node) {
+    t9_search_node_t *parent;
+    double cost;
+
+    // The root is the start of every path.
+    parent = node->parent;
+    if (node->is_rescored == true || parent == NULL) {
+        return;
+    }
+    __t9_search_tree_rescore_node(session, parent);
+
+    // Exchange the language model cost of the first pass for the one of the second pass.
+    cost = (double) t9_search_node_cost(node, session->model->corpus_tree, session->model->rescore_length)
+           - (double) t9_search_node_cost(node, session->model->corpus_tree, session->model->ngram_length);
+    node->rescored = parent->rescored + (node->probability - parent->probability) + t9_score_round(cost);
+    node->is_rescored = true;
+}
+
+void
+t9_search_tree_threshold(t9_session_t *const session) {
+    list_t *leaves;
+    list_node_t *list_node;
+    list_node_t *next;
+    t9_search_node_t *node;
+    size_t depth;
+    double limit;
+
+    if (kv_size(session->search_tree->level_table2) == 0) {
+        return;
+    }
+
+    // The leaves are the nodes on the deepest level.
+    depth = kv_size(session->search_tree->level_table2) - 1;
+    leaves = kv_A(session->search_tree->level_table2, depth);
+    if (list_size(leaves) <= 1) {
+        return;
+    }
+
+    // Find the score of the best leaf.
+    limit = ((t9_search_node_t *) leaves->head->val)->probability;
+    for (list_node = leaves->head; list_node != NULL; list_node = list_node->next) {
+        node = list_node_data(list_node);
+        if (node->probability < limit) {
+            limit = node->probability;
+        }
+    }
+    limit += t9_score_round(session->model->beam_threshold);
+
+    // Prune all leaves outside the threshold. Pruning a leaf removes it from the level list, so the next list entry
+    // is fetched beforehand.
+    list_node = leaves->head;
+    while (list_node != NULL) {
+        next = list_node->next;
+        node = list_node_data(list_node);
+        if (node->probability > limit) {
+            t9_session_prune_leaf(session, node, depth);
+        }
+        list_node = next;
+    }
 }
 
 void
-t9_search_tree_search_paths(t9_model_t *const model) {
+__t9_search_tree_recombine_group(const t9_session_t *const session,
+                                 t9_search_tree_hypothesis_t *const hypotheses,
+                                 size_t head) {
+    size_t best;
+    size_t kept;
+    size_t i;
+
+    // Select the most probable (lowest negative log probability) leaves one after another.
+    for (kept = 0; kept < session->model->paths_per_context; kept++) {
+        best = SIZE_MAX;
+        for (i = head; i != SIZE_MAX; i = hypotheses[i].next) {
+            if (hypotheses[i].kept == false
+                && (best == SIZE_MAX || hypotheses[i].node->probability < hypotheses[best].node->probability)) {
+                best = i;
+            }
+        }
+        if (best == SIZE_MAX) {
+            // The group has less members than may be kept.
+            return;
+        }
+        hypotheses[best].kept = true;
+    }
+}
+
+void
+t9_search_tree_search_paths(t9_session_t *const session) {
     size_t i;
     t9_path_t *tmp_path;
+    uint64_t start;
 
-    // Delete existing paths.
-    for (i = 0; i < kv_size(model->paths); i++) {
-        t9_path_destroy(kv_A(model->paths, i));
+    start = session->metrics != NULL ? t9_timer_now_ns() : 0;
+
+    // Release existing paths.
+    for (i = 0; i < kv_size(session->paths); i++) {
+        __t9_session_path_release(session, kv_A(session->paths, i));
     }
-    // Reinitialize list of best paths.
-    kv_destroy(model->paths);
-    kv_init(model->paths);
+    kv_size(session->paths) = 0;
 
-    tmp_path = t9_path_create();
+    tmp_path = __t9_session_path_new(session);
+    if (tmp_path == NULL) {
+        return;
+    }
     // Search best path in the search tree.
-    t9_node_search_paths(model->search_tree->root, model, tmp_path);
-    t9_path_destroy(tmp_path);
+    t9_node_search_paths(session->search_tree->root, session, tmp_path);
+    __t9_session_path_release(session, tmp_path);
+
+    if (session->metrics != NULL) {
+        t9_metrics_record(session->metrics, T9_METRICS_SEARCH, t9_timer_now_ns() - start);
+        t9_metrics_add(session->metrics, T9_METRICS_PATHS, kv_size(session->paths));
+    }
+}
+
+void
+t9_search_tree_commit(t9_session_t *const session) {
+    t9_search_tree_t *tree;
+    t9_search_node_t *root;
+    t9_search_node_t *child;
+    list_node_t *list_node;
+    t9_symbol_t symbols[T9_SEARCH_TREE_COMMIT_LENGTH];
+    size_t context_length;
+    size_t length;
+    size_t i;
+    double offset;
+    double rescored_offset;
+
+    tree = session->search_tree;
+
+    // The levels below the root have to hold the context of both passes, otherwise rescoring falls back to a shorter
+    // context once symbols are committed.
+    context_length = session->model->ngram_length;
+    if (session->model->rescore_length > context_length) {
+        context_length = session->model->rescore_length;
+    }
+    context_length = context_length > 1 ? context_length - 1 : 0;
+
+    // Nodes are rescored once a path through them is. The root is not part of any context, so every node has to be
+    // rescored before its ancestors are committed.
+    if (session->model->rescore_length > 0 && list_size(tree->root->children2) == 1
+        && kv_size(tree->level_table2) > context_length + 1) {
+        for (list_node = kv_last(tree->level_table2)->head; list_node != NULL; list_node = list_node->next) {
+            __t9_search_tree_rescore_node(session, list_node_data(list_node));
+        }
+    }
+
+    length = 0;
+    while (list_size(tree->root->children2) == 1 && kv_size(tree->level_table2) > context_length + 1) {
+        root = tree->root;
+        child = list_node_data(root->children2->head);
+
+        // Detach the child and release the old root.
+        __t9_session_entry_release(session, root->children2, root->children2->head);
+        __t9_session_node_release(session, root);
+        child->parent = NULL;
+        child->level_entry = NULL;
+        tree->root = child;
+
+        // The first level now only consists of the root.
+        __t9_session_level_release(session, kv_A(tree->level_table2, 0));
+        memmove(tree->level_table2.a, tree->level_table2.a + 1,
+                (kv_size(tree->level_table2) - 1) * sizeof(list_t *));
+        kv_size(tree->level_table2)--;
+
+        // The paths start below the new root.
+        for (i = 0; i < kv_size(session->paths); i++) {
+            t9_path_shift(kv_A(session->paths, i));
+        }
+
+        symbols[length++] = child->symbol;
+        if (length == T9_SEARCH_TREE_COMMIT_LENGTH) {
+            session->output(symbols, length, session->output_arg);
+            session->committed += length;
+            length = 0;
+        }
+    }
+
+    if (length > 0) {
+        session->output(symbols, length, session->output_arg);
+        session->committed += length;
+    }
+
+    // Rebase all scores on the root.
+    offset = tree->root->probability;
+    rescored_offset = tree->root->rescored;
+    if (offset == 0.0 && rescored_offset == 0.0) {
+        return;
+    }
+    tree->root->probability = 0.0;
+    tree->root->rescored = 0.0;
+    for (i = 0; i < kv_size(tree->level_table2); i++) {
+        for (list_node = kv_A(tree->level_table2, i)->head; list_node != NULL; list_node = list_node->next) {
+            ((t9_search_node_t *) list_node_data(list_node))->probability -= offset;
+            ((t9_search_node_t *) list_node_data(list_node))->rescored -= rescored_offset;
+        }
+    }
+    for (i = 0; i < kv_size(session->paths); i++) {
+        kv_A(session->paths, i)->probability -= session->model->rescore_length > 0 ? rescored_offset : offset;
+    }
+}
+
+t9_error_t
+__t9_search_tree_clone_node(t9_search_tree_t *const tree,
+                            t9_search_node_t *const parent,
+                            const t9_search_node_t *const node,
+                            size_t depth) {
+    t9_search_node_t *copy;
+    list_iterator_t *iter;
+    list_node_t *list_node;
+    t9_error_t error;
+
+    if (depth >= kv_size(tree->level_table2)) {
+        return T9_FAILURE;
+    }
+
+    copy = t9_search_node_create();
+    if (copy == NULL) {
+        return T9_FAILURE;
+    }
+    copy->symbol = node->symbol;
+    copy->probability = node->probability;
+    copy->rescored = node->rescored;
+    copy->is_rescored = node->is_rescored;
+    copy->parent = parent;
+
+    // Register the copy with its parent and its level.
+    t9_search_node_add_child(parent, copy);
+    copy->level_entry = list_rpush(kv_A(tree->level_table2, depth), list_node_new(copy));
+
+    // Copy all descendants.
+    error = T9_SUCCESS;
+    iter = list_iterator_new(node->children2, LIST_HEAD);
+    while (error == T9_SUCCESS && (list_node = list_iterator_next(iter)) != NULL) {
+        error = __t9_search_tree_clone_node(tree, copy, list_node_data(list_node), depth + 1);
+    }
+    list_iterator_destroy(iter);
+
+    return error;
 }
@@ -0,0 +1,471 @@
+/*!
+  ******************************************************************************
+  * @file    viterbi.c
+  * @author  Yves-Noel Weweler <y.weweler@fh-muenster.de>
+  * @version V1.0.0
+  * @brief   This file implements exact Viterbi decoding over the context states of a corpus tree.
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2017 Yves-Noel Weweler
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+#include "t9/viterbi.h"
+
+t9_viterbi_t *
+t9_viterbi_compile(const t9_corpus_tree_t *const tree,
+                   uint8_t ngram_length) {
+    t9_viterbi_t *viterbi;
+    t9_corpus_node_vector_t nodes;
+    const t9_corpus_node_t **table;
+    const t9_corpus_node_t *node;
+    const t9_corpus_node_t *next;
+    uint32_t *ids;
+    kvec_vdepth_t(uint8_t) depths;
+    t9_symbol_t context[UINT8_MAX + 1];
+    const t9_symbol_t *symbol;
+    size_t context_length;
+    size_t number_nodes;
+    size_t number_backoffs;
+    size_t table_size;
+    size_t state;
+    size_t length;
+    size_t suffix;
+    size_t index;
+    size_t i;
+    size_t k;
+    bool full;
+    float probability;
+
+    if (tree == NULL || tree->root == NULL || ngram_length < 1) {
+        return NULL;
+    }
+
+    context_length = (size_t) (ngram_length - 1);
+
+    // Collect all nodes a context can end in, level by level. Nodes that are shallower than a complete context come
+    // first, only they can be backoff states.
+    kv_init(nodes);
+    kv_init(depths);
+    kv_push(t9_corpus_node_t *, nodes, tree->root);
+    kv_push(uint8_t, depths, 0);
+    number_backoffs = 0;
+    for (i = 0; i < kv_size(nodes); i++) {
+        if (kv_A(depths, i) >= context_length) {
+            continue;
+        }
+        number_backoffs++;
+        node = kv_A(nodes, i);
+        for (k = 0; k < kv_size(node->children); k++) {
+            kv_push(t9_corpus_node_t *, nodes, kv_A(node->children, k));
+            kv_push(uint8_t, depths, (uint8_t) (kv_A(depths, i) + 1));
+        }
+    }
+    number_nodes = kv_size(nodes);
+
+    // Build a table to find the index of a node.
+    table_size = 1;
+    while (table_size < 2 * number_nodes) {
+        table_size <<= 1;
+    }
+    table = (const t9_corpus_node_t **) calloc(table_size, sizeof(t9_corpus_node_t *));
+    ids = (uint32_t *) calloc(table_size, sizeof(uint32_t));
+
+    // Allocate memory.
+    viterbi = (t9_viterbi_t *) malloc(sizeof(t9_viterbi_t));
+    if (viterbi == NULL || table == NULL || ids == NULL) {
+        free(viterbi);
+        free(table);
+        free(ids);
+        kv_destroy(depths);
+        kv_destroy(nodes);
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(viterbi, 0, sizeof(t9_viterbi_t));
+    viterbi->ngram_length = ngram_length;
+    viterbi->number_states = number_nodes + number_backoffs;
+    viterbi->transitions = (uint32_t *) malloc(viterbi->number_states * NUM_CORPUS_SYMBOLS * sizeof(uint32_t));
+    viterbi->costs = (float *) malloc(viterbi->number_states * NUM_CORPUS_SYMBOLS * sizeof(float));
+    if (viterbi->transitions == NULL || viterbi->costs == NULL) {
+        t9_viterbi_destroy(viterbi);
+        free(table);
+        free(ids);
+        kv_destroy(depths);
+        kv_destroy(nodes);
+        return NULL;
+    }
+
+    for (i = 0; i < number_nodes; i++) {
+        index = __t9_viterbi_node_slot(table, table_size, kv_A(nodes, i));
+        table[index] = kv_A(nodes, i);
+        ids[index] = (uint32_t) i;
+    }
+
+    // Emission probabilities of all corpus symbols for every key.
+    symbol = (const t9_symbol_t *) CORPUS_SYMBOLS;
+    for (k = 0; k < NUM_CORPUS_SYMBOLS; k++) {
+        viterbi->symbols[k] = symbol[k];
+        for (i = 0; i < NUM_LEXICON_SYMBOLS; i++) {
+            viterbi->emissions[i][k] = -t9_ln(t9_corpus_tree_button_for_letter(LEXICON_SYMBOLS[i], symbol[k]));
+        }
+    }
+
+    for (k = 0; k < NUM_CORPUS_SYMBOLS; k++) {
+        viterbi->minimal_costs[k] = -t9_ln(0.0f);
+    }
+
+    // States [0, number_nodes) are complete contexts, states [number_nodes, number_states) are backoff states.
+    for (state = 0; state < viterbi->number_states; state++) {
+        full = state < number_nodes;
+        i = full ? state : state - number_nodes;
+        node = kv_A(nodes, i);
+
+        // Reconstruct the context of the state.
+        length = kv_A(depths, i);
+        for (next = node, k = length; k > 0; k--, next = next->parent) {
+            context[k - 1] = next->symbol;
+        }
+
+        for (k = 0; k < NUM_CORPUS_SYMBOLS; k++) {
+            // A symbol only has a probability if the whole context is known.
+            probability = 0.0f;
+            if (full) {
+                next = t9_corpus_node_get_child(node, viterbi->symbols[k]);
+                probability = next != NULL ? next->probability : 0.0f;
+            }
+            viterbi->costs[state * NUM_CORPUS_SYMBOLS + k] = -t9_ln(probability);
+            if (viterbi->costs[state * NUM_CORPUS_SYMBOLS + k] < viterbi->minimal_costs[k]) {
+                viterbi->minimal_costs[k] = viterbi->costs[state * NUM_CORPUS_SYMBOLS + k];
+            }
+
+            // The next context consists of the last (ngram_length - 1) symbols, its state is its longest suffix
+            // contained in the tree.
+            context[length] = viterbi->symbols[k];
+            index = length + 1 > context_length ? length + 1 - context_length : 0;
+            for (suffix = index; suffix <= length + 1; suffix++) {
+                next = t9_corpus_node_descend(tree->root, context + suffix, length + 1 - suffix);
+                if (next != NULL) {
+                    break;
+                }
+            }
+            i = ids[__t9_viterbi_node_slot(table, table_size, next)];
+            if (suffix == index && (full || length + 1 - suffix == context_length)) {
+                viterbi->transitions[state * NUM_CORPUS_SYMBOLS + k] = (uint32_t) i;
+            } else {
+                viterbi->transitions[state * NUM_CORPUS_SYMBOLS + k] = (uint32_t) (number_nodes + i);
+            }
+        }
+    }
+
+    free(table);
+    free(ids);
+    kv_destroy(depths);
+    kv_destroy(nodes);
+
+    return viterbi;
+}
+
+void
+t9_viterbi_destroy(t9_viterbi_t *const viterbi) {
+    if (viterbi == NULL) {
+        return;
+    }
+
+    free(viterbi->transitions);
+    free(viterbi->costs);
+
+    // Erase and free memory.
+    memset(viterbi, 0, sizeof(t9_viterbi_t));
+    free(viterbi);
+}
+
+t9_viterbi_lattice_t *
+t9_viterbi_lattice_create(const t9_viterbi_t *const viterbi) {
+    t9_viterbi_lattice_t *lattice;
+    size_t i;
+
+    if (viterbi == NULL) {
+        return NULL;
+    }
+
+    // Allocate memory.
+    lattice = (t9_viterbi_lattice_t *) malloc(sizeof(t9_viterbi_lattice_t));
+    if (lattice == NULL) {
+        return NULL;
+    }
+
+    // Erase memory.
+    memset(lattice, 0, sizeof(t9_viterbi_lattice_t));
+    lattice->viterbi = viterbi;
+    kv_init(lattice->entries);
+
+    // No state has an entry yet.
+    lattice->slots = (uint32_t *) malloc(viterbi->number_states * sizeof(uint32_t));
+    if (lattice->slots == NULL) {
+        t9_viterbi_lattice_destroy(lattice);
+        return NULL;
+    }
+    for (i = 0; i < viterbi->number_states; i++) {
+        lattice->slots[i] = T9_VITERBI_NO_ENTRY;
+    }
+
+    if (t9_viterbi_lattice_reset(lattice) != T9_SUCCESS) {
+        t9_viterbi_lattice_destroy(lattice);
+        return NULL;
+    }
+
+    return lattice;
+}
+
+void
+t9_viterbi_lattice_destroy(t9_viterbi_lattice_t *const lattice) {
+    if (lattice == NULL) {
+        return;
+    }
+
+    kv_destroy(lattice->entries);
+    free(lattice->slots);
+
+    // Erase and free memory.
+    memset(lattice, 0, sizeof(t9_viterbi_lattice_t));
+    free(lattice);
+}
+
+t9_viterbi_lattice_t *
+t9_viterbi_lattice_clone(const t9_viterbi_lattice_t *const lattice) {
+    t9_viterbi_lattice_t *clone;
+
+    if (lattice == NULL) {
+        return NULL;
+    }
+
+    clone = t9_viterbi_lattice_create(lattice->viterbi);
+    if (clone == NULL) {
+        return NULL;
+    }
+
+    // The slots are only used during an insertion, all other state is held by the entries.
+    kv_copy(t9_viterbi_entry_t, clone->entries, lattice->entries);
+    clone->column = lattice->column;
+    clone->length = lattice->length;
+
+    return clone;
+}
+
+t9_error_t
+t9_viterbi_lattice_reset(t9_viterbi_lattice_t *const lattice) {
+    t9_viterbi_entry_t start;
+
+    if (lattice == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Every sequence starts with an empty context.
+    memset(&start, 0, sizeof(t9_viterbi_entry_t));
+    start.state = 0;
+    start.previous = T9_VITERBI_NO_ENTRY;
+    start.probability = 0.0f;
+
+    kv_size(lattice->entries) = 0;
+    kv_push(t9_viterbi_entry_t, lattice->entries, start);
+    lattice->column = 0;
+    lattice->length = 0;
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_viterbi_lattice_insert(t9_viterbi_lattice_t *const lattice,
+                          t9_symbol_t symbol) {
+    const t9_viterbi_t *viterbi;
+    const char *key;
+    const float *emissions;
+    t9_viterbi_entry_t entry;
+    t9_viterbi_entry_t *slot;
+    size_t begin;
+    size_t end;
+    size_t row;
+    size_t i;
+    size_t k;
+    uint32_t next;
+    float probability;
+
+    if (lattice == NULL) {
+        return T9_FAILURE;
+    }
+
+    key = t9_corpus_validate_lexicon_symbol(symbol) ? strchr(LEXICON_SYMBOLS, symbol) : NULL;
+    if (key == NULL) {
+        return T9_FAILURE;
+    }
+
+    viterbi = lattice->viterbi;
+    emissions = viterbi->emissions[key - LEXICON_SYMBOLS];
+
+    // Extend the best hypothesis of every state by every corpus symbol and keep the best one per next state.
+    T9_PROFILE_BEGIN("viterbi_insert");
+    begin = lattice->column;
+    end = kv_size(lattice->entries);
+    for (i = begin; i < end; i++) {
+        entry = kv_A(lattice->entries, i);
+        row = entry.state * NUM_CORPUS_SYMBOLS;
+        for (k = 0; k < NUM_CORPUS_SYMBOLS; k++) {
+            next = viterbi->transitions[row + k];
+            probability = emissions[k] + viterbi->costs[row + k] + entry.probability;
+
+            if (lattice->slots[next] == T9_VITERBI_NO_ENTRY) {
+                lattice->slots[next] = (uint32_t) kv_size(lattice->entries);
+                slot = (kv_pushp(t9_viterbi_entry_t, lattice->entries));
+                slot->state = next;
+            } else {
+                slot = &kv_A(lattice->entries, lattice->slots[next]);
+                if (probability >= slot->probability) {
+                    continue;
+                }
+            }
+            slot->previous = (uint32_t) i;
+            slot->probability = probability;
+            slot->symbol = viterbi->symbols[k];
+        }
+    }
+
+    // Release the slots for the next key.
+    for (i = end; i < kv_size(lattice->entries); i++) {
+        lattice->slots[kv_A(lattice->entries, i).state] = T9_VITERBI_NO_ENTRY;
+    }
+
+    lattice->column = end;
+    lattice->length++;
+    T9_PROFILE_END();
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_viterbi_lattice_suggestion(const t9_viterbi_lattice_t *const lattice,
+                              t9_symbol_t **suggestion) {
+    size_t best;
+    size_t i;
+
+    if (lattice == NULL || suggestion == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Nothing was typed yet.
+    if (lattice->length == 0) {
+        return T9_FAILURE;
+    }
+
+    // Find the best hypothesis of the last key.
+    best = lattice->column;
+    for (i = lattice->column; i < kv_size(lattice->entries); i++) {
+        if (kv_A(lattice->entries, i).probability < kv_A(lattice->entries, best).probability) {
+            best = i;
+        }
+    }
+
+    *suggestion = (t9_symbol_t *) malloc(lattice->length + 1);
+    if (*suggestion == NULL) {
+        return T9_FAILURE;
+    }
+    __t9_viterbi_lattice_trace(lattice, best, *suggestion);
+
+    return T9_SUCCESS;
+}
+
+t9_error_t
+t9_viterbi_lattice_nbest(const t9_viterbi_lattice_t *const lattice,
+                         t9_symbol_t *const suggestions,
+                         size_t stride,
+                         float *const scores,
+                         size_t capacity,
+                         size_t *const count) {
+    float probability;
+    size_t position;
+    size_t i;
+
+    if (lattice == NULL || suggestions == NULL || scores == NULL || count == NULL) {
+        return T9_FAILURE;
+    }
+
+    // Nothing was typed yet.
+    if (lattice->length == 0 || stride < lattice->length + 1) {
+        return T9_FAILURE;
+    }
+
+    // Keep the best hypotheses of the last key sorted by insertion, the worst one drops out once all rows are used.
+    *count = 0;
+    for (i = lattice->column; i < kv_size(lattice->entries) && capacity > 0; i++) {
+        probability = kv_A(lattice->entries, i).probability;
+        if (*count == capacity && probability >= scores[capacity - 1]) {
+            continue;
+        }
+
+        position = *count < capacity ? *count : capacity - 1;
+        while (position > 0 && scores[position - 1] > probability) {
+            memcpy(&suggestions[position * stride], &suggestions[(position - 1) * stride], lattice->length + 1);
+            scores[position] = scores[position - 1];
+            position--;
+        }
+        if (*count < capacity) {
+            (*count)++;
+        }
+
+        scores[position] = probability;
+        __t9_viterbi_lattice_trace(lattice, i, &suggestions[position * stride]);
+    }
+
+    return T9_SUCCESS;
+}
+
+void
+__t9_viterbi_lattice_trace(const t9_viterbi_lattice_t *const lattice,
+                           size_t entry,
+                           t9_symbol_t *const suggestion) {
+    size_t i;
+
+    // Follow the hypothesis back to the start entry, which does not carry a symbol.
+    suggestion[lattice->length] = 0;
+    for (i = lattice->length; i > 0; i--) {
+        suggestion[i - 1] = kv_A(lattice->entries, entry).symbol;
+        entry = kv_A(lattice->entries, entry).previous;
+    }
+}
+
+size_t
+__t9_viterbi_node_slot(const t9_corpus_node_t *const *const table,
+                       size_t size,
+                       const t9_corpus_node_t *const node) {
+    size_t slot;
+
+    slot = (size_t) (((uintptr_t) node >> 4) * 0x9E3779B97F4A7C15ULL) & (size - 1);
+    while (table[slot] != NULL && table[slot] != node) {
+        slot = (slot + 1) & (size - 1);
+    }
+
+    return slot;
+}